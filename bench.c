@@ -0,0 +1,1637 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "multi_partition.h"
+#include "mp_append.h"
+#include "mp_async.h"
+#include "mp_gen.h"
+#include "mp_sort.h"
+#include "mp_stream.h"
+#include "mp_verify.h"
+#include "splitter_index.h"
+#include "util.h"
+#include "chrono.h"
+
+#define BENCH_NP 1000
+#define BENCH_ITERS 200
+#define BENCH_SCATTER_N 4000000
+#define BENCH_SCATTER_ITERS 5
+
+/**
+ * Mede a latência por chamada de `multi_partition` para n pequeno.
+ *
+ * - pool:    workers reaproveitados entre as chamadas (comportamento atual).
+ * - respawn: os workers do plano são recriados após cada chamada
+ *            (`multi_partition_restart_workers`), forçando criação e join das
+ *            threads a cada chamada (comportamento anterior ao pool); buffers,
+ *            índice e arena do plano são mantidos.
+ */
+static double bench_latency_us(long long *Input, long long n, long long *P, int np, long long *Output, long long *Pos, int nThreads, int respawn)
+{
+    chronometer_t chrono;
+
+    // Aquecimento
+    multi_partition(Input, n, P, np, Output, Pos, nThreads);
+    if (respawn)
+    {
+        multi_partition_restart_workers();
+    }
+
+    chrono_reset(&chrono);
+    chrono_start(&chrono);
+    for (int i = 0; i < BENCH_ITERS; i++)
+    {
+        multi_partition(Input, n, P, np, Output, Pos, nThreads);
+        if (respawn)
+        {
+            multi_partition_restart_workers();
+        }
+    }
+    chrono_stop(&chrono);
+
+    return (double)chrono_gettotal(&chrono) / BENCH_ITERS / 1000.0;
+}
+
+static int bench_latency(int nThreads)
+{
+    int sizes[] = {1000, 10000, 100000, 300000};
+    int nSizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    int max_n = sizes[nSizes - 1];
+    long long *Input = generate_random_vector(max_n, 0);
+    long long *P = generate_random_vector(BENCH_NP, 1);
+    long long *Output = create_vector(max_n);
+    long long *Pos = create_pos_vector(BENCH_NP);
+
+    if (Input == NULL || P == NULL || Output == NULL || Pos == NULL)
+    {
+        fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+        return 1;
+    }
+
+    printf("# latência por chamada (us), np=%d, %d threads, %d chamadas\n", BENCH_NP, nThreads, BENCH_ITERS);
+    printf("%10s %12s %12s %8s\n", "n", "respawn", "pool", "ganho");
+
+    for (int s = 0; s < nSizes; s++)
+    {
+        long long n = sizes[s];
+        double respawn = bench_latency_us(Input, n, P, BENCH_NP, Output, Pos, nThreads, 1);
+        double pool = bench_latency_us(Input, n, P, BENCH_NP, Output, Pos, nThreads, 0);
+        printf("%10lld %12.1f %12.1f %7.2fx\n", n, respawn, pool, respawn / pool);
+    }
+
+    destroy_vector(Input);
+    destroy_vector(P);
+    destroy_vector(Output);
+    destroy_pos_vector(Pos);
+    return 0;
+}
+
+/**
+ * Vazão (elementos/s) da escrita direta e da escrita com buffers de
+ * write-combining, variando np de 16 a 100000.
+ */
+static int bench_scatter(int nThreads, long long n)
+{
+    int nps[] = {16, 64, 256, 1024, 4096, 16384, 65536, 100000};
+    int nNps = sizeof(nps) / sizeof(nps[0]);
+    const char *names[] = {"direct", "wc"};
+
+    long long *Input = generate_random_vector(n, 0);
+    long long *Output = create_vector(n);
+
+    if (Input == NULL || Output == NULL)
+    {
+        fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+        return 1;
+    }
+
+    printf("# vazão (milhões de elementos/s), n=%lld, %d threads\n", n, nThreads);
+    printf("%8s %12s %12s\n", "np", names[0], names[1]);
+
+    for (int k = 0; k < nNps; k++)
+    {
+        int np = nps[k];
+        long long *P = generate_random_vector(np, 1);
+        long long *Pos = create_pos_vector(np);
+        double rate[2];
+
+        for (int mode = MP_SCATTER_DIRECT; mode <= MP_SCATTER_WC; mode++)
+        {
+            chronometer_t chrono;
+
+            multi_partition_set_scatter(mode);
+            multi_partition(Input, n, P, np, Output, Pos, nThreads); // Aquecimento
+
+            chrono_reset(&chrono);
+            chrono_start(&chrono);
+            for (int i = 0; i < BENCH_SCATTER_ITERS; i++)
+            {
+                multi_partition(Input, n, P, np, Output, Pos, nThreads);
+            }
+            chrono_stop(&chrono);
+
+            rate[mode] = (double)n * BENCH_SCATTER_ITERS / ((double)chrono_gettotal(&chrono) / 1000.0);
+        }
+        printf("%8d %12.1f %12.1f\n", np, rate[0], rate[1]);
+
+        destroy_vector(P);
+        destroy_pos_vector(Pos);
+    }
+
+    multi_partition_set_scatter(MP_SCATTER_DIRECT);
+    destroy_vector(Input);
+    destroy_vector(Output);
+    return 0;
+}
+
+/**
+ * Vazão (elementos/s) com um e dois níveis de particionamento, variando np,
+ * e o número de níveis escolhido automaticamente.
+ */
+static int bench_levels(int nThreads, long long n)
+{
+    int nps[] = {16, 256, 1024, 4096, 16384, 65536, 100000};
+    int nNps = sizeof(nps) / sizeof(nps[0]);
+
+    long long *Input = generate_random_vector(n, 0);
+    long long *Output = create_vector(n);
+
+    if (Input == NULL || Output == NULL)
+    {
+        fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+        return 1;
+    }
+
+    printf("# vazão (milhões de elementos/s), n=%lld, %d threads\n", n, nThreads);
+    printf("%8s %12s %12s %6s\n", "np", "1 nível", "2 níveis", "auto");
+
+    for (int k = 0; k < nNps; k++)
+    {
+        int np = nps[k];
+        long long *P = generate_random_vector(np, 1);
+        long long *Pos = create_pos_vector(np);
+        double rate[3];
+
+        for (int levels = 1; levels <= 2; levels++)
+        {
+            chronometer_t chrono;
+
+            multi_partition_set_levels(levels);
+            multi_partition(Input, n, P, np, Output, Pos, nThreads); // Aquecimento
+
+            chrono_reset(&chrono);
+            chrono_start(&chrono);
+            for (int i = 0; i < BENCH_SCATTER_ITERS; i++)
+            {
+                multi_partition(Input, n, P, np, Output, Pos, nThreads);
+            }
+            chrono_stop(&chrono);
+
+            rate[levels] = (double)n * BENCH_SCATTER_ITERS / ((double)chrono_gettotal(&chrono) / 1000.0);
+        }
+        multi_partition_set_levels(0);
+        printf("%8d %12.1f %12.1f %6d\n", np, rate[1], rate[2], multi_partition_levels(np));
+
+        destroy_vector(P);
+        destroy_pos_vector(Pos);
+    }
+
+    destroy_vector(Input);
+    destroy_vector(Output);
+    return 0;
+}
+
+/**
+ * Busca de uma chave por vez contra a busca em lote intercalada, variando np:
+ * o núcleo de classificação sozinho (uma thread, milhões de chaves/s) e
+ * `multi_partition` com um nível (busca em lote desligada e ligada).
+ */
+static int bench_search(int nThreads, long long n)
+{
+    int nps[] = {1000, 4096, 10000, 30000, 100000, 1000000};
+    int nNps = sizeof(nps) / sizeof(nps[0]);
+
+    long long *Input = generate_random_vector(n, 0);
+    long long *Output = create_vector(n);
+    int *ids = malloc((size_t)n * sizeof(int));
+
+    if (Input == NULL || Output == NULL || ids == NULL)
+    {
+        fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+        return 1;
+    }
+
+    printf("# vazão (milhões de elementos/s), n=%lld, %d threads, 1 nível, lotes de %d chaves\n", n, nThreads,
+           SPLITTER_BATCH);
+    printf("%8s %10s %12s %12s %8s %12s %12s %8s\n", "np", "árvore KB", "busca 1x1", "busca lote", "ganho",
+           "mp 1x1", "mp lote", "ganho");
+
+    multi_partition_set_levels(1);
+    for (int k = 0; k < nNps; k++)
+    {
+        int np = nps[k];
+        long long *P = generate_random_vector(np, 1);
+        long long *Pos = create_pos_vector(np);
+        splitter_index_t *index = splitter_index_create(P, np);
+        double search_rate[2], mp_rate[2];
+        long long check = 0;
+
+        if (P == NULL || Pos == NULL || index == NULL)
+        {
+            fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+            return 1;
+        }
+
+        for (int batch = 0; batch <= 1; batch++)
+        {
+            chronometer_t chrono;
+
+            // Núcleo: classifica Input inteiro em ids
+            chrono_reset(&chrono);
+            chrono_start(&chrono);
+            for (int it = 0; it < BENCH_SCATTER_ITERS; it++)
+            {
+                if (batch)
+                {
+                    for (long long i = 0; i < n; i += SPLITTER_BATCH)
+                    {
+                        int m = n - i < SPLITTER_BATCH ? (int)(n - i) : SPLITTER_BATCH;
+                        splitter_index_search_batch(index, Input + i, m, ids + i);
+                    }
+                }
+                else
+                {
+                    for (long long i = 0; i < n; i++)
+                    {
+                        ids[i] = splitter_index_search(index, Input[i]);
+                    }
+                }
+            }
+            chrono_stop(&chrono);
+            search_rate[batch] = (double)n * BENCH_SCATTER_ITERS / ((double)chrono_gettotal(&chrono) / 1000.0);
+            for (long long i = 0; i < n; i += 97)
+            {
+                check += batch ? -ids[i] : ids[i]; // As duas buscas devem concordar
+            }
+
+            // Particionamento completo
+            multi_partition_set_batch_search(batch);
+            multi_partition(Input, n, P, np, Output, Pos, nThreads); // Aquecimento
+
+            chrono_reset(&chrono);
+            chrono_start(&chrono);
+            for (int it = 0; it < BENCH_SCATTER_ITERS; it++)
+            {
+                multi_partition(Input, n, P, np, Output, Pos, nThreads);
+            }
+            chrono_stop(&chrono);
+            mp_rate[batch] = (double)n * BENCH_SCATTER_ITERS / ((double)chrono_gettotal(&chrono) / 1000.0);
+        }
+
+        printf("%8d %10.0f %12.1f %12.1f %7.2fx %12.1f %12.1f %7.2fx%s\n", np,
+               (double)index->nblocks * SPLITTER_NODE_KEYS * sizeof(long long) / 1024.0, search_rate[0],
+               search_rate[1], search_rate[1] / search_rate[0], mp_rate[0], mp_rate[1], mp_rate[1] / mp_rate[0],
+               check != 0 ? "  ERRO" : "");
+
+        splitter_index_destroy(index);
+        destroy_vector(P);
+        destroy_pos_vector(Pos);
+    }
+    multi_partition_set_levels(0);
+    multi_partition_set_batch_search(1);
+
+    free(ids);
+    destroy_vector(Input);
+    destroy_vector(Output);
+    return 0;
+}
+
+/**
+ * Vazão do particionamento fora do lugar (Output + T) e in-place, variando
+ * np. A cópia de Input para o vetor in-place fica fora da medida.
+ */
+static int bench_inplace(int nThreads, long long n)
+{
+    int nps[] = {16, 256, 1000, 4096, 65536};
+    int nNps = sizeof(nps) / sizeof(nps[0]);
+
+    long long *Input = generate_random_vector(n, 0);
+    long long *Output = create_vector(n);
+    long long *Data = create_vector(n);
+
+    if (Input == NULL || Output == NULL || Data == NULL)
+    {
+        fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+        return 1;
+    }
+
+    printf("# vazão (milhões de elementos/s), n=%lld, %d threads\n", n, nThreads);
+    printf("%8s %12s %12s %8s\n", "np", "fora", "in-place", "razão");
+
+    for (int k = 0; k < nNps; k++)
+    {
+        int np = nps[k];
+        long long *P = generate_random_vector(np, 1);
+        long long *Pos = create_pos_vector(np);
+        double secs[2] = {0, 0};
+
+        for (int mode = 0; mode < 2; mode++)
+        {
+            for (int i = 0; i <= BENCH_SCATTER_ITERS; i++)
+            {
+                chronometer_t chrono;
+
+                memcpy(Data, Input, (size_t)n * sizeof(long long));
+                chrono_reset(&chrono);
+                chrono_start(&chrono);
+                if (mode == 0)
+                {
+                    multi_partition(Data, n, P, np, Output, Pos, nThreads);
+                }
+                else
+                {
+                    multi_partition_inplace(Data, n, P, np, Pos, nThreads);
+                }
+                chrono_stop(&chrono);
+
+                // A primeira execução é aquecimento
+                secs[mode] += i > 0 ? (double)chrono_gettotal(&chrono) / 1e9 : 0;
+            }
+        }
+
+        double rate_out = n * BENCH_SCATTER_ITERS / secs[0] / 1e6;
+        double rate_in = n * BENCH_SCATTER_ITERS / secs[1] / 1e6;
+        printf("%8d %12.1f %12.1f %7.2fx\n", np, rate_out, rate_in, rate_in / rate_out);
+
+        destroy_vector(P);
+        destroy_pos_vector(Pos);
+    }
+
+    destroy_vector(Input);
+    destroy_vector(Output);
+    destroy_vector(Data);
+    return 0;
+}
+
+/**
+ * Custo de mover só a chave, chave + payload de 8/16/32 bytes e só a
+ * permutação (uint32/uint64), com np fixo. GB/s conta a leitura e a escrita
+ * de cada byte movido.
+ */
+static int bench_payload(int nThreads, long long n)
+{
+    const char *names[] = {"chave", "chave+8B", "chave+16B", "chave+32B", "perm32", "perm64", "perm32+gather32B"};
+    size_t widths[] = {0, 8, 16, 32, 0, 0, 32};
+    int nRows = sizeof(names) / sizeof(names[0]);
+
+    long long *Input = generate_random_vector(n, 0);
+    long long *Output = create_vector(n);
+    long long *P = generate_random_vector(BENCH_NP, 1);
+    long long *Pos = create_pos_vector(BENCH_NP);
+    char *payload = malloc((size_t)n * 32);
+    char *out_payload = malloc((size_t)n * 32);
+    void *perm = malloc((size_t)n * 8);
+    multi_partition_plan_t *plan = P != NULL ? multi_partition_plan_create(P, BENCH_NP, nThreads, n) : NULL;
+
+    if (Input == NULL || Output == NULL || Pos == NULL || payload == NULL || out_payload == NULL || perm == NULL || plan == NULL)
+    {
+        fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+        return 1;
+    }
+    memset(payload, 1, (size_t)n * 32);
+
+    printf("# n=%lld, np=%d, %d threads\n", n, BENCH_NP, nThreads);
+    printf("%-18s %12s %10s\n", "modo", "Melem/s", "GB/s");
+
+    for (int r = 0; r < nRows; r++)
+    {
+        int perm_bytes = r == 5 ? 8 : (r >= 4 ? 4 : 0);
+        mp_payload_t extra = {r >= 1 && r <= 3 ? payload : NULL, out_payload, widths[r], perm_bytes ? perm : NULL, perm_bytes};
+        long long *out = perm_bytes ? NULL : Output;
+        chronometer_t chrono;
+
+        for (int i = 0; i <= BENCH_SCATTER_ITERS; i++)
+        {
+            // A primeira execução é aquecimento
+            if (i == 1)
+            {
+                chrono_reset(&chrono);
+                chrono_start(&chrono);
+            }
+            if (r == 0)
+            {
+                multi_partition_execute(plan, Input, n, Output, Pos);
+            }
+            else
+            {
+                multi_partition_execute_payload(plan, Input, n, out, Pos, &extra);
+            }
+            if (r == 6)
+            {
+                multi_partition_gather(plan, payload, widths[r], perm, 4, n, out_payload);
+            }
+        }
+        chrono_stop(&chrono);
+
+        double secs = (double)chrono_gettotal(&chrono) / 1e9 / BENCH_SCATTER_ITERS;
+        double bytes = perm_bytes ? 8.0 + perm_bytes : 2.0 * (8 + widths[r]);
+        bytes += r == 6 ? 2.0 * widths[r] + perm_bytes : 0; // Gather: lê perm e src, grava dst
+        printf("%-18s %12.1f %10.3f\n", names[r], n / secs / 1e6, n * bytes / secs / 1e9);
+    }
+
+    multi_partition_plan_destroy(plan);
+    free(payload);
+    free(out_payload);
+    free(perm);
+    destroy_vector(Input);
+    destroy_vector(Output);
+    destroy_vector(P);
+    destroy_pos_vector(Pos);
+    return 0;
+}
+
+// Confere um arquivo de saída de `multi_partition_stream` (MP_STREAM_FILE)
+static int stream_check(const char *path, long long *P, int np, const long long *Pos, long long n)
+{
+    FILE *f = fopen(path, "rb");
+    long long buf[4096];
+    long long i = 0;
+    int j = 0, ok = f != NULL;
+
+    while (ok && i < n)
+    {
+        size_t got = fread(buf, sizeof(long long), 4096, f);
+        ok = got > 0;
+        for (size_t k = 0; ok && k < got; k++, i++)
+        {
+            while (j + 1 < np && i >= Pos[j + 1])
+            {
+                j++;
+            }
+            ok = (j == np - 1 || buf[k] < P[j]) && (j == 0 || buf[k] >= P[j - 1]);
+        }
+    }
+    if (f != NULL)
+    {
+        fclose(f);
+    }
+    return ok ? 0 : -1;
+}
+
+// Confere os arquivos de faixa de `multi_partition_stream` (MP_STREAM_BUCKETS):
+// o arquivo j tem exatamente as chaves da faixa j, todas dentro dela
+static int stream_check_buckets(const char *prefix, long long *P, int np, const long long *Pos, long long n)
+{
+    long long buf[4096];
+    int ok = 1;
+
+    for (int j = 0; ok && j < np; j++)
+    {
+        char path[600];
+        snprintf(path, sizeof(path), "%s.%d", prefix, j);
+        FILE *f = fopen(path, "rb");
+        long long expected = (j + 1 < np ? Pos[j + 1] : n) - Pos[j];
+        long long count = 0;
+        size_t got;
+
+        ok = f != NULL;
+        while (ok && (got = fread(buf, sizeof(long long), 4096, f)) > 0)
+        {
+            for (size_t k = 0; ok && k < got; k++)
+            {
+                ok = (j == np - 1 || buf[k] < P[j]) && (j == 0 || buf[k] >= P[j - 1]);
+            }
+            count += got;
+        }
+        ok = ok && count == expected;
+        if (f != NULL)
+        {
+            fclose(f);
+        }
+    }
+    return ok ? 0 : -1;
+}
+
+/**
+ * Particionamento out-of-core de um arquivo temporário de n chaves, com
+ * saída em um único arquivo e em um arquivo por faixa. Reporta a vazão e o
+ * tempo de leitura, escrita e particionamento (que se sobrepõem).
+ */
+static int bench_stream(int nThreads, long long n)
+{
+    int nps[] = {16, 1000};
+    const char *dir = getenv("TMPDIR") != NULL ? getenv("TMPDIR") : "/tmp";
+    char in_path[512], out_path[512];
+    long long *block = create_vector(1 << 20);
+    int chunk = n / 8 < INT_MAX ? (int)(n / 8) : INT_MAX; // Blocos de n / 8 elementos (`chunk_elems` é int).
+
+    snprintf(in_path, sizeof(in_path), "%s/mp_stream_%d.in", dir, (int)getpid());
+    snprintf(out_path, sizeof(out_path), "%s/mp_stream_%d.out", dir, (int)getpid());
+
+    FILE *f = fopen(in_path, "wb");
+    if (f == NULL || block == NULL)
+    {
+        fprintf(stderr, "Erro ao criar o arquivo de entrada %s\n", in_path);
+        return 1;
+    }
+    for (long long i = 0; i < n; i += 1 << 20)
+    {
+        int len = n - i < (1 << 20) ? (int)(n - i) : (1 << 20);
+        mp_gen_fill(block, len, i, NULL, 0); // Bloco i da mesma sequência uniforme
+        fwrite(block, sizeof(long long), len, f);
+    }
+    fclose(f);
+    destroy_vector(block);
+
+    printf("# out-of-core, n=%lld (%.0f MB), blocos de %d elementos, %d threads\n", n, n * 8.0 / 1e6, chunk, nThreads);
+    printf("%8s %8s %10s %9s %9s %9s %9s %s\n", "np", "saída", "MB/s", "total_s", "leitura", "escrita", "cálculo", "ok");
+
+    int ret = 0;
+    for (int k = 0; k < 2 && ret == 0; k++)
+    {
+        int np = nps[k];
+        long long *P = generate_random_vector(np, 1);
+        long long *Pos = malloc(np * sizeof(long long));
+
+        for (int mode = MP_STREAM_FILE; mode <= MP_STREAM_BUCKETS && ret == 0; mode++)
+        {
+            mp_stream_options_t opt = {nThreads, chunk, mode, 0};
+            mp_stream_stats_t st;
+
+            if (multi_partition_stream(in_path, P, np, out_path, Pos, &opt, &st) != 0)
+            {
+                fprintf(stderr, "Erro de E/S em multi_partition_stream\n");
+                ret = 1;
+                break;
+            }
+
+            int bad;
+            if (mode == MP_STREAM_FILE)
+            {
+                bad = stream_check(out_path, P, np, Pos, n) != 0;
+                unlink(out_path);
+            }
+            else
+            {
+                bad = stream_check_buckets(out_path, P, np, Pos, n) != 0;
+                for (int j = 0; j < np; j++)
+                {
+                    char path[600];
+                    snprintf(path, sizeof(path), "%s.%d", out_path, j);
+                    unlink(path);
+                }
+            }
+            printf("%8d %8s %10.1f %9.3f %9.3f %9.3f %9.3f %s\n", np, mode == MP_STREAM_FILE ? "arquivo" : "faixas",
+                   n * 8.0 / 1e6 / st.total, st.total, st.read, st.write, st.compute, bad ? "NÃO" : "sim");
+            ret |= bad;
+        }
+
+        destroy_vector(P);
+        free(Pos);
+    }
+
+    unlink(in_path);
+    return ret;
+}
+
+/**
+ * Vazão da verificação paralela (GB/s lidos de Input e Output) comparada
+ * ao tempo do próprio particionamento, e erros injetados em Output/Pos que
+ * a verificação deve detectar.
+ */
+static int bench_verify(int nThreads, long long n)
+{
+    int np = BENCH_NP;
+    long long *Input = generate_random_vector(n, 0);
+    long long *P = generate_random_vector(np, 1);
+    long long *Output = create_vector(n);
+    long long *Pos = create_pos_vector(np);
+    mp_verify_result_t res;
+    chronometer_t chrono;
+    int ret = 0;
+
+    if (Input == NULL || P == NULL || Output == NULL || Pos == NULL)
+    {
+        fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+        return 1;
+    }
+
+    multi_partition(Input, n, P, np, Output, Pos, nThreads); // Aquecimento
+    chrono_reset(&chrono);
+    chrono_start(&chrono);
+    for (int i = 0; i < BENCH_SCATTER_ITERS; i++)
+    {
+        multi_partition(Input, n, P, np, Output, Pos, nThreads);
+    }
+    chrono_stop(&chrono);
+    double part_ms = (double)chrono_gettotal(&chrono) / 1e6 / BENCH_SCATTER_ITERS;
+
+    multi_partition_verify(Input, n, P, np, Output, Pos, nThreads, &res); // Aquecimento
+    chrono_reset(&chrono);
+    chrono_start(&chrono);
+    for (int i = 0; i < BENCH_SCATTER_ITERS; i++)
+    {
+        ret |= multi_partition_verify(Input, n, P, np, Output, Pos, nThreads, &res) != 0;
+    }
+    chrono_stop(&chrono);
+    double verify_ms = (double)chrono_gettotal(&chrono) / 1e6 / BENCH_SCATTER_ITERS;
+
+    printf("# verificação, n=%lld, np=%d, %d threads\n", n, np, nThreads);
+    printf("%-28s %10.2f ms\n", "multi_partition", part_ms);
+    printf("%-28s %10.2f ms %8.2f GB/s  %s\n", "multi_partition_verify", verify_ms,
+           2.0 * n * sizeof(long long) / (verify_ms / 1e3) / 1e9, multi_partition_verify_status(res.status));
+
+    // Erros injetados: cada um é desfeito antes do próximo
+    long long mid = n / 2, last = n - 1;
+    long long saved = Output[mid];
+    int range = 0;
+    while (range + 1 < np && Pos[range + 1] <= mid)
+    {
+        range++;
+    }
+
+    printf("%-28s %-38s %10s %6s\n", "erro injetado", "detectado", "índice", "faixa");
+
+    // 1. Elemento de outra faixa (limite superior ou inferior)
+    Output[mid] = range + 1 < np ? P[range] : P[0] - 1;
+    multi_partition_verify(Input, n, P, np, Output, Pos, nThreads, &res);
+    printf("%-28s %-38s %10lld %6d\n", "chave fora da faixa", multi_partition_verify_status(res.status), res.index,
+           res.range);
+    ret |= res.status != MP_VERIFY_RANGE || res.index != mid;
+    Output[mid] = saved;
+
+    // 2. Chave trocada por outra da mesma faixa: só o hash detecta
+    Output[mid] = Output[mid] + (Output[mid] > LLONG_MIN ? -1 : 1);
+    if (Output[mid] < (range > 0 ? P[range - 1] : LLONG_MIN))
+    {
+        Output[mid] = saved + 1;
+    }
+    multi_partition_verify(Input, n, P, np, Output, Pos, nThreads, &res);
+    printf("%-28s %-38s %10lld %6d\n", "chave alterada na faixa", multi_partition_verify_status(res.status), res.index,
+           res.range);
+    ret |= res.status != MP_VERIFY_MULTISET && res.status != MP_VERIFY_RANGE;
+    Output[mid] = saved;
+
+    // 3. Última faixa com uma chave abaixo de P[np-2]
+    saved = Output[last];
+    Output[last] = np > 1 ? P[np - 2] - 1 : Output[last];
+    multi_partition_verify(Input, n, P, np, Output, Pos, nThreads, &res);
+    printf("%-28s %-38s %10lld %6d\n", "limite inferior da última", multi_partition_verify_status(res.status),
+           res.index, res.range);
+    ret |= np > 1 && res.status != MP_VERIFY_RANGE;
+    Output[last] = saved;
+
+    // 4. Pos decrescente
+    if (np > 2)
+    {
+        long long saved_pos = Pos[2];
+        Pos[2] = Pos[1] - 1;
+        multi_partition_verify(Input, n, P, np, Output, Pos, nThreads, &res);
+        printf("%-28s %-38s %10lld %6d\n", "Pos decrescente", multi_partition_verify_status(res.status), res.index,
+               res.range);
+        ret |= res.status != MP_VERIFY_POS;
+        Pos[2] = saved_pos;
+    }
+
+    destroy_vector(Input);
+    destroy_vector(P);
+    destroy_vector(Output);
+    destroy_pos_vector(Pos);
+    return ret;
+}
+
+#define SWEEP_MAX_VALUES 32
+
+// Parâmetros da varredura (listas separadas por vírgula na linha de comando)
+typedef struct
+{
+    long long n[SWEEP_MAX_VALUES];
+    int n_count;
+    int np[SWEEP_MAX_VALUES];
+    int np_count;
+    int threads[SWEEP_MAX_VALUES];
+    int threads_count;
+    const char *dist[SWEEP_MAX_VALUES];
+    int dist_count;
+    int reps;        // Execuções medidas por configuração
+    int warmup;      // Execuções de aquecimento por configuração
+    int json;        // 1 = JSON, 0 = CSV
+    int profile;     // Imprime o perfil por fase de cada configuração em stderr
+    int numa;        // Workers fixados e Input/Output distribuídos entre os nós
+    unsigned long long seed; // Semente de Input e P
+    FILE *out;       // Destino do relatório
+    char dist_buf[256];
+} sweep_config_t;
+
+// Resultado de uma configuração (tempos em segundos)
+typedef struct
+{
+    double min, median, p95;
+} sweep_stats_t;
+
+static int parse_int_list(const char *arg, int *values)
+{
+    int count = 0;
+    const char *p = arg;
+
+    while (*p != '\0' && count < SWEEP_MAX_VALUES)
+    {
+        values[count] = atoi(p);
+        if (values[count] <= 0)
+        {
+            return -1;
+        }
+        count++;
+        p = strchr(p, ',');
+        if (p == NULL)
+        {
+            break;
+        }
+        p++;
+    }
+    return count;
+}
+
+// Lê um número de elementos (64 bits) do argumento inteiro; -1 se não é um
+// número positivo
+static long long parse_size(const char *arg)
+{
+    char *end;
+    long long value = strtoll(arg, &end, 10);
+
+    return end != arg && *end == '\0' && value > 0 ? value : -1;
+}
+
+// Como parse_int_list, para números de elementos (64 bits)
+static int parse_size_list(const char *arg, long long *values)
+{
+    int count = 0;
+    const char *p = arg;
+
+    while (*p != '\0' && count < SWEEP_MAX_VALUES)
+    {
+        values[count] = atoll(p);
+        if (values[count] <= 0)
+        {
+            return -1;
+        }
+        count++;
+        p = strchr(p, ',');
+        if (p == NULL)
+        {
+            break;
+        }
+        p++;
+    }
+    return count;
+}
+
+static int parse_dist_list(sweep_config_t *cfg, const char *arg)
+{
+    strncpy(cfg->dist_buf, arg, sizeof(cfg->dist_buf) - 1);
+    cfg->dist_count = 0;
+
+    for (char *tok = strtok(cfg->dist_buf, ","); tok != NULL && cfg->dist_count < SWEEP_MAX_VALUES; tok = strtok(NULL, ","))
+    {
+        cfg->dist[cfg->dist_count++] = tok;
+    }
+    return cfg->dist_count;
+}
+
+/**
+ * Preenche Input com n elementos da distribuição `dist`:
+ * uniform, sorted (crescente), reverse (decrescente) ou fewunique (16 valores).
+ */
+// Gera Input com a distribuição pedida (em paralelo, reproduzível pela semente)
+static int fill_distribution(long long *Input, long long n, const char *dist, unsigned long long seed)
+{
+    mp_gen_options_t opt = {MP_DIST_UNIFORM, seed, 0, 0, 0, 0};
+
+    if (mp_gen_parse_dist(dist, &opt.dist) != 0)
+    {
+        return -1; // Distribuição desconhecida
+    }
+    return mp_gen_fill(Input, n, 0, &opt, 0);
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static sweep_stats_t compute_stats(double *times, int count)
+{
+    sweep_stats_t st;
+    int p95 = (int)(0.95 * count + 0.999999) - 1;
+
+    qsort(times, count, sizeof(double), compare_double);
+    st.min = times[0];
+    st.median = count % 2 ? times[count / 2] : (times[count / 2 - 1] + times[count / 2]) / 2;
+    st.p95 = times[p95 < 0 ? 0 : p95];
+    return st;
+}
+
+#define BENCH_BALANCE_ITERS 30
+
+// Thread de interferência: ocupa a CPU do worker 0 enquanto `running` for 1
+typedef struct
+{
+    int cpu;
+    int running; // 1 enquanto a thread deve girar (atômico).
+} interference_t;
+
+static void *interference_thread(void *arg)
+{
+    interference_t *it = (interference_t *)arg;
+    volatile unsigned long spin = 0;
+
+    topology_pin_current_thread(it->cpu);
+    while (__atomic_load_n(&it->running, __ATOMIC_ACQUIRE))
+    {
+        spin++;
+    }
+    return NULL;
+}
+
+/**
+ * Previsão da faixa (tabela pelos bits altos e modelo linear por trechos)
+ * contra a árvore. P vem de partições aleatórias uniformes ou da amostragem
+ * (`mp_sample_splitters`) de Input em várias distribuições. Mostra a janela
+ * de correção de cada modelo ("-" = erro grande demais, volta para a árvore),
+ * a vazão da busca sozinha (uma thread, milhões de chaves/s) e a de
+ * `multi_partition` com um nível, só com a árvore e com `SPLITTER_PREDICT_AUTO`.
+ */
+static int bench_predict(int nThreads, long long n)
+{
+    const char *dists[] = {"aleatório", "uniform", "zipf", "clustered"};
+    int nps[] = {1000, 10000, 100000};
+    int nDists = sizeof(dists) / sizeof(dists[0]), nNps = sizeof(nps) / sizeof(nps[0]);
+    splitter_predict_t modes[] = {SPLITTER_PREDICT_NONE, SPLITTER_PREDICT_LUT, SPLITTER_PREDICT_RMI};
+
+    long long *Input = create_vector(n);
+    long long *Output = create_vector(n);
+    int *ids = malloc((size_t)n * sizeof(int));
+    int *expected = malloc((size_t)n * sizeof(int));
+
+    if (Input == NULL || Output == NULL || ids == NULL || expected == NULL)
+    {
+        fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+        return 1;
+    }
+
+    printf("# vazão (milhões de elementos/s), n=%lld, %d threads, 1 nível\n", n, nThreads);
+    printf("%-10s %7s %6s %6s %10s %10s %10s %10s %10s %s\n", "P", "np", "j.lut", "j.rmi", "árvore", "lut", "rmi",
+           "mp árvore", "mp auto", "ok");
+
+    multi_partition_set_levels(1);
+    for (int d = 0; d < nDists; d++)
+    {
+        int random_P = d == 0;
+        if (fill_distribution(Input, n, random_P ? "uniform" : dists[d], 1) != 0)
+        {
+            fprintf(stderr, "Erro ao gerar os dados\n");
+            return 1;
+        }
+
+        for (int k = 0; k < nNps; k++)
+        {
+            int np = nps[k];
+            long long *P = random_P ? generate_random_vector(np, 1) : create_vector(np);
+            long long *Pos = create_pos_vector(np);
+            if (P == NULL || Pos == NULL || (!random_P && mp_sample_splitters(Input, n, P, np, 1, 0) != 0))
+            {
+                fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+                return 1;
+            }
+
+            splitter_index_t *index = splitter_index_create(P, np);
+            double rate[3], mp_rate[2];
+            int window[3] = {0, -1, -1}, ok = index != NULL;
+
+            for (int m = 0; m < 3 && ok; m++)
+            {
+                chronometer_t chrono;
+
+                if (splitter_index_set_predict(index, modes[m]) != 0)
+                {
+                    rate[m] = 0.0; // Modelo recusado: a busca seria a da árvore
+                    continue;
+                }
+                window[m] = index->window;
+
+                chrono_reset(&chrono);
+                chrono_start(&chrono);
+                for (int it = 0; it < BENCH_SCATTER_ITERS; it++)
+                {
+                    for (long long i = 0; i < n; i++)
+                    {
+                        ids[i] = splitter_index_search(index, Input[i]);
+                    }
+                }
+                chrono_stop(&chrono);
+                rate[m] = (double)n * BENCH_SCATTER_ITERS / ((double)chrono_gettotal(&chrono) / 1000.0);
+
+                if (m == 0)
+                {
+                    memcpy(expected, ids, (size_t)n * sizeof(int));
+                }
+                ok = memcmp(expected, ids, (size_t)n * sizeof(int)) == 0;
+            }
+
+            for (int auto_predict = 0; auto_predict <= 1; auto_predict++)
+            {
+                chronometer_t chrono;
+
+                multi_partition_set_predict(auto_predict ? SPLITTER_PREDICT_AUTO : SPLITTER_PREDICT_NONE);
+                multi_partition(Input, n, P, np, Output, Pos, nThreads); // Aquecimento
+
+                chrono_reset(&chrono);
+                chrono_start(&chrono);
+                for (int it = 0; it < BENCH_SCATTER_ITERS; it++)
+                {
+                    multi_partition(Input, n, P, np, Output, Pos, nThreads);
+                }
+                chrono_stop(&chrono);
+                mp_rate[auto_predict] = (double)n * BENCH_SCATTER_ITERS / ((double)chrono_gettotal(&chrono) / 1000.0);
+            }
+            mp_verify_result_t res;
+            ok = ok && multi_partition_verify(Input, n, P, np, Output, Pos, nThreads, &res) == 0;
+
+            // Modelos recusados aparecem como "-"
+            char text[3][2][16];
+            for (int m = 1; m < 3; m++)
+            {
+                snprintf(text[m][0], sizeof(text[m][0]), window[m] >= 0 ? "%d" : "-", window[m]);
+                snprintf(text[m][1], sizeof(text[m][1]), window[m] >= 0 ? "%.1f" : "-", rate[m]);
+            }
+            printf("%-10s %7d %6s %6s %10.1f %10s %10s %10.1f %10.1f %s\n", dists[d], np, text[1][0], text[2][0],
+                   rate[0], text[1][1], text[2][1], mp_rate[0], mp_rate[1], ok ? "ok" : "ERRO");
+
+            splitter_index_destroy(index);
+            destroy_vector(P);
+            destroy_pos_vector(Pos);
+        }
+    }
+    multi_partition_set_levels(0);
+    multi_partition_set_predict(SPLITTER_PREDICT_NONE);
+
+    free(ids);
+    free(expected);
+    destroy_vector(Input);
+    destroy_vector(Output);
+    return 0;
+}
+
+/**
+ * Latência por chamada (mediana, p95 e máximo) com intervalos fixos por
+ * thread e com morsels, sem e com uma thread de interferência fixada na CPU
+ * do worker 0. Os workers são fixados (modo NUMA) para que a interferência
+ * atinja sempre o mesmo worker; com intervalos fixos, os demais esperam por
+ * ele na barreira.
+ */
+static int bench_balance(int nThreads, long long n)
+{
+    const char *names[] = {"estático", "morsels"};
+    int np = BENCH_NP;
+    long long *Input = generate_random_vector(n, 0);
+    long long *P = generate_random_vector(np, 1);
+    long long *Output = create_vector(n);
+    long long *Pos = create_pos_vector(np);
+    long long *RefPos = create_pos_vector(np);
+    long long *Ref = create_vector(n);
+    double times[BENCH_BALANCE_ITERS];
+    topology_t *topo = topology_discover();
+    int ret = 0;
+
+    if (Input == NULL || P == NULL || Output == NULL || Pos == NULL || RefPos == NULL || Ref == NULL || topo == NULL)
+    {
+        fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+        return 1;
+    }
+
+    int node;
+    interference_t it = {topology_thread_cpu(topo, 0, nThreads, &node), 0};
+
+    printf("# latência por chamada (ms), n=%lld, np=%d, %d threads, %d chamadas, interferência na CPU %d\n", n, np,
+           nThreads, BENCH_BALANCE_ITERS, it.cpu);
+    printf("%10s %14s %9s %9s %9s %s\n", "modo", "interferência", "mediana", "p95", "máximo", "saída");
+
+    multi_partition_set_numa(1);
+    for (int noisy = 0; noisy <= 1; noisy++)
+    {
+        pthread_t hog;
+
+        if (noisy)
+        {
+            it.running = 1;
+            if (pthread_create(&hog, NULL, interference_thread, &it) != 0)
+            {
+                fprintf(stderr, "Erro ao criar a thread de interferência.\n");
+                ret = 1;
+                break;
+            }
+        }
+
+        for (int mode = MP_BALANCE_STATIC; mode <= MP_BALANCE_MORSEL; mode++)
+        {
+            multi_partition_set_balance(mode);
+            multi_partition(Input, n, P, np, Output, Pos, nThreads); // Aquecimento
+
+            for (int i = 0; i < BENCH_BALANCE_ITERS; i++)
+            {
+                chronometer_t chrono;
+
+                chrono_reset(&chrono);
+                chrono_start(&chrono);
+                multi_partition(Input, n, P, np, Output, Pos, nThreads);
+                chrono_stop(&chrono);
+                times[i] = (double)chrono_gettotal(&chrono) / 1e6;
+            }
+
+            // A saída do modo estático sem interferência é a referência
+            if (mode == MP_BALANCE_STATIC && !noisy)
+            {
+                memcpy(Ref, Output, (size_t)n * sizeof(long long));
+                memcpy(RefPos, Pos, np * sizeof(long long));
+            }
+            int same = memcmp(Ref, Output, (size_t)n * sizeof(long long)) == 0 &&
+                       memcmp(RefPos, Pos, np * sizeof(long long)) == 0;
+            ret |= !same;
+
+            sweep_stats_t st = compute_stats(times, BENCH_BALANCE_ITERS);
+            printf("%10s %14s %9.2f %9.2f %9.2f %s\n", names[mode], noisy ? "sim" : "não", st.median, st.p95,
+                   times[BENCH_BALANCE_ITERS - 1], same ? "igual" : "DIFERENTE");
+        }
+
+        if (noisy)
+        {
+            __atomic_store_n(&it.running, 0, __ATOMIC_RELEASE);
+            pthread_join(hog, NULL);
+        }
+    }
+
+    multi_partition_set_balance(MP_BALANCE_STATIC);
+    multi_partition_set_numa(0);
+    topology_destroy(topo);
+    destroy_vector(Input);
+    destroy_vector(P);
+    destroy_vector(Output);
+    destroy_vector(Ref);
+    destroy_pos_vector(Pos);
+    destroy_pos_vector(RefPos);
+    return ret;
+}
+
+#define APPEND_BATCHES 64
+
+/**
+ * Lotes anexados com `mp_append_batch` comparados a refazer
+ * `multi_partition` sobre todo o vetor acumulado a cada lote: o custo do
+ * lote fica constante, o da repetição cresce com o total. Ao final, confere
+ * que a visão concatenada é igual a `multi_partition` sobre tudo e mede a
+ * compactação.
+ */
+static int bench_append(int nThreads, long long n)
+{
+    int np = BENCH_NP;
+    long long batch = n / APPEND_BATCHES > 0 ? n / APPEND_BATCHES : 1;
+    long long *Input = generate_random_vector(n, 0);
+    long long *P = generate_random_vector(np, 1);
+    long long *Output = create_vector(n);
+    long long *Flat = create_vector(n);
+    long long *Pos = create_pos_vector(np);
+    mp_append_t *store = P != NULL ? mp_append_create(P, np, nThreads, batch) : NULL;
+
+    if (Input == NULL || P == NULL || Output == NULL || Flat == NULL || Pos == NULL || store == NULL)
+    {
+        fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+        return 1;
+    }
+
+    printf("# n=%lld em lotes de %lld, np=%d, %d threads\n", n, batch, np, nThreads);
+    printf("%8s %12s %14s %18s %9s\n", "lote", "acumulado", "append (ms)", "repetição (ms)", "ganho");
+
+    int ret = 0;
+    long long done = 0;
+    for (int b = 0; done < n; b++)
+    {
+        long long len = n - done < batch ? n - done : batch;
+        chronometer_t chrono;
+
+        chrono_reset(&chrono);
+        chrono_start(&chrono);
+        ret |= mp_append_batch(store, Input + done, len) != 0;
+        chrono_stop(&chrono);
+        double append_ms = (double)chrono_gettotal(&chrono) / 1e6;
+        done += len;
+
+        // A alternativa: particionar de novo tudo o que já chegou
+        if ((b & (b + 1)) == 0 || done == n)
+        {
+            chrono_reset(&chrono);
+            chrono_start(&chrono);
+            multi_partition(Input, done, P, np, Output, Pos, nThreads);
+            chrono_stop(&chrono);
+            double full_ms = (double)chrono_gettotal(&chrono) / 1e6;
+
+            printf("%8d %12lld %14.3f %18.3f %8.1fx\n", b + 1, done, append_ms, full_ms, full_ms / append_ms);
+        }
+    }
+
+    // Visão concatenada = multi_partition sobre todos os lotes (Output/Pos da última repetição)
+    mp_append_flatten(store, Flat);
+    int same = store->n == n && memcmp(store->Pos, Pos, np * sizeof(long long)) == 0 &&
+               memcmp(Flat, Output, (size_t)n * sizeof(long long)) == 0;
+    ret |= !same;
+
+    int max_chunks = 0;
+    for (int j = 0; j < np; j++)
+    {
+        int nchunks;
+        mp_append_range(store, j, &nchunks);
+        max_chunks = nchunks > max_chunks ? nchunks : max_chunks;
+    }
+
+    chronometer_t chrono;
+    chrono_reset(&chrono);
+    chrono_start(&chrono);
+    ret |= mp_append_compact(store) != 0;
+    chrono_stop(&chrono);
+    mp_append_flatten(store, Flat);
+    same = same && memcmp(Flat, Output, (size_t)n * sizeof(long long)) == 0;
+
+    printf("visão concatenada igual a multi_partition: %s\n", same ? "sim" : "NÃO");
+    printf("trechos por faixa antes da compactação: até %d; compactação: %.3f ms\n", max_chunks,
+           (double)chrono_gettotal(&chrono) / 1e6);
+
+    mp_append_destroy(store);
+    destroy_vector(Input);
+    destroy_vector(P);
+    destroy_vector(Output);
+    destroy_vector(Flat);
+    destroy_pos_vector(Pos);
+    return ret || !same;
+}
+
+#define ASYNC_BLOCK 262144
+
+// Tempos de chegada dos blocos: todos de uma vez e com intervalos crescentes
+static const int async_gaps_us[] = {0, 1000, 4000, 8000};
+
+// Entrega Input em blocos de ASYNC_BLOCK, um a cada gap_us microssegundos,
+// e particiona: coletando tudo e chamando `multi_partition_execute` no fim
+// (async = NULL) ou submetendo cada bloco ao particionador assíncrono.
+// Devolve o tempo total (do primeiro bloco ao resultado) e o tempo depois
+// do último bloco, em ms
+static void async_run(mp_async_t *as, multi_partition_plan_t *plan, long long *Input, long long n, long long *Buffer,
+                      long long *Output, long long *Pos, int gap_us, double *total_ms, double *tail_ms)
+{
+    chronometer_t total, tail;
+
+    chrono_reset(&total);
+    chrono_reset(&tail);
+    chrono_start(&total);
+    for (long long off = 0; off < n; off += ASYNC_BLOCK)
+    {
+        long long len = n - off < ASYNC_BLOCK ? n - off : ASYNC_BLOCK;
+        if (gap_us > 0)
+        {
+            usleep(gap_us);
+        }
+        if (as != NULL)
+        {
+            mp_async_submit(as, Input + off, len);
+        }
+        else
+        {
+            memcpy(Buffer + off, Input + off, (size_t)len * sizeof(long long));
+        }
+    }
+
+    chrono_start(&tail);
+    if (as != NULL)
+    {
+        mp_async_wait(mp_async_close(as, Output, Pos));
+    }
+    else
+    {
+        multi_partition_execute(plan, Buffer, n, Output, Pos);
+    }
+    chrono_stop(&tail);
+    chrono_stop(&total);
+
+    *total_ms = (double)chrono_gettotal(&total) / 1e6;
+    *tail_ms = (double)chrono_gettotal(&tail) / 1e6;
+}
+
+/**
+ * Latência de ponta a ponta com blocos que chegam ao longo do tempo:
+ * coletar todos e chamar `multi_partition` no fim contra submeter cada bloco
+ * ao particionador assíncrono (`mp_async_submit`), que classifica enquanto
+ * os próximos blocos chegam. Mostra o tempo do primeiro bloco ao resultado e
+ * o tempo depois do último bloco, para alguns intervalos entre blocos, e
+ * confere que Output e Pos são iguais.
+ */
+static int bench_async(int nThreads, long long n)
+{
+    int nps[] = {16, 1000, 100000};
+    long long *Input = generate_random_vector(n, 0);
+    long long *Buffer = create_vector(n);
+    long long *Output = create_vector(n);
+    long long *Ref = create_vector(n);
+
+    if (Input == NULL || Buffer == NULL || Output == NULL || Ref == NULL)
+    {
+        fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+        return 1;
+    }
+
+    printf("# n=%lld em blocos de %d, %d threads (ms; melhor de 3)\n", n, ASYNC_BLOCK, nThreads);
+    printf("%8s %10s %12s %12s %12s %12s %9s %6s\n", "np", "interv. us", "coleta", "assíncrono", "fim coleta",
+           "fim assínc.", "ganho", "igual");
+
+    int ret = 0;
+    for (size_t p = 0; p < sizeof(nps) / sizeof(nps[0]); p++)
+    {
+        int np = nps[p];
+        long long *P = generate_random_vector(np, 1);
+        long long *Pos = create_pos_vector(np);
+        long long *RefPos = create_pos_vector(np);
+        multi_partition_plan_t *plan = P != NULL ? multi_partition_plan_create(P, np, nThreads, n) : NULL;
+        mp_async_t *as = P != NULL ? mp_async_create(P, np, nThreads, n, 0) : NULL;
+
+        if (P == NULL || Pos == NULL || RefPos == NULL || plan == NULL || as == NULL)
+        {
+            fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+            return 1;
+        }
+
+        for (size_t g = 0; g < sizeof(async_gaps_us) / sizeof(async_gaps_us[0]); g++)
+        {
+            double collect[2] = {-1.0, 0.0}, async[2] = {-1.0, 0.0};
+
+            for (int it = 0; it < 3; it++)
+            {
+                double total_ms, tail_ms;
+
+                async_run(NULL, plan, Input, n, Buffer, Ref, RefPos, async_gaps_us[g], &total_ms, &tail_ms);
+                if (collect[0] < 0.0 || total_ms < collect[0])
+                {
+                    collect[0] = total_ms;
+                    collect[1] = tail_ms;
+                }
+                async_run(as, NULL, Input, n, NULL, Output, Pos, async_gaps_us[g], &total_ms, &tail_ms);
+                if (async[0] < 0.0 || total_ms < async[0])
+                {
+                    async[0] = total_ms;
+                    async[1] = tail_ms;
+                }
+            }
+
+            int same = memcmp(Output, Ref, (size_t)n * sizeof(long long)) == 0 &&
+                       memcmp(Pos, RefPos, np * sizeof(long long)) == 0;
+            ret |= !same;
+            printf("%8d %10d %12.2f %12.2f %12.2f %12.2f %8.2fx %6s\n", np, async_gaps_us[g], collect[0], async[0],
+                   collect[1], async[1], collect[0] / async[0], same ? "sim" : "NÃO");
+        }
+
+        mp_async_destroy(as);
+        multi_partition_plan_destroy(plan);
+        destroy_vector(P);
+        destroy_pos_vector(Pos);
+        destroy_pos_vector(RefPos);
+    }
+
+    destroy_vector(Input);
+    destroy_vector(Buffer);
+    destroy_vector(Output);
+    destroy_vector(Ref);
+    return ret;
+}
+
+// Mede uma configuração com um plano criado para ela
+static int sweep_run(const sweep_config_t *cfg, long long *Input, long long n, long long *P, int np, long long *Output, long long *Pos, int nThreads, double *times, sweep_stats_t *st)
+{
+    multi_partition_plan_t *plan = multi_partition_plan_create(P, np, nThreads, n);
+    if (plan == NULL)
+    {
+        return -1;
+    }
+
+    // Cada trecho de Input/Output no nó do worker que o processa
+    if (cfg->numa && (multi_partition_place(plan, Input, n) != 0 || multi_partition_place(plan, Output, n) != 0))
+    {
+        fprintf(stderr, "# aviso: mbind indisponível, páginas de Input/Output não movidas\n");
+    }
+
+    for (int i = 0; i < cfg->warmup; i++)
+    {
+        multi_partition_execute(plan, Input, n, Output, Pos);
+    }
+    multi_partition_profile_reset(plan); // Perfil só das execuções medidas
+
+    for (int i = 0; i < cfg->reps; i++)
+    {
+        chronometer_t chrono;
+
+        chrono_reset(&chrono);
+        chrono_start(&chrono);
+        multi_partition_execute(plan, Input, n, Output, Pos);
+        chrono_stop(&chrono);
+
+        times[i] = (double)chrono_gettotal(&chrono) / 1e9;
+    }
+
+    if (cfg->profile)
+    {
+        fprintf(stderr, "# n=%lld np=%d threads=%d\n", n, np, nThreads);
+        multi_partition_profile_report(plan, stderr);
+    }
+
+    multi_partition_plan_destroy(plan);
+    *st = compute_stats(times, cfg->reps);
+    return 0;
+}
+
+static void sweep_usage(const char *prog)
+{
+    fprintf(stderr,
+            "Uso: %s sweep [-n lista] [-p lista] [-t lista] [-d lista] [-r reps] [-w aquecimento] [-f csv|json] [-o arquivo] [-s semente] [-P] [-N]\n"
+            "  -n  números de elementos        (padrão 1000000,4000000)\n"
+            "  -p  números de partições        (padrão 16,1000,100000)\n"
+            "  -t  números de threads          (padrão 1,2,4,8)\n"
+            "  -d  distribuições: uniform,zipf,sorted,reverse,fewunique,clustered (padrão uniform)\n"
+            "  -s  semente dos dados           (padrão 1)\n"
+            "  -P  perfil por fase/thread de cada configuração em stderr (requer make PROFILE=1)\n"
+            "  -N  modo NUMA: workers fixados e Input/Output distribuídos entre os nós\n",
+            prog);
+}
+
+/**
+ * Varredura de n, np, threads e distribuição em um único processo.
+ *
+ * Para cada configuração reporta tempo mínimo/mediano/p95, elementos/s,
+ * GB/s (leitura de Input + escrita de Output, 16 bytes por elemento) e
+ * speedup/eficiência em relação ao menor número de threads da lista.
+ */
+static int bench_sweep(int argc, char *argv[])
+{
+    sweep_config_t cfg = {{1000000, 4000000}, 2, {16, 1000, 100000}, 3, {1, 2, 4, 8}, 4, {"uniform"}, 1, 10, 2, 0, 0, 0, 1, stdout, ""};
+    int opt;
+
+    optind = 2; // Pula o nome do programa e o modo
+    while ((opt = getopt(argc, argv, "n:p:t:d:r:w:f:o:s:PN")) != -1)
+    {
+        int ok = 1;
+        switch (opt)
+        {
+        case 'n':
+            ok = (cfg.n_count = parse_size_list(optarg, cfg.n)) > 0;
+            break;
+        case 'p':
+            ok = (cfg.np_count = parse_int_list(optarg, cfg.np)) > 0;
+            break;
+        case 't':
+            ok = (cfg.threads_count = parse_int_list(optarg, cfg.threads)) > 0;
+            break;
+        case 'd':
+            ok = parse_dist_list(&cfg, optarg) > 0;
+            break;
+        case 'r':
+            ok = (cfg.reps = atoi(optarg)) > 0;
+            break;
+        case 'w':
+            cfg.warmup = atoi(optarg);
+            ok = cfg.warmup >= 0;
+            break;
+        case 'f':
+            ok = strcmp(optarg, "csv") == 0 || strcmp(optarg, "json") == 0;
+            cfg.json = strcmp(optarg, "json") == 0;
+            break;
+        case 'o':
+            cfg.out = fopen(optarg, "w");
+            ok = cfg.out != NULL;
+            break;
+        case 's':
+            cfg.seed = strtoull(optarg, NULL, 10);
+            break;
+        case 'P':
+            cfg.profile = 1;
+            break;
+        case 'N':
+            cfg.numa = 1;
+            multi_partition_set_numa(1);
+            break;
+        default:
+            ok = 0;
+        }
+        if (!ok)
+        {
+            sweep_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    long long max_n = 0;
+    int max_np = 0;
+    for (int i = 0; i < cfg.n_count; i++)
+    {
+        max_n = cfg.n[i] > max_n ? cfg.n[i] : max_n;
+    }
+    for (int i = 0; i < cfg.np_count; i++)
+    {
+        max_np = cfg.np[i] > max_np ? cfg.np[i] : max_np;
+    }
+
+    // Buffers alocados uma única vez para a maior configuração, em páginas
+    // grandes já tocadas antes de qualquer medida
+    mp_arena_t *arena = mp_arena_create(0);
+    long long *Input = arena != NULL ? mp_arena_alloc(arena, (size_t)max_n * sizeof(long long)) : NULL;
+    long long *Output = arena != NULL ? mp_arena_alloc(arena, (size_t)max_n * sizeof(long long)) : NULL;
+    long long *Pos = create_pos_vector(max_np);
+    double *times = malloc(cfg.reps * sizeof(double));
+
+    if (Input == NULL || Output == NULL || Pos == NULL || times == NULL)
+    {
+        fprintf(stderr, "Erro ao alocar memória para os vetores.\n");
+        return 1;
+    }
+    mp_arena_prefault(arena, NULL);
+    fprintf(stderr, "# Input/Output: %zu MB em hugetlb, %zu MB em THP, %zu MB em páginas normais\n",
+            mp_arena_bytes(arena, MP_ARENA_PAGES_HUGETLB) >> 20, mp_arena_bytes(arena, MP_ARENA_PAGES_THP) >> 20,
+            mp_arena_bytes(arena, MP_ARENA_PAGES_SMALL) >> 20);
+
+    if (cfg.json)
+    {
+        fprintf(cfg.out, "[\n");
+    }
+    else
+    {
+        fprintf(cfg.out, "dist,n,np,threads,reps,min_s,median_s,p95_s,elements_per_s,gb_per_s,speedup,efficiency\n");
+    }
+
+    int first = 1;
+    for (int d = 0; d < cfg.dist_count; d++)
+    {
+        if (fill_distribution(Input, max_n, cfg.dist[d], cfg.seed) != 0)
+        {
+            fprintf(stderr, "Distribuição desconhecida: %s\n", cfg.dist[d]);
+            return 1;
+        }
+
+        for (int k = 0; k < cfg.np_count; k++)
+        {
+            int np = cfg.np[k];
+            long long *P = create_vector(np);
+            if (P != NULL && mp_gen_splitters(P, np, cfg.seed, 0) != 0)
+            {
+                destroy_vector(P);
+                P = NULL;
+            }
+
+            for (int i = 0; i < cfg.n_count; i++)
+            {
+                long long n = cfg.n[i];
+                double base_median = 0;
+                int base_threads = 0;
+
+                for (int t = 0; t < cfg.threads_count; t++)
+                {
+                    int nThreads = cfg.threads[t];
+                    sweep_stats_t st;
+
+                    if (P == NULL || sweep_run(&cfg, Input, n, P, np, Output, Pos, nThreads, times, &st) != 0)
+                    {
+                        fprintf(stderr, "Erro ao criar o plano (n=%lld, np=%d, threads=%d)\n", n, np, nThreads);
+                        return 1;
+                    }
+
+                    // Referência do speedup: primeira contagem de threads da lista
+                    if (t == 0)
+                    {
+                        base_median = st.median;
+                        base_threads = nThreads;
+                    }
+                    double speedup = base_median / st.median;
+                    double efficiency = speedup * base_threads / nThreads;
+                    double eps = n / st.median;
+                    double gbps = 16.0 * n / st.median / 1e9;
+
+                    if (cfg.json)
+                    {
+                        fprintf(cfg.out,
+                                "%s  {\"dist\": \"%s\", \"n\": %lld, \"np\": %d, \"threads\": %d, \"reps\": %d, "
+                                "\"min_s\": %.9f, \"median_s\": %.9f, \"p95_s\": %.9f, \"elements_per_s\": %.1f, "
+                                "\"gb_per_s\": %.3f, \"speedup\": %.3f, \"efficiency\": %.3f}",
+                                first ? "" : ",\n", cfg.dist[d], n, np, nThreads, cfg.reps,
+                                st.min, st.median, st.p95, eps, gbps, speedup, efficiency);
+                    }
+                    else
+                    {
+                        fprintf(cfg.out, "%s,%lld,%d,%d,%d,%.9f,%.9f,%.9f,%.1f,%.3f,%.3f,%.3f\n",
+                                cfg.dist[d], n, np, nThreads, cfg.reps,
+                                st.min, st.median, st.p95, eps, gbps, speedup, efficiency);
+                    }
+                    fflush(cfg.out);
+                    first = 0;
+                }
+            }
+            destroy_vector(P);
+        }
+    }
+
+    if (cfg.json)
+    {
+        fprintf(cfg.out, "\n]\n");
+    }
+    if (cfg.out != stdout)
+    {
+        fclose(cfg.out);
+    }
+
+    free(times);
+    mp_arena_destroy(arena);
+    destroy_pos_vector(Pos);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *mode = argc > 1 ? argv[1] : "sweep";
+
+    if (strcmp(mode, "sweep") == 0)
+    {
+        return bench_sweep(argc, argv);
+    }
+
+    int nThreads = argc > 2 ? atoi(argv[2]) : 4;
+    long long n = argc > 3 ? parse_size(argv[3]) : BENCH_SCATTER_N;
+    int ret;
+
+    if (nThreads <= 0 || n <= 0)
+    {
+        fprintf(stderr, "Uso: %s [sweep [opções] | latency|scatter|levels|search|predict|inplace|payload|stream|balance|verify|append|async [nThreads] [nTotalElements]]\n", argv[0]);
+        return 1;
+    }
+
+    if (strcmp(mode, "latency") == 0)
+    {
+        ret = bench_latency(nThreads);
+    }
+    else if (strcmp(mode, "scatter") == 0)
+    {
+        ret = bench_scatter(nThreads, n);
+    }
+    else if (strcmp(mode, "levels") == 0)
+    {
+        ret = bench_levels(nThreads, n);
+    }
+    else if (strcmp(mode, "search") == 0)
+    {
+        ret = bench_search(nThreads, n);
+    }
+    else if (strcmp(mode, "predict") == 0)
+    {
+        ret = bench_predict(nThreads, n);
+    }
+    else if (strcmp(mode, "inplace") == 0)
+    {
+        ret = bench_inplace(nThreads, n);
+    }
+    else if (strcmp(mode, "payload") == 0)
+    {
+        ret = bench_payload(nThreads, n);
+    }
+    else if (strcmp(mode, "stream") == 0)
+    {
+        ret = bench_stream(nThreads, n);
+    }
+    else if (strcmp(mode, "balance") == 0)
+    {
+        ret = bench_balance(nThreads, n);
+    }
+    else if (strcmp(mode, "verify") == 0)
+    {
+        ret = bench_verify(nThreads, n);
+    }
+    else if (strcmp(mode, "append") == 0)
+    {
+        ret = bench_append(nThreads, n);
+    }
+    else if (strcmp(mode, "async") == 0)
+    {
+        ret = bench_async(nThreads, n);
+    }
+    else
+    {
+        fprintf(stderr, "Uso: %s [sweep [opções] | latency|scatter|levels|search|predict|inplace|payload|stream|balance|verify|append|async [nThreads] [nTotalElements]]\n", argv[0]);
+        return 1;
+    }
+
+    multi_partition_shutdown();
+    return ret;
+}
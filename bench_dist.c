@@ -0,0 +1,221 @@
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mp_dist.h"
+#include "mp_gen.h"
+#include "mp_sort.h"
+
+#define DIST_N 4000000
+#define DIST_NP 1000
+#define DIST_ITERS 3
+
+/**
+ * Benchmark do particionamento distribuído. Cada rank gera o seu trecho da
+ * mesma sequência (o resultado não depende do número de ranks), as
+ * partições saem de uma amostra do rank 0 e `mp_dist_partition` roda sem
+ * pipeline (um bloco: particiona tudo, depois troca) e com blocos de
+ * MP_DIST_BLOCK_ELEMS. Para cada rank: elementos do shard e recebidos,
+ * fração enviada a outros ranks, tempos de particionamento, espera pela
+ * troca e montagem (melhor de DIST_ITERS execuções) e vazão do rank.
+ *
+ * Uso: mpirun -np 4 ./mp_bench_dist [nThreads] [n por rank] [np] [distribuição]
+ */
+
+// Medidas de um rank reunidas no rank 0
+enum
+{
+    STAT_N,
+    STAT_OUT,
+    STAT_SENT,
+    STAT_PARTITION,
+    STAT_EXCHANGE,
+    STAT_ASSEMBLE,
+    STAT_TOTAL,
+    STAT_COUNT
+};
+
+// Mesma mistura de chaves de mp_verify: soma e xor independem da ordem
+static unsigned long long dist_mix(long long key)
+{
+    unsigned long long z = (unsigned long long)key + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Confere as faixas do rank e, com todos os ranks, a permutação e Pos
+static int dist_check(MPI_Comm comm, const long long *Input, long long n, const long long *P, int np,
+                      const mp_dist_result_t *res)
+{
+    unsigned long long local[3] = {0, 0, 0}, global[3], out[3] = {0, 0, 0}, global_out[3];
+    int bad = 0, any_bad = 0;
+
+    for (long long i = 0; i < n; i++)
+    {
+        local[0] += dist_mix(Input[i]);
+        local[1] ^= dist_mix(Input[i]);
+    }
+    local[2] = (unsigned long long)n;
+    for (int j = 0; j < res->nranges; j++)
+    {
+        int g = res->first + j;
+        for (long long i = res->local_pos[j]; i < res->local_pos[j + 1]; i++)
+        {
+            long long v = res->Output[i];
+            bad |= (g > 0 && v < P[g - 1]) || (g < np - 1 && v >= P[g]);
+            out[0] += dist_mix(v);
+            out[1] ^= dist_mix(v);
+        }
+    }
+    out[2] = (unsigned long long)res->n;
+
+    MPI_Allreduce(local, global, 2, MPI_UNSIGNED_LONG_LONG, MPI_SUM, comm);
+    MPI_Allreduce(local + 1, global + 1, 1, MPI_UNSIGNED_LONG_LONG, MPI_BXOR, comm);
+    MPI_Allreduce(local + 2, global + 2, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, comm);
+    MPI_Allreduce(out, global_out, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, comm);
+    MPI_Allreduce(out + 1, global_out + 1, 1, MPI_UNSIGNED_LONG_LONG, MPI_BXOR, comm);
+    MPI_Allreduce(out + 2, global_out + 2, 1, MPI_UNSIGNED_LONG_LONG, MPI_SUM, comm);
+    bad |= memcmp(global, global_out, sizeof(global)) != 0;
+    bad |= res->Pos[0] != 0 || (np > 1 && res->Pos[np - 1] > (long long)global[2]);
+    MPI_Allreduce(&bad, &any_bad, 1, MPI_INT, MPI_MAX, comm);
+    return any_bad;
+}
+
+// Executa o particionamento DIST_ITERS vezes e guarda as medidas da melhor
+static int dist_run(MPI_Comm comm, long long *Input, long long n, long long *P, int np, int nThreads,
+                    long long block, double *stats, int *bad)
+{
+    double best = -1.0;
+
+    for (int it = 0; it < DIST_ITERS; it++)
+    {
+        mp_dist_result_t res;
+
+        MPI_Barrier(comm);
+        if (mp_dist_partition(comm, Input, n, P, np, nThreads, block, &res) != 0)
+        {
+            return -1;
+        }
+
+        // O tempo da execução é o do rank mais lento
+        double slowest;
+        MPI_Allreduce(&res.total_time, &slowest, 1, MPI_DOUBLE, MPI_MAX, comm);
+        if (best < 0.0 || slowest < best)
+        {
+            best = slowest;
+            stats[STAT_N] = (double)n;
+            stats[STAT_OUT] = (double)res.n;
+            stats[STAT_SENT] = (double)res.sent;
+            stats[STAT_PARTITION] = res.partition_time;
+            stats[STAT_EXCHANGE] = res.exchange_time;
+            stats[STAT_ASSEMBLE] = res.assemble_time;
+            stats[STAT_TOTAL] = res.total_time;
+        }
+        if (it == 0)
+        {
+            *bad |= dist_check(comm, Input, n, P, np, &res);
+        }
+        mp_dist_result_free(&res);
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int provided, rank, size;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+
+    int nThreads = argc > 1 ? atoi(argv[1]) : 1;
+    long long n = argc > 2 ? atoll(argv[2]) : DIST_N;
+    int np = argc > 3 ? atoi(argv[3]) : DIST_NP;
+    mp_gen_options_t opt = {MP_DIST_UNIFORM, 1, 0, 0, 0, 0};
+
+    if (nThreads <= 0 || n <= 0 || np <= 0 || (argc > 4 && mp_gen_parse_dist(argv[4], &opt.dist) != 0))
+    {
+        if (rank == 0)
+        {
+            fprintf(stderr, "Uso: mpirun -np <ranks> %s [nThreads] [n por rank] [np] [distribuição]\n", argv[0]);
+        }
+        MPI_Finalize();
+        return 1;
+    }
+
+    // Trecho [rank * n, (rank + 1) * n) da sequência global
+    opt.total = size * n;
+    long long *Input = malloc((size_t)n * sizeof(long long));
+    long long *P = malloc((size_t)np * sizeof(long long));
+    int failed = Input == NULL || P == NULL || mp_gen_fill(Input, n, rank * n, &opt, nThreads) != 0;
+    if (rank == 0 && !failed)
+    {
+        failed = mp_sample_splitters(Input, n, P, np, 1, nThreads) != 0;
+    }
+    int any_failed = 0;
+    MPI_Allreduce(&failed, &any_failed, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+    if (any_failed)
+    {
+        if (rank == 0)
+        {
+            fprintf(stderr, "Erro ao gerar os dados\n");
+        }
+        MPI_Finalize();
+        return 1;
+    }
+    MPI_Bcast(P, np, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+
+    const char *names[] = {"sem pipeline", "pipeline"};
+    long long blocks[] = {n, MP_DIST_BLOCK_ELEMS};
+    double stats[STAT_COUNT];
+    double *all = rank == 0 ? malloc((size_t)size * STAT_COUNT * sizeof(double)) : NULL;
+    int bad = 0, ret = 0;
+
+    if (rank == 0)
+    {
+        printf("# %d ranks, %d threads por rank, n=%lld por rank, np=%d (melhor de %d)\n", size, nThreads, n, np,
+               DIST_ITERS);
+    }
+    for (int m = 0; m < 2; m++)
+    {
+        if (dist_run(MPI_COMM_WORLD, Input, n, P, np, nThreads, blocks[m], stats, &bad) != 0)
+        {
+            ret = 1;
+            break;
+        }
+        MPI_Gather(stats, STAT_COUNT, MPI_DOUBLE, all, STAT_COUNT, MPI_DOUBLE, 0, MPI_COMM_WORLD);
+        if (rank != 0)
+        {
+            continue;
+        }
+
+        printf("\n%s (blocos de %lld elementos)\n", names[m], blocks[m]);
+        printf("%5s %12s %12s %8s %12s %12s %12s %12s %12s\n", "rank", "shard", "recebidos", "enviado", "part. ms",
+               "troca ms", "montagem ms", "total ms", "Melem/s");
+        double slowest = 0.0, total_n = 0.0, sent = 0.0;
+        for (int r = 0; r < size; r++)
+        {
+            double *s = all + (size_t)r * STAT_COUNT;
+            printf("%5d %12.0f %12.0f %7.1f%% %12.1f %12.1f %12.1f %12.1f %12.1f\n", r, s[STAT_N], s[STAT_OUT],
+                   100.0 * s[STAT_SENT] / s[STAT_N], 1000.0 * s[STAT_PARTITION], 1000.0 * s[STAT_EXCHANGE],
+                   1000.0 * s[STAT_ASSEMBLE], 1000.0 * s[STAT_TOTAL], s[STAT_N] / s[STAT_TOTAL] / 1e6);
+            slowest = s[STAT_TOTAL] > slowest ? s[STAT_TOTAL] : slowest;
+            total_n += s[STAT_N];
+            sent += s[STAT_SENT];
+        }
+        printf("total: %.0f elementos, %.1f MB trocados, %.1f ms, %.1f Melem/s\n", total_n,
+               sent * sizeof(long long) / 1e6, 1000.0 * slowest, total_n / slowest / 1e6);
+    }
+    if (rank == 0)
+    {
+        printf("\nverificação: %s\n", bad ? "ERRO" : "ok");
+    }
+
+    free(all);
+    free(Input);
+    free(P);
+    multi_partition_shutdown();
+    MPI_Finalize();
+    return ret | bad;
+}
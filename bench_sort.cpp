@@ -0,0 +1,103 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+extern "C"
+{
+#include "multi_partition.h"
+#include "mp_gen.h"
+#include "mp_sort.h"
+#include "util.h"
+}
+
+#define SORT_N 16000000
+#define SORT_NP 1000
+
+/**
+ * Compara `mp_sample_sort` com qsort e std::sort seriais em várias
+ * distribuições e mostra o equilíbrio das faixas com partições aleatórias
+ * (`mp_gen_splitters`) e com partições escolhidas por amostragem
+ * (`mp_sample_splitters`): maior faixa dividida por n / np.
+ */
+
+template <class F>
+static double time_ms(F run)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    run();
+    auto t1 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(t1 - t0).count();
+}
+
+// Maior faixa de Input com as partições P, relativa ao tamanho ideal n / np
+static double max_range_ratio(const std::vector<long long> &Input, std::vector<long long> &P, int nThreads)
+{
+    int np = (int)P.size();
+    long long n = (long long)Input.size();
+    std::vector<long long> In(Input), Output(n), Pos(np);
+
+    multi_partition(In.data(), n, P.data(), np, Output.data(), Pos.data(), nThreads);
+    long long largest = 0;
+    for (int j = 0; j < np; j++)
+    {
+        long long end = j + 1 < np ? Pos[j + 1] : n;
+        largest = std::max(largest, end - Pos[j]);
+    }
+    return (double)largest * np / n;
+}
+
+int main(int argc, char *argv[])
+{
+    int nThreads = argc > 1 ? atoi(argv[1]) : 4;
+    long long n = argc > 2 ? atoll(argv[2]) : SORT_N;
+    const char *dists[] = {"uniform", "zipf", "sorted", "reverse", "fewunique", "clustered"};
+    int ret = 0;
+
+    if (nThreads <= 0 || n <= 0)
+    {
+        fprintf(stderr, "Uso: %s [nThreads] [nTotalElements]\n", argv[0]);
+        return 1;
+    }
+
+    printf("# ordenação de n=%lld chaves, %d threads (ms); faixas com np=%d: maior faixa / (n/np)\n", n, nThreads,
+           SORT_NP);
+    printf("%-10s %10s %10s %12s %9s %9s %11s %11s %s\n", "dist", "qsort", "std::sort", "sample sort", "x qsort",
+           "x std", "P aleat.", "P amostra", "ok");
+
+    for (const char *name : dists)
+    {
+        mp_gen_options_t opt = {MP_DIST_UNIFORM, 1, 0, 0, 0, 0};
+        mp_gen_parse_dist(name, &opt.dist);
+
+        std::vector<long long> Input(n);
+        if (mp_gen_fill(Input.data(), n, 0, &opt, 0) != 0)
+        {
+            fprintf(stderr, "Erro ao gerar os dados\n");
+            return 1;
+        }
+
+        std::vector<long long> a(Input), b(Input), c(Input);
+        double qsort_ms = time_ms([&] { qsort(a.data(), n, sizeof(long long), compare_long_long); });
+        double std_ms = time_ms([&] { std::sort(b.begin(), b.end()); });
+        int sort_ret = 0;
+        double mp_ms = time_ms([&] { sort_ret = mp_sample_sort(c.data(), n, nThreads); });
+        bool ok = sort_ret == 0 && a == b && b == c;
+
+        std::vector<long long> P(SORT_NP), S(SORT_NP);
+        mp_gen_splitters(P.data(), SORT_NP, 1, 0);
+        mp_sample_splitters(Input.data(), n, S.data(), SORT_NP, 1, 0);
+        double random_ratio = max_range_ratio(Input, P, nThreads);
+        double sample_ratio = max_range_ratio(Input, S, nThreads);
+
+        printf("%-10s %10.1f %10.1f %12.1f %8.2fx %8.2fx %11.1f %11.1f %s\n", name, qsort_ms, std_ms, mp_ms,
+               qsort_ms / mp_ms, std_ms / mp_ms, random_ratio, sample_ratio, ok ? "ok" : "ERRO");
+        ret |= ok ? 0 : 1;
+    }
+
+    multi_partition_shutdown();
+    return ret;
+}
@@ -0,0 +1,204 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+extern "C"
+{
+#include "multi_partition.h"
+}
+#include "multi_partition.hpp"
+
+#define TPL_N 4000000
+#define TPL_ITERS 5
+
+/**
+ * Compara a versão genérica em C++ (`multi_partition.hpp`) com a função em
+ * C: para cada tipo de chave e np, mede o particionador com NP constante
+ * (escolhido por `mp::make_partitioner`) e com `mp::dynamic_np`, e confere
+ * Output e Pos contra uma referência sequencial estável.
+ */
+
+// Registro com chave e carga útil (classificado com um extrator de chave)
+struct record_t
+{
+    int64_t key;
+    int64_t payload;
+};
+
+struct record_key
+{
+    int64_t operator()(const record_t &r) const { return r.key; }
+};
+
+template <class Key>
+static Key random_key(std::mt19937_64 &rng)
+{
+    if constexpr (std::is_floating_point<Key>::value)
+    {
+        return std::uniform_real_distribution<Key>(-1e9, 1e9)(rng);
+    }
+    else
+    {
+        return (Key)rng();
+    }
+}
+
+// np - 1 separadores aleatórios ordenados e o último igual ao maior valor do tipo
+template <class Key>
+static std::vector<Key> random_splitters(int np, std::mt19937_64 &rng)
+{
+    std::vector<Key> P(np);
+    for (int i = 0; i < np - 1; i++)
+    {
+        P[i] = random_key<Key>(rng);
+    }
+    std::sort(P.begin(), P.end() - 1);
+    P[np - 1] = std::numeric_limits<Key>::max();
+    return P;
+}
+
+// Particionamento sequencial estável de referência
+template <class Key, class T, class KeyOf>
+static void reference(const std::vector<T> &Input, const std::vector<Key> &P, std::vector<T> &Output,
+                      std::vector<size_t> &Pos, KeyOf key_of)
+{
+    int np = (int)P.size();
+    std::vector<size_t> count(np, 0);
+    std::vector<int> ids(Input.size());
+
+    for (size_t i = 0; i < Input.size(); i++)
+    {
+        int id = (int)(std::upper_bound(P.begin(), P.end() - 1, key_of(Input[i])) - P.begin());
+        ids[i] = id;
+        count[id]++;
+    }
+    size_t base = 0;
+    for (int j = 0; j < np; j++)
+    {
+        Pos[j] = base;
+        base += count[j];
+    }
+    std::vector<size_t> next(Pos.begin(), Pos.end());
+    for (size_t i = 0; i < Input.size(); i++)
+    {
+        Output[next[ids[i]]++] = Input[i];
+    }
+}
+
+template <class F>
+static double best_ms(F run)
+{
+    double best = 1e30;
+
+    run(); // Aquecimento
+    for (int it = 0; it < TPL_ITERS; it++)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        run();
+        auto t1 = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+    return best;
+}
+
+template <class T>
+static bool same_output(const std::vector<T> &a, const std::vector<T> &b)
+{
+    return std::memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0;
+}
+
+template <class Key, class T = Key, class KeyOf = mp::key_identity<Key>>
+static int bench_type(const char *name, const std::vector<T> &Input, int np, int nThreads, std::mt19937_64 &rng,
+                      double c_ms)
+{
+    size_t n = Input.size();
+    std::vector<Key> P = random_splitters<Key>(np, rng);
+    std::vector<T> Output(n), Expected(n);
+    std::vector<size_t> Pos(np), ExpectedPos(np);
+
+    reference(Input, P, Expected, ExpectedPos, KeyOf());
+
+    auto fixed = mp::make_partitioner<Key, T, KeyOf>(P.data(), np, nThreads);
+    double fixed_ms = best_ms([&] { fixed->run(Input.data(), n, Output.data(), Pos.data()); });
+    bool ok = same_output(Output, Expected) && Pos == ExpectedPos;
+
+    mp::multi_partition<Key, mp::dynamic_np, T, KeyOf> dynamic(P.data(), np, nThreads);
+    double dynamic_ms = best_ms([&] { dynamic(Input.data(), n, Output.data(), Pos.data()); });
+    ok = ok && same_output(Output, Expected) && Pos == ExpectedPos;
+
+    printf("%-8s %6d %10.2f %10.2f ", name, np, fixed_ms, dynamic_ms);
+    if (c_ms > 0)
+    {
+        printf("%10.2f %7.2fx", c_ms, c_ms / fixed_ms);
+    }
+    else
+    {
+        printf("%10s %8s", "-", "-");
+    }
+    printf(" %s\n", ok ? "ok" : "ERRO");
+    return ok ? 0 : 1;
+}
+
+// Tempo da função em C (chaves long long) para o mesmo n e np
+static double bench_c(const std::vector<long long> &Input, int np, int nThreads, std::mt19937_64 &rng)
+{
+    std::vector<long long> P = random_splitters<long long>(np, rng);
+    std::vector<long long> In(Input), Output(Input.size());
+    std::vector<long long> Pos(np);
+
+    double ms = best_ms([&] {
+        multi_partition(In.data(), (long long)In.size(), P.data(), np, Output.data(), Pos.data(), nThreads);
+    });
+    multi_partition_shutdown();
+    return ms;
+}
+
+int main(int argc, char *argv[])
+{
+    int nThreads = argc > 1 ? atoi(argv[1]) : 4;
+    char *end = nullptr;
+    long long n = argc > 2 ? strtoll(argv[2], &end, 10) : TPL_N;
+    int nps[] = {8, 16, 32, 64, 256, 1000};
+    int ret = 0;
+
+    if (nThreads <= 0 || n <= 0 || (end != nullptr && (end == argv[2] || *end != '\0')))
+    {
+        fprintf(stderr, "Uso: %s [nThreads] [nTotalElements]\n", argv[0]);
+        return 1;
+    }
+
+    std::mt19937_64 rng(42);
+    std::vector<long long> keys64(n);
+    std::vector<int32_t> keys32(n);
+    std::vector<uint64_t> ukeys64(n);
+    std::vector<double> dkeys(n);
+    std::vector<record_t> records(n);
+    for (long long i = 0; i < n; i++)
+    {
+        keys64[i] = (long long)rng();
+        keys32[i] = (int32_t)rng();
+        ukeys64[i] = rng();
+        dkeys[i] = random_key<double>(rng);
+        records[i] = {(int64_t)rng(), i};
+    }
+
+    printf("# particionador C++ (n=%lld, %d threads, melhor de %d, ms)\n", n, nThreads, TPL_ITERS);
+    printf("%-8s %6s %10s %10s %10s %8s\n", "chave", "np", "NP fixo", "dinâmico", "C", "ganho");
+
+    for (int np : nps)
+    {
+        double c_ms = bench_c(keys64, np, nThreads, rng);
+        ret |= bench_type<int64_t>("int64", std::vector<int64_t>(keys64.begin(), keys64.end()), np, nThreads, rng,
+                                   c_ms);
+        ret |= bench_type<int32_t>("int32", keys32, np, nThreads, rng, 0);
+        ret |= bench_type<uint64_t>("uint64", ukeys64, np, nThreads, rng, 0);
+        ret |= bench_type<double>("double", dkeys, np, nThreads, rng, 0);
+        ret |= bench_type<int64_t, record_t, record_key>("record", records, np, nThreads, rng, 0);
+    }
+    return ret;
+}
@@ -4,6 +4,8 @@
 #include <stdio.h>
 
 #include "multi_partition.h"
+#include "mp_gen.h"
+#include "mp_sort.h"
 #include "util.h"
 #include "chrono.h"
 
@@ -13,23 +15,35 @@
 
 int main(int argc, char *argv[])
 {
-    int n, np, nThreads;
+    long long n;
+    int np, nThreads;
+    mp_gen_options_t gen = {MP_DIST_UNIFORM, 1, 0, 0, 0, 0}; // Distribuição e semente dos dados
 
     chronometer_t parallelReductionTime;
 
     // Verifica se o número correto de argumentos foi passado
-    if (argc != 4)
+    if (argc < 4 || argc > 6)
     {
-        fprintf(stderr, "Uso: %s <nTotalElements> <nPartitions> <nThreads>\n", argv[0]);
+        fprintf(stderr, "Uso: %s <nTotalElements> <nPartitions> <nThreads> [distribuição] [semente]\n", argv[0]);
+        fprintf(stderr, "  distribuições: uniform (padrão), zipf, sorted, reverse, fewunique, clustered\n");
         return 1;
     }
 
     // Converte os argumentos da linha de comando
-    n = atoi(argv[1]);        // Número total de elementos
+    n = atoll(argv[1]);       // Número total de elementos
     np = atoi(argv[2]);       // Número de partições
     nThreads = atoi(argv[3]); // Número de threads
     // np = 100000;       // Número de partições
     nThreads = atoi(argv[3]); // Número de threads
+    if (argc > 4 && mp_gen_parse_dist(argv[4], &gen.dist) != 0)
+    {
+        fprintf(stderr, "Erro: distribuição desconhecida: %s\n", argv[4]);
+        return 1;
+    }
+    if (argc > 5)
+    {
+        gen.seed = strtoull(argv[5], NULL, 10);
+    }
 
     // Validação dos argumentos
     if (n <= 0)
@@ -51,12 +65,23 @@ int main(int argc, char *argv[])
     }
 
     // Exibe os valores lidos
-    printf("Executando com %d elementos, %d partições e %d threads.\n", n, np, nThreads);
-
-    long long *Input = generate_random_vector(n, 0); // Vetor de entrada aleatório
-    long long *P = generate_random_vector(np, 1);    // Vetor de partições aleatório, ordenado
-    long long *Output = create_vector(n);            // Vetor de saída (não inicializado)
-    int *Pos = create_pos_vector(np);                // Vetor Pos com np + 1 posições
+    printf("Executando com %lld elementos, %d partições e %d threads (distribuição %s, semente %llu).\n", n, np,
+           nThreads, mp_gen_dist_name(gen.dist), gen.seed);
+
+    long long *Input = create_vector(n);  // Vetor de entrada (gerado em paralelo abaixo)
+    long long *P = create_vector(np);     // Vetor de partições (quantis de uma amostra de Input)
+    long long *Output = create_vector(n); // Vetor de saída (não inicializado)
+    long long *Pos = create_pos_vector(np); // Vetor Pos com np + 1 posições
+
+    // Mesmos dados para a mesma semente, com qualquer número de threads; as
+    // partições vêm dos quantis de uma amostra de Input, o que mantém as
+    // faixas equilibradas mesmo com dados enviesados
+    if (Input != NULL && P != NULL &&
+        (mp_gen_fill(Input, n, 0, &gen, 0) != 0 || mp_sample_splitters(Input, n, P, np, gen.seed, 0) != 0))
+    {
+        destroy_vector(Input);
+        Input = NULL;
+    }
 
     // Testa sucesso da alocação
     if (Input == NULL || P == NULL || Output == NULL || Pos == NULL)
@@ -97,7 +122,13 @@ int main(int argc, char *argv[])
     double OPS = ((double)n * NTIMES) / total_time_in_seconds;
     printf("Throughput: %lf OP/s\n", OPS);
 
+#ifdef MP_PROFILE
+    printf("\n");
+    multi_partition_profile_report(NULL, stdout);
+#endif
+
     // Limpa memória
+    multi_partition_shutdown();
     destroy_vector(Input);
     destroy_vector(P);
     destroy_vector(Output);
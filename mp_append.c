@@ -0,0 +1,346 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "mp_append.h"
+#include "thread_pool.h"
+
+// Intervalo [start, end) de n copiado pelo worker t
+static void append_chunk(long long n, int nThreads, int t, long long *start, long long *end)
+{
+    long long size = (n + nThreads - 1) / nThreads;
+    long long s = t * size, e = s + size;
+
+    *start = s > n ? n : s;
+    *end = e > n ? n : e;
+}
+
+// Faixa que contém a posição k (última j com Pos[j] <= k, pulando faixas vazias)
+static int append_range_of(const long long *Pos, int np, long long k)
+{
+    int left = 0, right = np - 1;
+
+    while (left < right)
+    {
+        int mid = left + (right - left + 1) / 2;
+        if (Pos[mid] <= k)
+        {
+            left = mid;
+        }
+        else
+        {
+            right = mid - 1;
+        }
+    }
+    return left;
+}
+
+// Garante espaço para `c` elementos do lote na faixa r (sem mudar len/count)
+static int append_reserve(mp_append_range_t *r, long long c)
+{
+    mp_append_chunk_t *tail = r->nchunks > 0 ? &r->chunks[r->nchunks - 1] : NULL;
+    long long room = tail != NULL ? tail->cap - tail->len : 0;
+
+    r->dst_chunk = tail != NULL && room > 0 ? r->nchunks - 1 : r->nchunks;
+    r->dst_off = tail != NULL && room > 0 ? tail->len : 0;
+    r->dst_room = room > 0 ? (room < c ? room : c) : c;
+    if (c <= room)
+    {
+        return 0;
+    }
+
+    // Trecho novo: capacidade ~ tamanho atual da faixa (crescimento geométrico)
+    long long need = c - (room > 0 ? room : 0);
+    long long cap = r->count + c;
+    cap = cap < MP_APPEND_MIN_CHUNK ? MP_APPEND_MIN_CHUNK : (cap > MP_APPEND_MAX_CHUNK ? MP_APPEND_MAX_CHUNK : cap);
+    cap = cap < need ? need : cap;
+
+    if (r->nchunks == r->max_chunks)
+    {
+        int max_chunks = r->max_chunks > 0 ? 2 * r->max_chunks : 4;
+        mp_append_chunk_t *chunks = realloc(r->chunks, max_chunks * sizeof(mp_append_chunk_t));
+        if (chunks == NULL)
+        {
+            return -1;
+        }
+        r->chunks = chunks;
+        r->max_chunks = max_chunks;
+    }
+
+    long long *data = malloc((size_t)cap * sizeof(long long));
+    if (data == NULL)
+    {
+        return -1;
+    }
+    r->chunks[r->nchunks++] = (mp_append_chunk_t){data, 0, cap};
+    return 0;
+}
+
+// Desfaz os trechos criados por append_reserve (trechos em uso nunca ficam vazios)
+static void append_unreserve(mp_append_range_t *r)
+{
+    if (r->nchunks > 0 && r->chunks[r->nchunks - 1].len == 0)
+    {
+        free(r->chunks[--r->nchunks].data);
+    }
+}
+
+// Copia uma fatia do lote particionado para os trechos reservados de cada faixa
+static void *thread_append_copy(void *arg)
+{
+    mp_append_task_t *task = (mp_append_task_t *)arg;
+    mp_append_t *st = task->store;
+    const long long *src = st->batch_out;
+    const long long *bpos = st->batch_pos;
+    int np = st->np;
+    long long k, end;
+
+    append_chunk(task->n, task->nThreads, task->id, &k, &end);
+    int j = k < end ? append_range_of(bpos, np, k) : np;
+    while (k < end)
+    {
+        mp_append_range_t *r = &st->ranges[j];
+        long long range_end = j + 1 < np ? bpos[j + 1] : task->n;
+        long long stop = range_end < end ? range_end : end;
+        long long o = k - bpos[j]; // Posição dentro da parte da faixa no lote
+
+        // Primeiro o que cabe no trecho de destino, depois o trecho novo
+        if (o < r->dst_room)
+        {
+            long long len = stop - k < r->dst_room - o ? stop - k : r->dst_room - o;
+            memcpy(r->chunks[r->dst_chunk].data + r->dst_off + o, src + k, (size_t)len * sizeof(long long));
+            k += len;
+            o += len;
+        }
+        if (k < stop)
+        {
+            memcpy(r->chunks[r->dst_chunk + 1].data + (o - r->dst_room), src + k,
+                   (size_t)(stop - k) * sizeof(long long));
+            k = stop;
+        }
+        j++;
+    }
+    return NULL;
+}
+
+// Copia uma fatia da visão concatenada para Output
+static void *thread_append_flatten(void *arg)
+{
+    mp_append_task_t *task = (mp_append_task_t *)arg;
+    const mp_append_t *st = task->store;
+    long long k, end;
+
+    append_chunk(st->n, task->nThreads, task->id, &k, &end);
+    int j = k < end ? append_range_of(st->Pos, st->np, k) : st->np;
+    while (k < end)
+    {
+        const mp_append_range_t *r = &st->ranges[j];
+        long long o = k - st->Pos[j];
+
+        for (int c = 0; c < r->nchunks && k < end; c++)
+        {
+            const mp_append_chunk_t *chunk = &r->chunks[c];
+            if (o >= chunk->len)
+            {
+                o -= chunk->len; // Trecho antes da fatia
+                continue;
+            }
+            long long len = chunk->len - o < end - k ? chunk->len - o : end - k;
+            memcpy(task->Output + k, chunk->data + o, (size_t)len * sizeof(long long));
+            k += len;
+            o = 0;
+        }
+        j++;
+    }
+    return NULL;
+}
+
+// Compacta as faixas pegas dinamicamente pelo worker
+static void *thread_append_compact(void *arg)
+{
+    mp_append_task_t *task = (mp_append_task_t *)arg;
+    mp_append_t *st = task->store;
+
+    for (;;)
+    {
+        int j = __atomic_fetch_add(&st->next, 1, __ATOMIC_RELAXED);
+        if (j >= st->np)
+        {
+            break;
+        }
+
+        mp_append_range_t *r = &st->ranges[j];
+        if (r->nchunks <= 1)
+        {
+            continue;
+        }
+
+        long long *data = malloc((size_t)r->count * sizeof(long long));
+        if (data == NULL)
+        {
+            task->error = 1;
+            continue;
+        }
+        long long off = 0;
+        for (int c = 0; c < r->nchunks; c++)
+        {
+            memcpy(data + off, r->chunks[c].data, (size_t)r->chunks[c].len * sizeof(long long));
+            off += r->chunks[c].len;
+            free(r->chunks[c].data);
+        }
+        r->chunks[0] = (mp_append_chunk_t){data, r->count, r->count};
+        r->nchunks = 1;
+    }
+    return NULL;
+}
+
+// Executa `task` em todos os workers do plano do armazenamento
+static int append_run(mp_append_t *st, thread_pool_task_t task, long long n, long long *Output)
+{
+    int nThreads = st->plan->nThreads;
+    int error = 0;
+
+    for (int t = 0; t < nThreads; t++)
+    {
+        st->tasks[t] = (mp_append_task_t){st, t, nThreads, n, Output, 0};
+    }
+    thread_pool_run(st->plan->pool, task, st->tasks, sizeof(mp_append_task_t));
+    for (int t = 0; t < nThreads; t++)
+    {
+        error |= st->tasks[t].error;
+    }
+    return error ? -1 : 0;
+}
+
+mp_append_t *mp_append_create(long long *P, int np, int nThreads, long long max_batch)
+{
+    if (P == NULL || np <= 0 || nThreads <= 0 || max_batch <= 0)
+    {
+        return NULL; // Parâmetros inválidos
+    }
+
+    mp_append_t *st = calloc(1, sizeof(mp_append_t));
+    if (st == NULL)
+    {
+        return NULL;
+    }
+
+    st->np = np;
+    st->max_batch = max_batch;
+    st->plan = multi_partition_plan_create(P, np, nThreads, max_batch);
+    st->batch_out = malloc((size_t)max_batch * sizeof(long long));
+    st->batch_pos = malloc(np * sizeof(long long));
+    st->ranges = calloc(np, sizeof(mp_append_range_t));
+    st->Pos = calloc(np, sizeof(long long));
+    st->tasks = malloc(nThreads * sizeof(mp_append_task_t));
+    if (st->plan == NULL || st->batch_out == NULL || st->batch_pos == NULL || st->ranges == NULL ||
+        st->Pos == NULL || st->tasks == NULL)
+    {
+        mp_append_destroy(st);
+        return NULL;
+    }
+    return st;
+}
+
+int mp_append_batch(mp_append_t *store, long long *batch, long long n)
+{
+    int np = store->np;
+
+    if (n < 0)
+    {
+        return -1;
+    }
+
+    // Lotes maiores que o plano são anexados em pedaços, na ordem
+    for (long long first = 0; first < n; first += store->max_batch)
+    {
+        long long len = n - first < store->max_batch ? n - first : store->max_batch;
+
+        if (multi_partition_execute(store->plan, batch + first, len, store->batch_out, store->batch_pos) != 0)
+        {
+            return -1;
+        }
+
+        // Espaço de cada faixa reservado antes da cópia (O(np))
+        for (int j = 0; j < np; j++)
+        {
+            long long c = (j + 1 < np ? store->batch_pos[j + 1] : len) - store->batch_pos[j];
+            if (append_reserve(&store->ranges[j], c) != 0)
+            {
+                for (int i = 0; i <= j; i++)
+                {
+                    append_unreserve(&store->ranges[i]);
+                }
+                return -1;
+            }
+        }
+
+        append_run(store, thread_append_copy, len, NULL);
+
+        // Tamanhos dos trechos, contagens e Pos
+        long long base = 0;
+        for (int j = 0; j < np; j++)
+        {
+            mp_append_range_t *r = &store->ranges[j];
+            long long c = (j + 1 < np ? store->batch_pos[j + 1] : len) - store->batch_pos[j];
+
+            if (c > 0)
+            {
+                long long first_part = c < r->dst_room ? c : r->dst_room;
+                r->chunks[r->dst_chunk].len += first_part;
+                if (c > first_part)
+                {
+                    r->chunks[r->dst_chunk + 1].len = c - first_part;
+                }
+                r->count += c;
+            }
+            store->Pos[j] = base;
+            base += r->count;
+        }
+        store->n = base;
+    }
+    return 0;
+}
+
+const mp_append_chunk_t *mp_append_range(const mp_append_t *store, int j, int *nchunks)
+{
+    *nchunks = store->ranges[j].nchunks;
+    return store->ranges[j].chunks;
+}
+
+void mp_append_flatten(mp_append_t *store, long long *Output)
+{
+    append_run(store, thread_append_flatten, store->n, Output);
+}
+
+int mp_append_compact(mp_append_t *store)
+{
+    store->next = 0;
+    return append_run(store, thread_append_compact, 0, NULL);
+}
+
+void mp_append_destroy(mp_append_t *store)
+{
+    if (store == NULL)
+    {
+        return;
+    }
+
+    if (store->ranges != NULL)
+    {
+        for (int j = 0; j < store->np; j++)
+        {
+            for (int c = 0; c < store->ranges[j].nchunks; c++)
+            {
+                free(store->ranges[j].chunks[c].data);
+            }
+            free(store->ranges[j].chunks);
+        }
+    }
+    multi_partition_plan_destroy(store->plan);
+    free(store->batch_out);
+    free(store->batch_pos);
+    free(store->ranges);
+    free(store->Pos);
+    free(store->tasks);
+    free(store);
+}
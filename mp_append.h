@@ -0,0 +1,150 @@
+#ifndef MP_APPEND_H
+#define MP_APPEND_H
+
+#include "multi_partition.h"
+
+/**
+ * Particionamento incremental: chaves que chegam em lotes são particionadas
+ * lote a lote com o mesmo P e anexadas a um armazenamento já particionado,
+ * em que cada faixa é uma lista de trechos. O custo de cada lote é
+ * proporcional ao tamanho do lote (mais O(np)), e não ao total acumulado.
+ */
+
+#define MP_APPEND_MIN_CHUNK 256       // Capacidade mínima de um trecho, em elementos.
+#define MP_APPEND_MAX_CHUNK (1 << 20) // Teto do crescimento geométrico dos trechos (8 MB).
+
+/**
+ * @brief Trecho contíguo de uma faixa.
+ */
+typedef struct
+{
+    long long *data; // Elementos do trecho.
+    long long len;   // Elementos ocupados.
+    long long cap;   // Capacidade.
+} mp_append_chunk_t;
+
+/**
+ * @brief Faixa do armazenamento: trechos em ordem de chegada.
+ */
+typedef struct
+{
+    mp_append_chunk_t *chunks; // Trechos (os elementos da faixa são a concatenação deles).
+    int nchunks;               // Trechos em uso.
+    int max_chunks;            // Capacidade do vetor de trechos.
+    long long count;           // Elementos da faixa.
+    int dst_chunk;             // [lote atual] Trecho que recebe o primeiro elemento do lote.
+    long long dst_off;         // [lote atual] Posição desse elemento no trecho.
+    long long dst_room;        // [lote atual] Elementos do lote que cabem nesse trecho.
+} mp_append_range_t;
+
+struct mp_append;
+
+/**
+ * @brief Argumento de cada worker na cópia de um lote ou na compactação.
+ */
+typedef struct
+{
+    struct mp_append *store;
+    int id;
+    int nThreads;
+    long long n;       // Elementos do lote.
+    long long *Output; // Destino de `mp_append_flatten`.
+    int error;         // Falha de alocação na compactação.
+} mp_append_task_t;
+
+/**
+ * @brief Armazenamento particionado que cresce por lotes.
+ *
+ * `Pos` e `n` formam a mesma visão de `multi_partition`: a faixa j ocupa as
+ * posições [Pos[j], Pos[j] + ranges[j].count) da concatenação das faixas,
+ * que é igual a `multi_partition` sobre todos os lotes concatenados (o
+ * particionamento de cada lote é estável e os lotes são anexados em ordem).
+ */
+typedef struct mp_append
+{
+    multi_partition_plan_t *plan; // Plano do particionamento de cada lote (e pool dos workers).
+    int np;                       // Número de partições.
+    long long max_batch;          // Maior lote particionado de uma vez.
+    long long *batch_out;         // Lote particionado.
+    long long *batch_pos;         // Início de cada faixa no lote.
+    mp_append_range_t *ranges;    // Faixas do armazenamento.
+    long long *Pos;               // Início de cada faixa na visão concatenada.
+    long long n;                  // Elementos acumulados.
+    mp_append_task_t *tasks;      // Argumentos dos workers.
+    int next;                     // Próxima faixa da compactação.
+} mp_append_t;
+
+/**
+ * @brief Cria um armazenamento vazio para as np faixas de P.
+ *
+ * @param P Vetor de partições (ordenado, P[np-1] = LLONG_MAX); deve continuar válido.
+ * @param np Número de partições.
+ * @param nThreads Workers do particionamento e da cópia de cada lote.
+ * @param max_batch Maior lote particionado de uma vez (lotes maiores são
+ *                  divididos, sem mudar o resultado).
+ * @return mp_append_t* Armazenamento ou NULL em caso de falha.
+ */
+mp_append_t *mp_append_create(long long *P, int np, int nThreads, long long max_batch);
+
+/**
+ * @brief Particiona um lote e o anexa às faixas do armazenamento.
+ *
+ * @param store Armazenamento.
+ * @param batch Lote de n chaves.
+ * @param n Número de elementos do lote.
+ * @return int 0 em caso de sucesso ou -1 em caso de falha de alocação (o
+ *             armazenamento fica como antes do pedaço de max_batch
+ *             elementos que falhou).
+ *
+ * O lote é particionado com o plano do armazenamento; em seguida, uma
+ * passada O(np) garante espaço no último trecho de cada faixa (ou cria um
+ * trecho novo, com capacidade que dobra com o tamanho da faixa até
+ * MP_APPEND_MAX_CHUNK, de modo que cada faixa tem O(log) trechos) e os
+ * workers copiam fatias iguais do lote particionado para os trechos.
+ * Por fim, `Pos` é atualizado em O(np).
+ */
+int mp_append_batch(mp_append_t *store, long long *batch, long long n);
+
+/**
+ * @brief Trechos da faixa j.
+ *
+ * @param store Armazenamento.
+ * @param j Faixa.
+ * @param nchunks Número de trechos (saída).
+ * @return const mp_append_chunk_t* Trechos em ordem; os elementos da faixa
+ *         são os `len` primeiros de cada um. Válido até o próximo lote ou
+ *         compactação.
+ */
+const mp_append_chunk_t *mp_append_range(const mp_append_t *store, int j, int *nchunks);
+
+/**
+ * @brief Copia em paralelo o armazenamento para Output, como em `multi_partition`.
+ *
+ * @param store Armazenamento.
+ * @param Output Vetor de `store->n` elementos; as faixas começam em `store->Pos`.
+ *
+ * O custo é proporcional ao total acumulado: é a forma de entregar o
+ * resultado a quem espera um vetor contíguo, não uma operação por lote.
+ */
+void mp_append_flatten(mp_append_t *store, long long *Output);
+
+/**
+ * @brief Junta os trechos de cada faixa em um único trecho.
+ *
+ * @param store Armazenamento.
+ * @return int 0 em caso de sucesso ou -1 em caso de falha de alocação
+ *             (as faixas já compactadas continuam válidas).
+ *
+ * Opcional (o crescimento geométrico já limita o número de trechos) e de
+ * custo proporcional ao total: deve ser chamada entre lotes, quando houver
+ * tempo livre, para que cada faixa volte a ser contígua. As faixas são
+ * divididas dinamicamente entre os workers.
+ */
+int mp_append_compact(mp_append_t *store);
+
+/**
+ * @brief Libera o armazenamento, seus trechos e o plano.
+ */
+void mp_append_destroy(mp_append_t *store);
+
+#endif // MP_APPEND_H
@@ -0,0 +1,216 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "mp_arena.h"
+
+#define ROUND_UP(x, a) (((x) + (a) - 1) & ~((size_t)(a) - 1))
+
+// Argumento de cada worker em `mp_arena_prefault`
+typedef struct
+{
+    mp_arena_t *arena;
+    int id;
+    int nThreads;
+} prefault_task_t;
+
+// Mapeia uma região de `size` bytes (múltiplo de 2 MB)
+static char *map_region(size_t size, mp_arena_pages_t *pages)
+{
+#ifdef __linux__
+    char *p;
+
+#ifdef MAP_HUGETLB
+    // Páginas de 2 MB reservadas pelo administrador (vm.nr_hugepages)
+    p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED)
+    {
+        *pages = MP_ARENA_PAGES_HUGETLB;
+        return p;
+    }
+#endif
+
+    // Mapeamento alinhado a 2 MB para que o kernel possa usar THP
+    size_t span = size + MP_ARENA_HUGE_PAGE;
+    p = mmap(NULL, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+    {
+        return NULL;
+    }
+
+    char *base = (char *)ROUND_UP((uintptr_t)p, MP_ARENA_HUGE_PAGE);
+    if (base > p)
+    {
+        munmap(p, base - p);
+    }
+    if (base + size < p + span)
+    {
+        munmap(base + size, p + span - (base + size));
+    }
+
+    *pages = MP_ARENA_PAGES_SMALL;
+#ifdef MADV_HUGEPAGE
+    if (madvise(base, size, MADV_HUGEPAGE) == 0)
+    {
+        *pages = MP_ARENA_PAGES_THP;
+    }
+#endif
+    return base;
+#else
+    *pages = MP_ARENA_PAGES_SMALL;
+    return calloc(1, size);
+#endif
+}
+
+static void unmap_region(mp_arena_region_t *r)
+{
+#ifdef __linux__
+    munmap(r->base, r->size);
+#else
+    free(r->base);
+#endif
+}
+
+mp_arena_t *mp_arena_create(size_t region_size)
+{
+    mp_arena_t *arena = (mp_arena_t *)calloc(1, sizeof(mp_arena_t));
+    if (arena == NULL)
+    {
+        return NULL;
+    }
+
+    arena->region_size = ROUND_UP(region_size > 0 ? region_size : MP_ARENA_HUGE_PAGE, MP_ARENA_HUGE_PAGE);
+    return arena;
+}
+
+void *mp_arena_alloc(mp_arena_t *arena, size_t bytes)
+{
+    bytes = ROUND_UP(bytes > 0 ? bytes : 1, MP_ARENA_ALIGN);
+
+    mp_arena_region_t **tail = &arena->regions;
+    for (mp_arena_region_t *r = arena->regions; r != NULL; r = r->next)
+    {
+        if (r->size - r->used >= bytes)
+        {
+            void *p = r->base + r->used;
+            r->used += bytes;
+            return p;
+        }
+        tail = &r->next;
+    }
+
+    // Nenhuma região comporta o bloco: mapeia uma nova no fim da lista
+    mp_arena_region_t *r = (mp_arena_region_t *)calloc(1, sizeof(mp_arena_region_t));
+    if (r == NULL)
+    {
+        return NULL;
+    }
+
+    r->size = bytes > arena->region_size ? ROUND_UP(bytes, MP_ARENA_HUGE_PAGE) : arena->region_size;
+    r->base = map_region(r->size, &r->pages);
+    if (r->base == NULL)
+    {
+        free(r);
+        return NULL;
+    }
+
+    r->used = bytes;
+    *tail = r;
+    arena->mapped += r->size;
+    return r->base;
+}
+
+static void *thread_prefault(void *arg)
+{
+    prefault_task_t *task = (prefault_task_t *)arg;
+    long page = sysconf(_SC_PAGESIZE);
+
+    for (mp_arena_region_t *r = task->arena->regions; r != NULL; r = r->next)
+    {
+        if (r->prefaulted)
+        {
+            continue;
+        }
+
+        // Fatia contígua de páginas da região para cada worker
+        size_t npages = r->size / page;
+        size_t lo = npages * task->id / task->nThreads;
+        size_t hi = npages * (task->id + 1) / task->nThreads;
+        for (size_t i = lo; i < hi; i++)
+        {
+            ((volatile char *)r->base)[i * page] = 0;
+        }
+    }
+    return NULL;
+}
+
+void mp_arena_prefault(mp_arena_t *arena, thread_pool_t *pool)
+{
+    int nThreads = pool != NULL ? pool->nThreads : 1;
+    prefault_task_t *tasks = malloc(nThreads * sizeof(prefault_task_t));
+
+    if (tasks != NULL)
+    {
+        for (int t = 0; t < nThreads; t++)
+        {
+            tasks[t] = (prefault_task_t){arena, t, nThreads};
+        }
+        if (pool != NULL)
+        {
+            thread_pool_run(pool, thread_prefault, tasks, sizeof(prefault_task_t));
+        }
+        else
+        {
+            thread_prefault(tasks);
+        }
+        free(tasks);
+    }
+
+    // Sem memória para as tarefas, as páginas são tocadas no primeiro uso
+    for (mp_arena_region_t *r = arena->regions; r != NULL; r = r->next)
+    {
+        r->prefaulted = 1;
+    }
+}
+
+void mp_arena_reset(mp_arena_t *arena)
+{
+    for (mp_arena_region_t *r = arena->regions; r != NULL; r = r->next)
+    {
+        r->used = 0;
+    }
+}
+
+size_t mp_arena_bytes(const mp_arena_t *arena, mp_arena_pages_t pages)
+{
+    size_t bytes = 0;
+
+    for (const mp_arena_region_t *r = arena->regions; r != NULL; r = r->next)
+    {
+        bytes += r->pages == pages ? r->size : 0;
+    }
+    return bytes;
+}
+
+void mp_arena_destroy(mp_arena_t *arena)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    mp_arena_region_t *r = arena->regions;
+    while (r != NULL)
+    {
+        mp_arena_region_t *next = r->next;
+        unmap_region(r);
+        free(r);
+        r = next;
+    }
+    free(arena);
+}
@@ -0,0 +1,98 @@
+#ifndef MP_ARENA_H
+#define MP_ARENA_H
+
+#include <stddef.h>
+
+#include "thread_pool.h"
+
+#define MP_ARENA_ALIGN 64                   // Alinhamento de todos os blocos (linha de cache).
+#define MP_ARENA_HUGE_PAGE (2 * 1024 * 1024) // Tamanho da página grande usada nas regiões.
+
+/**
+ * @brief Tipo de página de uma região da arena.
+ */
+typedef enum
+{
+    MP_ARENA_PAGES_SMALL = 0, // Páginas normais (fallback).
+    MP_ARENA_PAGES_THP,       // Transparent huge pages pedidas com madvise(MADV_HUGEPAGE).
+    MP_ARENA_PAGES_HUGETLB    // Páginas de 2 MB reservadas (MAP_HUGETLB).
+} mp_arena_pages_t;
+
+/**
+ * @brief Região contígua mapeada pela arena.
+ */
+typedef struct mp_arena_region
+{
+    char *base;                   // Início da região (alinhado a 2 MB quando possível).
+    size_t size;                  // Tamanho mapeado.
+    size_t used;                  // Bytes já entregues desde o último reset.
+    mp_arena_pages_t pages;       // Tipo de página da região.
+    int prefaulted;               // Páginas já tocadas por `mp_arena_prefault`.
+    struct mp_arena_region *next; // Próxima região.
+} mp_arena_region_t;
+
+/**
+ * @brief Arena de blocos alinhados a 64 bytes sobre regiões de páginas grandes.
+ *
+ * Os blocos são entregues sequencialmente dentro de regiões grandes e nunca
+ * são liberados individualmente: `mp_arena_reset` torna toda a memória
+ * disponível de novo sem devolvê-la ao sistema, de modo que as páginas já
+ * mapeadas (e já tocadas) são reaproveitadas pelas próximas alocações.
+ */
+typedef struct
+{
+    mp_arena_region_t *regions; // Regiões mapeadas.
+    size_t region_size;         // Tamanho mínimo de uma região nova.
+    size_t mapped;              // Total de bytes mapeados.
+} mp_arena_t;
+
+/**
+ * @brief Cria uma arena vazia.
+ *
+ * @param region_size Tamanho mínimo de cada região (0 = uma página grande).
+ * @return mp_arena_t* Arena ou NULL em caso de falha.
+ */
+mp_arena_t *mp_arena_create(size_t region_size);
+
+/**
+ * @brief Entrega um bloco de `bytes` alinhado a 64 bytes.
+ *
+ * @param arena Arena.
+ * @param bytes Tamanho do bloco (arredondado para múltiplo de 64, de modo que
+ *              blocos vizinhos nunca compartilham uma linha de cache).
+ * @return void* Bloco ou NULL se não for possível mapear uma nova região.
+ *
+ * Usa o primeiro espaço livre nas regiões existentes; se nenhum comporta o
+ * bloco, mapeia uma nova região tentando, nesta ordem, MAP_HUGETLB,
+ * madvise(MADV_HUGEPAGE) e páginas normais.
+ */
+void *mp_arena_alloc(mp_arena_t *arena, size_t bytes);
+
+/**
+ * @brief Toca, em paralelo, as páginas das regiões ainda não tocadas.
+ *
+ * @param arena Arena.
+ * @param pool Workers que dividem as páginas entre si (NULL = thread atual).
+ *
+ * Evita que as falhas de página aconteçam dentro das fases medidas. Regiões
+ * já tocadas (inclusive as reaproveitadas após `mp_arena_reset`) são
+ * ignoradas. O conteúdo das regiões novas continua zerado.
+ */
+void mp_arena_prefault(mp_arena_t *arena, thread_pool_t *pool);
+
+/**
+ * @brief Torna toda a memória da arena disponível novamente, sem desmapeá-la.
+ */
+void mp_arena_reset(mp_arena_t *arena);
+
+/**
+ * @brief Bytes mapeados pela arena com o tipo de página `pages`.
+ */
+size_t mp_arena_bytes(const mp_arena_t *arena, mp_arena_pages_t pages);
+
+/**
+ * @brief Desmapeia todas as regiões e libera a arena (pode ser NULL).
+ */
+void mp_arena_destroy(mp_arena_t *arena);
+
+#endif // MP_ARENA_H
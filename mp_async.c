@@ -0,0 +1,611 @@
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "multi_partition.h"
+#include "mp_async.h"
+
+#define ASYNC_SEARCH_CHUNK 256      // Chaves por chamada da busca em lote.
+#define ASYNC_BATCH_MIN_BLOCKS 512  // Mesmo limiar da busca em lote de multi_partition.c.
+
+// Intervalo [start, end) de n tratado pelo worker t
+static void async_chunk(long long n, int nThreads, int t, long long *start, long long *end)
+{
+    long long size = (n + nThreads - 1) / nThreads;
+    long long s = t * size, e = s + size;
+
+    *start = s > n ? n : s;
+    *end = e > n ? n : e;
+}
+
+// Tenta publicar uma unidade; 0 se o anel está cheio (produtor único)
+static int ring_push(mp_async_t *as, int morsel, long long end)
+{
+    unsigned long pos = as->head;
+    mp_async_slot_t *slot = &as->ring[pos & as->ring_mask];
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos)
+    {
+        return 0; // A posição ainda guarda uma unidade da volta anterior
+    }
+    slot->morsel = morsel;
+    slot->end = end;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+    as->head = pos + 1;
+    return 1;
+}
+
+// Tenta retirar uma unidade; 0 se o anel está vazio
+static int ring_pop(mp_async_t *as, int *morsel, long long *end)
+{
+    unsigned long pos = __atomic_load_n(&as->tail, __ATOMIC_RELAXED);
+
+    for (;;)
+    {
+        mp_async_slot_t *slot = &as->ring[pos & as->ring_mask];
+        unsigned long seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        long diff = (long)(seq - (pos + 1));
+
+        if (diff < 0)
+        {
+            return 0;
+        }
+        if (diff > 0)
+        {
+            pos = __atomic_load_n(&as->tail, __ATOMIC_RELAXED); // Outro worker levou esta posição
+            continue;
+        }
+        if (__atomic_compare_exchange_n(&as->tail, &pos, pos + 1, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+        {
+            *morsel = slot->morsel;
+            *end = slot->end;
+            __atomic_store_n(&slot->seq, pos + as->ring_mask + 1, __ATOMIC_RELEASE); // Livre para a próxima volta
+            return 1;
+        }
+    }
+}
+
+// Há unidade pronta na cabeça do anel?
+static int ring_ready(mp_async_t *as)
+{
+    unsigned long pos = __atomic_load_n(&as->tail, __ATOMIC_RELAXED);
+    return __atomic_load_n(&as->ring[pos & as->ring_mask].seq, __ATOMIC_ACQUIRE) == pos + 1;
+}
+
+// Publica uma unidade, cedendo a CPU aos workers enquanto o anel está cheio
+static void async_publish(mp_async_t *as, int morsel, long long end)
+{
+    while (!ring_push(as, morsel, end))
+    {
+        as->full_waits++;
+        sched_yield();
+    }
+
+    // Par com async_park: ou o worker vê a unidade, ou aqui se vê o worker estacionado
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&as->sleepers, __ATOMIC_RELAXED) > 0)
+    {
+        pthread_mutex_lock(&as->mutex);
+        pthread_cond_signal(&as->wake);
+        pthread_mutex_unlock(&as->mutex);
+    }
+}
+
+// Faixas de `count` chaves (até ASYNC_SEARCH_CHUNK). Com dois níveis, a
+// mesma busca de `multi_partition`: super-faixa no índice de super_P, depois
+// a faixa no índice da super-faixa
+static void async_search(const mp_async_t *as, const long long *values, int count, int *ids)
+{
+    const splitter_index_t *index = as->index;
+
+    if (index->nblocks >= ASYNC_BATCH_MIN_BLOCKS)
+    {
+        splitter_index_search_batch(index, values, count, ids);
+    }
+    else
+    {
+        for (int k = 0; k < count; k++)
+        {
+            ids[k] = splitter_index_search(index, values[k]);
+        }
+    }
+
+    // Valores >= P[np-1] pertencem à última faixa
+    int last = as->nsuper - 1;
+    if (as->levels == 1)
+    {
+        for (int k = 0; k < count; k++)
+        {
+            ids[k] = ids[k] < last ? ids[k] : last;
+        }
+        return;
+    }
+    for (int k = 0; k < count; k++)
+    {
+        int g = ids[k] < last ? ids[k] : last;
+        int first = g * as->stride;
+        int len = as->np - first < as->stride ? as->np - first : as->stride;
+        int sub = splitter_index_search(as->sub_index[g], values[k]);
+        ids[k] = first + (sub < len ? sub : len - 1);
+    }
+}
+
+// Classifica a unidade m, guardando a faixa de cada elemento em T
+#define ASYNC_CLASSIFY(type)                                                          \
+    do                                                                                \
+    {                                                                                 \
+        type *T = (type *)as->T;                                                      \
+        for (long long i = start; i < end; i += ASYNC_SEARCH_CHUNK)                   \
+        {                                                                             \
+            int c = end - i < ASYNC_SEARCH_CHUNK ? (int)(end - i) : ASYNC_SEARCH_CHUNK; \
+            async_search(as, Input + i, c, ids);                                      \
+            for (int k = 0; k < c; k++)                                               \
+            {                                                                         \
+                T[i + k] = (type)ids[k];                                              \
+                counts[ids[k]]++;                                                     \
+            }                                                                         \
+        }                                                                             \
+    } while (0)
+
+static void async_classify(mp_async_t *as, mp_async_task_t *task, int m, long long end)
+{
+    const long long *Input = as->Input;
+    long long *counts = as->counts + (size_t)m * as->np;
+    long long start = (long long)m * as->morsel;
+    int *ids = task->ids;
+
+    memset(counts, 0, as->np * sizeof(long long));
+    switch (as->id_bytes)
+    {
+    case 1:
+        ASYNC_CLASSIFY(unsigned char);
+        break;
+    case 2:
+        ASYNC_CLASSIFY(unsigned short);
+        break;
+    default:
+        ASYNC_CLASSIFY(int);
+        break;
+    }
+}
+
+// Escreve a unidade m a partir dos deslocamentos da sua linha: em Output
+// (um nível) ou, pela super-faixa, em Tmp junto com o índice da faixa
+#define ASYNC_SCATTER(type)                                            \
+    do                                                                 \
+    {                                                                  \
+        const type *T = (const type *)as->T;                           \
+        if (as->levels == 1)                                           \
+        {                                                              \
+            for (long long i = start; i < end; i++)                    \
+            {                                                          \
+                as->Output[offsets[T[i]]++] = Input[i];                \
+            }                                                          \
+            break;                                                     \
+        }                                                              \
+        type *TmpT = (type *)as->TmpT;                                 \
+        for (long long i = start; i < end; i++)                        \
+        {                                                              \
+            int id = T[i];                                             \
+            long long k = offsets[id / stride * stride]++;             \
+            as->Tmp[k] = Input[i];                                     \
+            TmpT[k] = (type)id;                                        \
+        }                                                              \
+    } while (0)
+
+static void async_scatter(mp_async_t *as, int m)
+{
+    const long long *Input = as->Input;
+    long long *offsets = as->counts + (size_t)m * as->np;
+    long long start = (long long)m * as->morsel;
+    long long end = start + as->morsel < as->n ? start + as->morsel : as->n;
+    int stride = as->stride;
+
+    switch (as->id_bytes)
+    {
+    case 1:
+        ASYNC_SCATTER(unsigned char);
+        break;
+    case 2:
+        ASYNC_SCATTER(unsigned short);
+        break;
+    default:
+        ASYNC_SCATTER(int);
+        break;
+    }
+}
+
+// Segundo nível: distribui a super-faixa s de Tmp entre as suas faixas finais
+#define ASYNC_REFINE(type)                                         \
+    do                                                             \
+    {                                                              \
+        const type *TmpT = (const type *)as->TmpT;                 \
+        for (long long k = start; k < end; k++)                    \
+        {                                                          \
+            as->Output[cursor[TmpT[k] - first]++] = as->Tmp[k];    \
+        }                                                          \
+    } while (0)
+
+static void async_refine(mp_async_t *as, mp_async_task_t *task, int s)
+{
+    int first = s * as->stride;
+    int last = first + as->stride < as->np ? first + as->stride : as->np;
+    long long start = as->Pos[first];
+    long long end = last < as->np ? as->Pos[last] : as->n;
+    long long *cursor = task->cursor;
+
+    memcpy(cursor, as->Pos + first, (size_t)(last - first) * sizeof(long long));
+    switch (as->id_bytes)
+    {
+    case 1:
+        ASYNC_REFINE(unsigned char);
+        break;
+    case 2:
+        ASYNC_REFINE(unsigned short);
+        break;
+    default:
+        ASYNC_REFINE(int);
+        break;
+    }
+}
+
+// Fechamento da rodada, executado por todos os workers
+static void async_finish(mp_async_t *as, mp_async_task_t *task)
+{
+    int np = as->np, nmorsels = as->published, stride = as->stride;
+    long long *Pos = as->Pos;
+    long long j0, j1;
+
+    // Todas as unidades foram classificadas
+    pthread_barrier_wait(&as->barrier);
+
+    // Total de cada faixa do trecho do worker
+    async_chunk(np, as->nThreads, task->id, &j0, &j1);
+    for (long long j = j0; j < j1; j++)
+    {
+        long long total = 0;
+        for (int m = 0; m < nmorsels; m++)
+        {
+            total += as->counts[(size_t)m * np + j];
+        }
+        Pos[j] = total;
+    }
+    pthread_barrier_wait(&as->barrier);
+
+    if (task->id == 0)
+    {
+        long long base = 0;
+        for (int j = 0; j < np; j++)
+        {
+            long long c = Pos[j];
+            Pos[j] = base;
+            base += c;
+        }
+    }
+    pthread_barrier_wait(&as->barrier);
+
+    // Contagens de cada unidade viram deslocamentos (unidades em ordem de
+    // chegada), um por super-faixa, guardado na posição da sua primeira faixa
+    // (com um nível, a super-faixa é a própria faixa)
+    long long g0, g1;
+    async_chunk(as->nsuper, as->nThreads, task->id, &g0, &g1);
+    for (long long g = g0; g < g1; g++)
+    {
+        int first = (int)g * stride;
+        int last = first + stride < np ? first + stride : np;
+        long long off = Pos[first];
+        for (int m = 0; m < nmorsels; m++)
+        {
+            long long *row = as->counts + (size_t)m * np;
+            long long count = 0;
+            for (int j = first; j < last; j++)
+            {
+                count += row[j];
+            }
+            row[first] = off;
+            off += count;
+        }
+    }
+    pthread_barrier_wait(&as->barrier);
+
+    int m;
+    while ((m = __atomic_fetch_add(&as->next_scatter, 1, __ATOMIC_RELAXED)) < nmorsels)
+    {
+        async_scatter(as, m);
+    }
+    pthread_barrier_wait(&as->barrier);
+
+    if (as->levels == 2)
+    {
+        int s;
+        while ((s = __atomic_fetch_add(&as->next_super, 1, __ATOMIC_RELAXED)) < as->nsuper)
+        {
+            async_refine(as, task, s);
+        }
+        pthread_barrier_wait(&as->barrier);
+    }
+
+    if (task->id == 0)
+    {
+        // Nova rodada a partir do início de Input
+        as->n = 0;
+        as->published = 0;
+
+        pthread_mutex_lock(&as->future.mutex);
+        as->future.status = 0;
+        as->future.done = 1;
+        pthread_cond_broadcast(&as->future.cond);
+        pthread_mutex_unlock(&as->future.mutex);
+    }
+}
+
+// Estaciona o worker até haver unidade pronta, fechamento ou encerramento
+static void async_park(mp_async_t *as, mp_async_task_t *task)
+{
+    pthread_mutex_lock(&as->mutex);
+    __atomic_add_fetch(&as->sleepers, 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    while (!ring_ready(as) && as->close_gen == task->done_gen && !as->shutdown)
+    {
+        pthread_cond_wait(&as->wake, &as->mutex);
+    }
+    __atomic_sub_fetch(&as->sleepers, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&as->mutex);
+}
+
+static void *thread_async_worker(void *arg)
+{
+    mp_async_task_t *task = (mp_async_task_t *)arg;
+    mp_async_t *as = task->as;
+
+    for (;;)
+    {
+        int m;
+        long long end;
+
+        if (ring_pop(as, &m, &end))
+        {
+            async_classify(as, task, m, end);
+            continue;
+        }
+
+        // O fechamento só é publicado depois da última unidade: com o anel
+        // vazio depois de vê-lo, todas as unidades da rodada já foram retiradas
+        if (__atomic_load_n(&as->close_gen, __ATOMIC_ACQUIRE) != task->done_gen)
+        {
+            if (ring_pop(as, &m, &end))
+            {
+                async_classify(as, task, m, end);
+                continue;
+            }
+            async_finish(as, task);
+            task->done_gen++;
+            continue;
+        }
+        if (__atomic_load_n(&as->shutdown, __ATOMIC_ACQUIRE))
+        {
+            break;
+        }
+        async_park(as, task);
+    }
+    return NULL;
+}
+
+mp_async_t *mp_async_create(long long *P, int np, int nThreads, long long max_n, int ring_slots)
+{
+    if (P == NULL || np <= 0 || nThreads <= 0 || max_n < 0)
+    {
+        return NULL;
+    }
+
+    mp_async_t *as = calloc(1, sizeof(mp_async_t));
+    if (as == NULL)
+    {
+        return NULL;
+    }
+    pthread_barrier_init(&as->barrier, NULL, nThreads);
+    pthread_mutex_init(&as->mutex, NULL);
+    pthread_cond_init(&as->wake, NULL);
+    pthread_mutex_init(&as->future.mutex, NULL);
+    pthread_cond_init(&as->future.cond, NULL);
+    as->future.done = 1; // Nenhuma rodada em andamento
+
+    // No mínimo 2 posições: com uma só, seq == pos + 1 significaria ao mesmo
+    // tempo "unidade pronta" e "livre para a próxima volta"
+    unsigned long slots = 2;
+    ring_slots = ring_slots > 0 ? ring_slots : MP_ASYNC_RING_SLOTS;
+    while (slots < (unsigned long)ring_slots)
+    {
+        slots <<= 1;
+    }
+
+    as->np = np;
+    as->nThreads = nThreads;
+    as->max_n = max_n;
+    // Unidades de pelo menos 4 * np elementos: as contagens por unidade (zeradas,
+    // somadas e transformadas em deslocamentos no fim) custam no máximo 1/4
+    // de uma passada pelos dados
+    as->morsel = 4LL * np > MP_ASYNC_MORSEL ? 4LL * np : MP_ASYNC_MORSEL;
+    as->max_morsels = (int)((max_n + as->morsel - 1) / as->morsel);
+    as->id_bytes = np <= 256 ? 1 : (np <= 65536 ? 2 : 4);
+
+    // Dois níveis (busca e escrita) quando multi_partition também os usaria:
+    // np faixas de uma vez passam da L1 e da TLB
+    as->levels = multi_partition_levels(np);
+    as->stride = 1;
+    while (as->levels == 2 && as->stride * as->stride < np)
+    {
+        as->stride++; // ceil(sqrt(np))
+    }
+    as->nsuper = (np + as->stride - 1) / as->stride;
+    as->ring_mask = slots - 1;
+
+    // A super-faixa g reúne as faixas [g * stride, (g + 1) * stride)
+    int sub_ok = 1;
+    if (as->levels == 2)
+    {
+        as->super_P = malloc(as->nsuper * sizeof(long long));
+        as->sub_index = calloc(as->nsuper, sizeof(splitter_index_t *));
+        for (int g = 0; as->super_P != NULL && as->sub_index != NULL && g < as->nsuper; g++)
+        {
+            int first = g * as->stride;
+            int len = np - first < as->stride ? np - first : as->stride;
+            as->super_P[g] = P[first + len - 1];
+            as->sub_index[g] = splitter_index_create(P + first, len);
+            sub_ok &= as->sub_index[g] != NULL;
+        }
+        sub_ok &= as->super_P != NULL && as->sub_index != NULL;
+    }
+    as->index = sub_ok ? splitter_index_create(as->levels == 2 ? as->super_P : P, as->nsuper) : NULL;
+    as->Input = malloc((size_t)(max_n > 0 ? max_n : 1) * sizeof(long long));
+    as->T = malloc((size_t)(max_n > 0 ? max_n : 1) * as->id_bytes);
+    as->counts = malloc(((size_t)as->max_morsels * np + 1) * sizeof(long long));
+    if (as->levels == 2)
+    {
+        as->Tmp = malloc((size_t)(max_n > 0 ? max_n : 1) * sizeof(long long));
+        as->TmpT = malloc((size_t)(max_n > 0 ? max_n : 1) * as->id_bytes);
+    }
+    as->ring = malloc(slots * sizeof(mp_async_slot_t));
+    as->threads = calloc(nThreads, sizeof(pthread_t));
+    as->tasks = calloc(nThreads, sizeof(mp_async_task_t));
+    if (as->index == NULL || as->Input == NULL || as->T == NULL || as->counts == NULL || as->ring == NULL ||
+        (as->levels == 2 && (as->Tmp == NULL || as->TmpT == NULL)) || as->threads == NULL || as->tasks == NULL)
+    {
+        as->nThreads = 0; // Nenhum worker criado
+        mp_async_destroy(as);
+        return NULL;
+    }
+    for (unsigned long s = 0; s < slots; s++)
+    {
+        as->ring[s].seq = s;
+    }
+
+    for (int t = 0; t < nThreads; t++)
+    {
+        mp_async_task_t *task = &as->tasks[t];
+        task->as = as;
+        task->id = t;
+        task->ids = malloc(ASYNC_SEARCH_CHUNK * sizeof(int));
+        task->cursor = malloc(as->stride * sizeof(long long));
+        if (task->ids == NULL || task->cursor == NULL ||
+            pthread_create(&as->threads[t], NULL, thread_async_worker, task) != 0)
+        {
+            // Encerra os workers já criados (nenhuma rodada começou)
+            free(task->ids);
+            free(task->cursor);
+            as->nThreads = t;
+            mp_async_destroy(as);
+            return NULL;
+        }
+    }
+    return as;
+}
+
+int mp_async_submit(mp_async_t *as, const long long *block, long long len)
+{
+    if (len < 0 || len > as->max_n - as->n)
+    {
+        return -1;
+    }
+
+    while (len > 0)
+    {
+        long long limit = (long long)(as->published + 1) * as->morsel;
+        long long c = limit - as->n < len ? limit - as->n : len;
+
+        memcpy(as->Input + as->n, block, (size_t)c * sizeof(long long));
+        as->n += c;
+        block += c;
+        len -= c;
+        if (as->n == limit)
+        {
+            async_publish(as, as->published, as->n);
+            as->published++;
+        }
+    }
+    return 0;
+}
+
+mp_async_future_t *mp_async_close(mp_async_t *as, long long *Output, long long *Pos)
+{
+    if (as->n > (long long)as->published * as->morsel)
+    {
+        async_publish(as, as->published, as->n); // Última unidade, incompleta
+        as->published++;
+    }
+
+    as->Output = Output;
+    as->Pos = Pos;
+    as->next_scatter = 0;
+    as->next_super = 0;
+    pthread_mutex_lock(&as->future.mutex);
+    as->future.done = 0;
+    pthread_mutex_unlock(&as->future.mutex);
+
+    pthread_mutex_lock(&as->mutex);
+    __atomic_store_n(&as->close_gen, as->close_gen + 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&as->wake);
+    pthread_mutex_unlock(&as->mutex);
+    return &as->future;
+}
+
+int mp_async_wait(mp_async_future_t *future)
+{
+    pthread_mutex_lock(&future->mutex);
+    while (!future->done)
+    {
+        pthread_cond_wait(&future->cond, &future->mutex);
+    }
+    int status = future->status;
+    pthread_mutex_unlock(&future->mutex);
+    return status;
+}
+
+int mp_async_test(mp_async_future_t *future)
+{
+    pthread_mutex_lock(&future->mutex);
+    int done = future->done;
+    pthread_mutex_unlock(&future->mutex);
+    return done;
+}
+
+void mp_async_destroy(mp_async_t *as)
+{
+    if (as == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&as->mutex);
+    __atomic_store_n(&as->shutdown, 1, __ATOMIC_RELEASE);
+    pthread_cond_broadcast(&as->wake);
+    pthread_mutex_unlock(&as->mutex);
+    for (int t = 0; t < as->nThreads; t++)
+    {
+        pthread_join(as->threads[t], NULL);
+        free(as->tasks[t].ids);
+        free(as->tasks[t].cursor);
+    }
+    pthread_barrier_destroy(&as->barrier);
+    pthread_mutex_destroy(&as->mutex);
+    pthread_cond_destroy(&as->wake);
+    pthread_mutex_destroy(&as->future.mutex);
+    pthread_cond_destroy(&as->future.cond);
+
+    splitter_index_destroy(as->index);
+    for (int g = 0; as->sub_index != NULL && g < as->nsuper; g++)
+    {
+        splitter_index_destroy(as->sub_index[g]);
+    }
+    free(as->sub_index);
+    free(as->super_P);
+    free(as->Input);
+    free(as->T);
+    free(as->Tmp);
+    free(as->TmpT);
+    free(as->counts);
+    free(as->ring);
+    free(as->threads);
+    free(as->tasks);
+    free(as);
+}
@@ -0,0 +1,180 @@
+#ifndef MP_ASYNC_H
+#define MP_ASYNC_H
+
+#include <pthread.h>
+
+#include "splitter_index.h"
+
+/**
+ * Particionamento assíncrono: as chaves chegam em blocos por
+ * `mp_async_submit` e são classificadas e contadas pelos workers enquanto os
+ * blocos seguintes ainda estão chegando; `mp_async_close` dispara o prefix
+ * sum e a escrita em Output e devolve um futuro. Quando os dados chegam aos
+ * poucos (rede, disco, outro estágio), só a parte final do trabalho fica
+ * depois do último bloco.
+ */
+
+#define MP_ASYNC_MORSEL (1 << 16) // Elementos de cada unidade de trabalho (512 KB; no mínimo 4 * np).
+#define MP_ASYNC_RING_SLOTS 64    // Capacidade padrão do anel, em unidades de trabalho.
+
+/**
+ * @brief Posição do anel: unidade de trabalho publicada pelo produtor.
+ *
+ * `seq` segue o protocolo de fila limitada com números de sequência por
+ * posição: seq == pos significa posição livre para a volta pos, seq == pos + 1
+ * significa unidade pronta para ser consumida.
+ */
+typedef struct
+{
+    unsigned long seq; // Número de sequência (atômico).
+    int morsel;        // Unidade de trabalho.
+    long long end;     // Fim da unidade em Input (a última pode ser menor).
+} mp_async_slot_t;
+
+/**
+ * @brief Futuro de uma rodada: fica pronto quando Output e Pos estão completos.
+ */
+typedef struct
+{
+    pthread_mutex_t mutex; // Protege `done`.
+    pthread_cond_t cond;   // Sinaliza o fim da rodada.
+    int done;              // Rodada concluída.
+    int status;            // 0 em caso de sucesso.
+} mp_async_future_t;
+
+struct mp_async;
+
+/**
+ * @brief Argumento de cada worker.
+ */
+typedef struct
+{
+    struct mp_async *as;
+    int id;
+    unsigned long done_gen; // Rodadas já concluídas por este worker.
+    int *ids;               // Índices de faixa da busca em lote.
+    long long *cursor;      // Posições das faixas de uma super-faixa (segundo nível).
+} mp_async_task_t;
+
+/**
+ * @brief Particionador assíncrono com workers próprios.
+ *
+ * Input é dividido em unidades de trabalho (morsels) de `morsel` elementos,
+ * em ordem de chegada. Cada unidade tem a sua linha em `counts`, então o
+ * resultado é estável e igual ao de `multi_partition` sobre a concatenação
+ * dos blocos, seja qual for o worker que classificou cada unidade.
+ */
+typedef struct mp_async
+{
+    splitter_index_t *index; // Índice de busca sobre P (ou super_P, com dois níveis).
+    int np;                  // Número de partições.
+    int nThreads;            // Workers.
+    long long max_n;         // Maior número de elementos de uma rodada.
+    long long morsel;        // Elementos por unidade de trabalho.
+    int max_morsels;         // Unidades de uma rodada com max_n elementos.
+    long long *Input;        // Blocos recebidos, concatenados.
+    void *T;                 // Faixa de cada elemento de Input (1, 2 ou 4 bytes).
+    int id_bytes;            // Tamanho de cada índice em T.
+    long long *counts;       // Contagem de (unidade, faixa); vira deslocamento no fim.
+    int levels;              // Níveis da busca e da escrita (`multi_partition_levels(np)`).
+    int stride;              // Faixas por super-faixa (1 com um nível).
+    int nsuper;              // Número de super-faixas.
+    long long *super_P;      // [dois níveis] Partições das super-faixas.
+    splitter_index_t **sub_index; // [dois níveis] Índice das faixas de cada super-faixa.
+    long long *Tmp;          // [dois níveis] Elementos agrupados por super-faixa.
+    void *TmpT;              // [dois níveis] Faixa de cada elemento de Tmp.
+
+    mp_async_slot_t *ring;   // Anel limitado de unidades prontas.
+    unsigned long ring_mask; // Capacidade do anel - 1 (potência de 2).
+    unsigned long head;      // Próxima posição do produtor.
+    unsigned long tail;      // Próxima posição dos consumidores (atômico).
+    long long n;             // Elementos recebidos na rodada.
+    int published;           // Unidades publicadas na rodada.
+    long long full_waits;    // Vezes em que o produtor esperou por espaço no anel.
+
+    long long *Output; // Destino da rodada fechada.
+    long long *Pos;    // Início de cada faixa em Output.
+    int next_scatter;  // Próxima unidade da escrita (atômico).
+    int next_super;    // Próxima super-faixa do segundo nível (atômico).
+
+    pthread_t *threads;        // Workers.
+    mp_async_task_t *tasks;    // Argumentos dos workers.
+    pthread_barrier_t barrier; // Fases do fechamento.
+    pthread_mutex_t mutex;     // Protege o estacionamento dos workers.
+    pthread_cond_t wake;       // Unidade nova, fechamento ou encerramento.
+    int sleepers;              // Workers estacionados (atômico).
+    unsigned long close_gen;   // Rodadas fechadas.
+    int shutdown;              // Encerra os workers.
+    mp_async_future_t future;  // Futuro da rodada atual.
+} mp_async_t;
+
+/**
+ * @brief Cria um particionador assíncrono e inicia os workers.
+ *
+ * @param P Vetor de partições (ordenado, P[np-1] = LLONG_MAX).
+ * @param np Número de partições.
+ * @param nThreads Workers (ficam estacionados enquanto não há blocos).
+ * @param max_n Maior número de elementos de uma rodada.
+ * @param ring_slots Capacidade do anel em unidades de trabalho (<= 0 =
+ *                   MP_ASYNC_RING_SLOTS; arredondada para potência de 2,
+ *                   no mínimo 2).
+ * @return mp_async_t* Particionador ou NULL em caso de falha.
+ */
+mp_async_t *mp_async_create(long long *P, int np, int nThreads, long long max_n, int ring_slots);
+
+/**
+ * @brief Entrega um bloco de chaves à rodada atual.
+ *
+ * @param as Particionador.
+ * @param block Bloco de len chaves (copiado; pode ser reutilizado no retorno).
+ * @param len Número de elementos do bloco.
+ * @return int 0 em caso de sucesso ou -1 se a rodada passaria de max_n.
+ *
+ * O bloco é copiado para o fim de Input e cada unidade de trabalho que fica
+ * completa é publicada no anel, sem trava; se o anel está cheio (os workers
+ * estão atrasados), o produtor cede a CPU até haver espaço. A ordem das
+ * chamadas define a concatenação, então há um único produtor por rodada.
+ */
+int mp_async_submit(mp_async_t *as, const long long *block, long long len);
+
+/**
+ * @brief Fecha a rodada: publica o resto e dispara prefix sum e escrita.
+ *
+ * @param as Particionador.
+ * @param Output Vetor com espaço para todos os elementos da rodada.
+ * @param Pos Vetor (tamanho np) com o início de cada faixa em Output.
+ * @return mp_async_future_t* Futuro da rodada (`mp_async_wait`/`mp_async_test`).
+ *
+ * Retorna sem esperar. Os workers terminam as unidades pendentes, somam as
+ * contagens de cada faixa, transformam as contagens de cada unidade em
+ * deslocamentos e escrevem as unidades em Output com os índices de faixa
+ * guardados na classificação (sem nova busca). Quando `multi_partition`
+ * usaria dois níveis, aqui também: a classificação busca a super-faixa
+ * (~sqrt(np) faixas vizinhas) e depois a faixa dentro dela, e a escrita
+ * passa por Tmp, agrupada por super-faixa, antes de Output. Uma nova rodada
+ * pode começar depois que o futuro fica pronto.
+ */
+mp_async_future_t *mp_async_close(mp_async_t *as, long long *Output, long long *Pos);
+
+/**
+ * @brief Espera o fim da rodada.
+ *
+ * @return int 0 em caso de sucesso.
+ */
+int mp_async_wait(mp_async_future_t *future);
+
+/**
+ * @brief Indica, sem esperar, se a rodada terminou.
+ *
+ * @return int 1 se Output e Pos estão prontos, 0 caso contrário.
+ */
+int mp_async_test(mp_async_future_t *future);
+
+/**
+ * @brief Encerra os workers e libera o particionador (pode ser NULL).
+ *
+ * Não deve ser chamada com uma rodada fechada e ainda não concluída.
+ */
+void mp_async_destroy(mp_async_t *as);
+
+#endif // MP_ASYNC_H
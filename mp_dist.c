@@ -0,0 +1,286 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mp_dist.h"
+#include "thread_pool.h"
+
+// Estado da montagem de Output, compartilhado pelos workers
+typedef struct
+{
+    mp_dist_result_t *res;
+    long long **rbuf;        // Dados recebidos em cada bloco.
+    const long long *counts; // Contagem de (bloco, origem, faixa do rank).
+    const long long *src;    // Posição em rbuf[bloco] de cada (bloco, origem, faixa do rank).
+    int nblocks;
+    int size;
+    int next; // Próxima faixa livre (atômico).
+} dist_assemble_t;
+
+// Argumento de cada worker da montagem
+typedef struct
+{
+    dist_assemble_t *shared;
+} dist_task_t;
+
+void mp_dist_ranges(int np, int size, int rank, int *first, int *count)
+{
+    int start = (int)((long long)rank * np / size);
+    int end = (int)((long long)(rank + 1) * np / size);
+
+    *first = start;
+    *count = end - start;
+}
+
+// Cada worker pega faixas do rank e copia seus pedaços na ordem global:
+// rank de origem, depois bloco
+static void *thread_dist_assemble(void *arg)
+{
+    dist_assemble_t *a = ((dist_task_t *)arg)->shared;
+    mp_dist_result_t *res = a->res;
+    int nown = res->nranges;
+
+    for (;;)
+    {
+        int j = __atomic_fetch_add(&a->next, 1, __ATOMIC_RELAXED);
+        if (j >= nown)
+        {
+            break;
+        }
+
+        long long cursor = res->local_pos[j];
+        for (int s = 0; s < a->size; s++)
+        {
+            for (int b = 0; b < a->nblocks; b++)
+            {
+                size_t k = ((size_t)b * a->size + s) * nown + j;
+                long long c = a->counts[k];
+                if (c > 0)
+                {
+                    memcpy(res->Output + cursor, a->rbuf[b] + a->src[k], (size_t)c * sizeof(long long));
+                    cursor += c;
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+// Falha em algum rank? (todos chegam à mesma resposta)
+static int dist_any_failed(MPI_Comm comm, int failed)
+{
+    int any = 0;
+    MPI_Allreduce(&failed, &any, 1, MPI_INT, MPI_MAX, comm);
+    return any;
+}
+
+int mp_dist_partition(MPI_Comm comm, long long *Input, long long n, long long *P, int np, int nThreads,
+                      long long block, mp_dist_result_t *res)
+{
+    double t_start = MPI_Wtime();
+    int rank, size;
+
+    MPI_Comm_rank(comm, &rank);
+    MPI_Comm_size(comm, &size);
+    memset(res, 0, sizeof(mp_dist_result_t));
+
+    // Blocos de pelo menos np elementos (as contagens guardadas por bloco não
+    // passam do tamanho dos dados); os deslocamentos do MPI são int: um bloco
+    // recebido de todos os ranks cabe em INT_MAX
+    block = block > 0 ? block : MP_DIST_BLOCK_ELEMS;
+    block = block < np ? np : block;
+    block = block > INT_MAX / size ? INT_MAX / size : block;
+
+    // Mesmo número de blocos em todos os ranks (shards menores mandam blocos vazios)
+    long long local_blocks = (n + block - 1) / block, nblocks = 0;
+    MPI_Allreduce(&local_blocks, &nblocks, 1, MPI_LONG_LONG, MPI_MAX, comm);
+
+    int *first = malloc((size + 1) * sizeof(int));
+    int *owned = malloc(size * sizeof(int));
+    mp_dist_ranges(np, size, rank, &res->first, &res->nranges);
+    int nown = res->nranges;
+
+    long long max_block = n < block ? (n > 0 ? n : 1) : block;
+    multi_partition_plan_t *plan = np > 0 && n >= 0 ? multi_partition_plan_create(P, np, nThreads, max_block) : NULL;
+    long long *stage[2] = {malloc((size_t)max_block * sizeof(long long)), malloc((size_t)max_block * sizeof(long long))};
+    long long *bpos = malloc((size_t)(np + 1) * sizeof(long long));
+    long long *bcounts = malloc((size_t)np * sizeof(long long));
+    long long *local_counts = calloc(np > 0 ? np : 1, sizeof(long long));
+    int *scount = malloc(2 * size * sizeof(int)), *sdispl = malloc(2 * size * sizeof(int));
+    int *rcount = malloc(2 * size * sizeof(int)), *rdispl = malloc(2 * size * sizeof(int));
+    int *ccount = malloc(size * sizeof(int)), *cdispl = malloc(size * sizeof(int));
+    int *crcount = malloc(size * sizeof(int)), *crdispl = malloc(size * sizeof(int));
+    long long **rbuf = calloc(nblocks > 0 ? nblocks : 1, sizeof(long long *));
+    long long *counts = malloc(((size_t)nblocks * size * nown + 1) * sizeof(long long));
+    long long *src = malloc(((size_t)nblocks * size * nown + 1) * sizeof(long long));
+    res->Pos = malloc((size_t)(np > 0 ? np : 1) * sizeof(long long));
+    res->local_pos = malloc((size_t)(nown + 1) * sizeof(long long));
+    MPI_Request req[2] = {MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+    int ret = -1;
+
+    int failed = plan == NULL || first == NULL || owned == NULL || stage[0] == NULL || stage[1] == NULL ||
+                 bpos == NULL || bcounts == NULL || local_counts == NULL || scount == NULL || sdispl == NULL ||
+                 rcount == NULL || rdispl == NULL || ccount == NULL || cdispl == NULL || crcount == NULL ||
+                 crdispl == NULL || rbuf == NULL || counts == NULL || src == NULL || res->Pos == NULL ||
+                 res->local_pos == NULL;
+    if (dist_any_failed(comm, failed))
+    {
+        goto done;
+    }
+
+    for (int d = 0; d < size; d++)
+    {
+        mp_dist_ranges(np, size, d, &first[d], &owned[d]);
+        ccount[d] = owned[d]; // Contagens das faixas de d, que ficam contíguas em bcounts
+        cdispl[d] = first[d];
+        crcount[d] = nown; // De cada origem chegam as contagens das faixas deste rank
+        crdispl[d] = d * nown;
+    }
+    first[size] = np;
+
+    res->nblocks = (int)nblocks;
+    for (long long b = 0; b < nblocks; b++)
+    {
+        int s = (int)(b % 2);
+        long long off = b * block < n ? b * block : n;
+        long long len = n - off < block ? n - off : block;
+
+        // O stage deste bloco foi enviado dois blocos atrás
+        double t = MPI_Wtime();
+        MPI_Wait(&req[s], MPI_STATUS_IGNORE);
+        res->exchange_time += MPI_Wtime() - t;
+
+        t = MPI_Wtime();
+        multi_partition_execute(plan, Input + off, len, stage[s], bpos);
+        bpos[np] = len;
+        for (int j = 0; j < np; j++)
+        {
+            bcounts[j] = bpos[j + 1] - bpos[j];
+            local_counts[j] += bcounts[j];
+        }
+        res->partition_time += MPI_Wtime() - t;
+
+        // As faixas de cada destino são contíguas no bloco particionado
+        for (int d = 0; d < size; d++)
+        {
+            scount[s * size + d] = (int)(bpos[first[d + 1]] - bpos[first[d]]);
+            sdispl[s * size + d] = (int)bpos[first[d]];
+            res->sent += d != rank ? scount[s * size + d] : 0;
+        }
+
+        // Contagens por faixa (pequenas, bloqueante); a chamada também faz o
+        // bloco anterior progredir
+        t = MPI_Wtime();
+        long long *bc = counts + (size_t)b * size * nown;
+        MPI_Alltoallv(bcounts, ccount, cdispl, MPI_LONG_LONG, bc, crcount, crdispl, MPI_LONG_LONG, comm);
+
+        long long total = 0;
+        for (int d = 0; d < size; d++)
+        {
+            long long from_d = 0;
+            for (int j = 0; j < nown; j++)
+            {
+                src[(size_t)b * size * nown + (size_t)d * nown + j] = total + from_d;
+                from_d += bc[(size_t)d * nown + j];
+            }
+            rcount[s * size + d] = (int)from_d;
+            rdispl[s * size + d] = (int)total;
+            total += from_d;
+        }
+        rbuf[b] = malloc((size_t)(total > 0 ? total : 1) * sizeof(long long));
+        if (rbuf[b] == NULL)
+        {
+            MPI_Abort(comm, 1); // Os outros ranks já esperam por este bloco
+        }
+
+        // Dados do bloco em voo enquanto o próximo é particionado
+        MPI_Ialltoallv(stage[s], scount + s * size, sdispl + s * size, MPI_LONG_LONG, rbuf[b], rcount + s * size,
+                       rdispl + s * size, MPI_LONG_LONG, comm, &req[s]);
+        res->exchange_time += MPI_Wtime() - t;
+    }
+
+    double t = MPI_Wtime();
+    MPI_Waitall(2, req, MPI_STATUSES_IGNORE);
+
+    // Pos global: soma das contagens de todos os ranks
+    MPI_Allreduce(local_counts, res->Pos, np, MPI_LONG_LONG, MPI_SUM, comm);
+    res->exchange_time += MPI_Wtime() - t;
+
+    long long base = 0;
+    for (int j = 0; j < np; j++)
+    {
+        long long c = res->Pos[j];
+        res->Pos[j] = base;
+        base += c;
+    }
+    for (int j = 0; j < nown; j++)
+    {
+        int g = res->first + j;
+        res->local_pos[j] = res->Pos[g] - res->Pos[res->first];
+    }
+    res->n = nown > 0 ? (res->first + nown < np ? res->Pos[res->first + nown] : base) - res->Pos[res->first] : 0;
+    res->local_pos[nown] = res->n;
+
+    // Montagem de Output em paralelo pelos workers do plano
+    t = MPI_Wtime();
+    res->Output = malloc((size_t)(res->n > 0 ? res->n : 1) * sizeof(long long));
+    dist_task_t *tasks = malloc(plan->nThreads * sizeof(dist_task_t));
+    if (dist_any_failed(comm, res->Output == NULL || tasks == NULL))
+    {
+        free(tasks);
+        goto done;
+    }
+    dist_assemble_t assemble = {res, rbuf, counts, src, (int)nblocks, size, 0};
+    for (int i = 0; i < plan->nThreads; i++)
+    {
+        tasks[i].shared = &assemble;
+    }
+    thread_pool_run(plan->pool, thread_dist_assemble, tasks, sizeof(dist_task_t));
+    free(tasks);
+    res->assemble_time = MPI_Wtime() - t;
+    ret = 0;
+
+done:
+    if (rbuf != NULL)
+    {
+        for (long long b = 0; b < nblocks; b++)
+        {
+            free(rbuf[b]);
+        }
+    }
+    free(rbuf);
+    free(counts);
+    free(src);
+    free(first);
+    free(owned);
+    free(stage[0]);
+    free(stage[1]);
+    free(bpos);
+    free(bcounts);
+    free(local_counts);
+    free(scount);
+    free(sdispl);
+    free(rcount);
+    free(rdispl);
+    free(ccount);
+    free(cdispl);
+    free(crcount);
+    free(crdispl);
+    multi_partition_plan_destroy(plan);
+    if (ret != 0)
+    {
+        mp_dist_result_free(res);
+    }
+    res->total_time = MPI_Wtime() - t_start;
+    return ret;
+}
+
+void mp_dist_result_free(mp_dist_result_t *res)
+{
+    free(res->Output);
+    free(res->Pos);
+    free(res->local_pos);
+    res->Output = NULL;
+    res->Pos = NULL;
+    res->local_pos = NULL;
+}
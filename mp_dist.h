@@ -0,0 +1,76 @@
+#ifndef MP_DIST_H
+#define MP_DIST_H
+
+#include <mpi.h>
+
+#include "multi_partition.h"
+
+/**
+ * Particionamento distribuído (MPI): cada rank tem um pedaço (shard) de
+ * Input e, no fim, recebe as faixas das quais é dono, como se
+ * `multi_partition` tivesse sido executado sobre a concatenação dos shards
+ * em ordem de rank. Compilado só com mpicc (`make mp_bench_dist`).
+ */
+
+#define MP_DIST_BLOCK_ELEMS (1LL << 20) // Elementos de cada bloco do pipeline (8 MB).
+
+/**
+ * @brief Resultado do particionamento distribuído em um rank.
+ */
+typedef struct
+{
+    long long *Output;    // Faixas do rank, concatenadas (n elementos).
+    long long n;          // Elementos recebidos pelo rank.
+    int first;            // Primeira faixa do rank.
+    int nranges;          // Número de faixas do rank.
+    long long *Pos;       // Início global de cada faixa (np posições).
+    long long *local_pos; // Início de cada faixa do rank em Output (nranges posições).
+    long long sent;       // Elementos enviados a outros ranks.
+    int nblocks;          // Blocos do pipeline.
+    double partition_time; // Segundos particionando os blocos locais.
+    double exchange_time;  // Segundos esperando a comunicação (a parte não sobreposta).
+    double assemble_time;  // Segundos montando Output com os pedaços recebidos.
+    double total_time;     // Segundos da chamada inteira.
+} mp_dist_result_t;
+
+/**
+ * @brief Faixas do rank `rank`: [*first, *first + *count), em blocos
+ *        contíguos de ~np / size faixas.
+ */
+void mp_dist_ranges(int np, int size, int rank, int *first, int *count);
+
+/**
+ * @brief Particiona os shards de todos os ranks de `comm` (chamada coletiva).
+ *
+ * @param comm Comunicador; todos os ranks chamam com o mesmo P, np e block.
+ * @param Input Shard local (n elementos).
+ * @param n Elementos do shard local (pode variar entre os ranks).
+ * @param P Vetor de partições (ordenado, P[np-1] = LLONG_MAX).
+ * @param np Número de partições.
+ * @param nThreads Workers locais de cada rank.
+ * @param block Elementos por bloco do pipeline (<= 0 = MP_DIST_BLOCK_ELEMS; no mínimo np).
+ * @param res Resultado do rank (liberar com `mp_dist_result_free`).
+ * @return int 0 em caso de sucesso ou -1 em caso de falha de alocação ou de
+ *             parâmetros inválidos (em todos os ranks).
+ *
+ * O rank r é dono das faixas de `mp_dist_ranges`; com partições escolhidas
+ * por amostragem (`mp_sample_splitters`) os ranks recebem quantidades
+ * parecidas. O shard é particionado em blocos com `multi_partition_execute`;
+ * as contagens de cada bloco são trocadas com `MPI_Alltoallv` e os dados com
+ * `MPI_Ialltoallv`, que fica em voo enquanto o bloco seguinte é
+ * particionado (em buffer duplo). No fim, `Pos` global vem da soma das
+ * contagens (`MPI_Allreduce`) e os workers copiam os pedaços recebidos para
+ * Output na ordem global (rank de origem, depois bloco), então o resultado é
+ * estável: Output do rank r é igual a Output[Pos[first], Pos[first +
+ * nranges]) do particionamento da concatenação. Os contadores do MPI são
+ * int, então block é limitado a INT_MAX / size.
+ */
+int mp_dist_partition(MPI_Comm comm, long long *Input, long long n, long long *P, int np, int nThreads,
+                      long long block, mp_dist_result_t *res);
+
+/**
+ * @brief Libera os vetores de um resultado.
+ */
+void mp_dist_result_free(mp_dist_result_t *res);
+
+#endif // MP_DIST_H
@@ -0,0 +1,408 @@
+#include <limits.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mp_gen.h"
+#include "thread_pool.h"
+#include "util.h"
+
+// Abaixo disso, mp_gen_sort usa um único qsort
+#define GEN_SORT_SERIAL 16384
+
+// Largura dos aglomerados da distribuição clustered
+#define GEN_CLUSTER_BITS 32
+
+#define GEN_GOLDEN 0x9e3779b97f4a7c15ULL
+
+// Fluxos independentes derivados da mesma semente
+enum
+{
+    GEN_STREAM_KEY = 1,
+    GEN_STREAM_VALUE,
+    GEN_STREAM_OFFSET,
+    GEN_STREAM_SPLITTER
+};
+
+// Estado compartilhado por todos os workers de uma geração
+typedef struct
+{
+    long long *v;
+    long long n;
+    long long first;
+    mp_dist_t dist;
+    unsigned long long key_seed;    // Sorteio de cada posição.
+    unsigned long long value_seed;  // Valores de cada rank/centro.
+    unsigned long long offset_seed; // Deslocamento dentro do aglomerado.
+    long long total;
+    int distinct;
+    int clusters;
+    double theta, zetan, zeta2, alpha, eta; // Constantes da Zipf (Gray et al., SIGMOD 1994).
+} gen_shared_t;
+
+typedef struct
+{
+    gen_shared_t *shared;
+    int id;
+    int nThreads;
+} gen_task_t;
+
+// Estado compartilhado de uma rodada de mp_gen_sort
+typedef struct
+{
+    long long *src;
+    long long *dst;
+    long long n;
+    long long run; // Tamanho dos trechos já ordenados.
+} sort_shared_t;
+
+typedef struct
+{
+    sort_shared_t *shared;
+    int id;
+    int nThreads;
+} sort_task_t;
+
+// Finalizador do splitmix64
+static inline unsigned long long mix64(unsigned long long z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Elemento i do fluxo: splitmix64 na posição i (não depende dos anteriores)
+static inline unsigned long long counter_random(unsigned long long seed, unsigned long long i)
+{
+    return mix64(seed + (i + 1) * GEN_GOLDEN);
+}
+
+static inline unsigned long long stream_seed(unsigned long long seed, int stream)
+{
+    return mix64(seed ^ ((unsigned long long)stream * 0xd1b54a32d192ed03ULL));
+}
+
+// Uniforme em [0, 1) com 53 bits
+static inline double unit_double(unsigned long long x)
+{
+    return (double)(x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Ordem sem sinal -> ordem com sinal
+static inline long long as_signed_order(unsigned long long u)
+{
+    return (long long)(u ^ 0x8000000000000000ULL);
+}
+
+static int default_threads(int nThreads)
+{
+    if (nThreads > 0)
+    {
+        return nThreads;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+// Intervalo [start, end) de n da thread t
+static void gen_chunk(long long n, int nThreads, int t, long long *start, long long *end)
+{
+    long long size = (n + nThreads - 1) / nThreads;
+    long long s = t * size, e = s + size;
+
+    *start = s > n ? n : s;
+    *end = e > n ? n : e;
+}
+
+// Executa `task` em nThreads workers (ou na thread atual, com uma só)
+static void run_tasks(thread_pool_t *pool, thread_pool_task_t task, void *tasks, size_t size, int nThreads)
+{
+    if (pool != NULL)
+    {
+        thread_pool_run(pool, task, tasks, size);
+        return;
+    }
+    for (int t = 0; t < nThreads; t++)
+    {
+        task((char *)tasks + t * size);
+    }
+}
+
+// Rank (1 a distinct) da Zipf para um uniforme u
+static inline long long zipf_rank(const gen_shared_t *sh, double u)
+{
+    double uz = u * sh->zetan;
+
+    if (uz < 1.0)
+    {
+        return 1;
+    }
+    if (uz < sh->zeta2)
+    {
+        return 2;
+    }
+    long long rank = 1 + (long long)(sh->distinct * pow(sh->eta * u - sh->eta + 1.0, sh->alpha));
+    return rank > sh->distinct ? sh->distinct : rank;
+}
+
+static inline long long gen_value(const gen_shared_t *sh, long long pos)
+{
+    unsigned long long r = counter_random(sh->key_seed, pos);
+
+    switch (sh->dist)
+    {
+    case MP_DIST_ZIPF:
+        return (long long)counter_random(sh->value_seed, zipf_rank(sh, unit_double(r)));
+    case MP_DIST_SORTED:
+    case MP_DIST_REVERSE:
+    {
+        // Posição k em [k * step, (k + 1) * step): crescente sem ordenar
+        unsigned long long step = ULLONG_MAX / (unsigned long long)sh->total;
+        unsigned long long k = sh->dist == MP_DIST_SORTED ? pos : sh->total - 1 - pos;
+        return as_signed_order(k * step + r % step);
+    }
+    case MP_DIST_FEWUNIQUE:
+        return (long long)counter_random(sh->value_seed, r % sh->distinct);
+    case MP_DIST_CLUSTERED:
+    {
+        unsigned long long center = counter_random(sh->value_seed, r % sh->clusters);
+        unsigned long long width = 1ULL << GEN_CLUSTER_BITS;
+        unsigned long long offset = counter_random(sh->offset_seed, pos) & (width - 1);
+        return (long long)(center + offset - width / 2);
+    }
+    default:
+        return (long long)r;
+    }
+}
+
+static void *thread_gen_fill(void *arg)
+{
+    gen_task_t *task = (gen_task_t *)arg;
+    const gen_shared_t *sh = task->shared;
+    long long start, end;
+
+    gen_chunk(sh->n, task->nThreads, task->id, &start, &end);
+    for (long long i = start; i < end; i++)
+    {
+        sh->v[i] = gen_value(sh, sh->first + i);
+    }
+    return NULL;
+}
+
+int mp_gen_fill(long long *v, long long n, long long first, const mp_gen_options_t *opt, int nThreads)
+{
+    mp_gen_options_t def = {MP_DIST_UNIFORM, 1, 0, 0, 0, 0};
+    gen_shared_t sh;
+
+    opt = opt != NULL ? opt : &def;
+    if (n < 0 || first < 0 || (n > 0 && v == NULL))
+    {
+        return -1;
+    }
+
+    memset(&sh, 0, sizeof(sh));
+    sh.v = v;
+    sh.n = n;
+    sh.first = first;
+    sh.dist = opt->dist;
+    sh.key_seed = stream_seed(opt->seed, GEN_STREAM_KEY);
+    sh.value_seed = stream_seed(opt->seed, GEN_STREAM_VALUE);
+    sh.offset_seed = stream_seed(opt->seed, GEN_STREAM_OFFSET);
+    sh.total = opt->total > 0 ? opt->total : first + n;
+    sh.distinct = opt->distinct > 0 ? opt->distinct : (opt->dist == MP_DIST_ZIPF ? 1 << 20 : 16);
+    sh.clusters = opt->clusters > 0 ? opt->clusters : 16;
+    if (sh.total < first + n)
+    {
+        return -1;
+    }
+
+    if (sh.dist == MP_DIST_ZIPF)
+    {
+        // zeta(distinct, theta) em ordem fixa: o mesmo valor com qualquer número de threads
+        sh.theta = opt->zipf_theta > 0 && opt->zipf_theta < 1 ? opt->zipf_theta : 0.99;
+        for (int k = 1; k <= sh.distinct; k++)
+        {
+            sh.zetan += 1.0 / pow((double)k, sh.theta);
+        }
+        sh.zeta2 = 1.0 + pow(0.5, sh.theta);
+        sh.alpha = 1.0 / (1.0 - sh.theta);
+        sh.eta = (1.0 - pow(2.0 / sh.distinct, 1.0 - sh.theta)) / (1.0 - sh.zeta2 / sh.zetan);
+    }
+
+    nThreads = default_threads(nThreads);
+    gen_task_t *tasks = malloc(nThreads * sizeof(gen_task_t));
+    thread_pool_t *pool = nThreads > 1 ? thread_pool_create(nThreads) : NULL;
+    if (tasks == NULL || (nThreads > 1 && pool == NULL))
+    {
+        free(tasks);
+        thread_pool_destroy(pool);
+        return -1;
+    }
+
+    for (int t = 0; t < nThreads; t++)
+    {
+        tasks[t] = (gen_task_t){&sh, t, nThreads};
+    }
+    run_tasks(pool, thread_gen_fill, tasks, sizeof(gen_task_t), nThreads);
+
+    thread_pool_destroy(pool);
+    free(tasks);
+    return 0;
+}
+
+// Quantos dos k primeiros elementos da intercalação estável de A e B vêm de A
+static long long merge_corank(const long long *A, long long la, const long long *B, long long lb, long long k)
+{
+    long long lo = k > lb ? k - lb : 0;
+    long long hi = k < la ? k : la;
+
+    while (lo < hi)
+    {
+        long long i = lo + (hi - lo) / 2;
+        if (A[i] <= B[k - i - 1])
+        {
+            lo = i + 1; // A[i] vem antes (empates ficam com A)
+        }
+        else
+        {
+            hi = i;
+        }
+    }
+    return lo;
+}
+
+static void *thread_sort_chunk(void *arg)
+{
+    sort_task_t *task = (sort_task_t *)arg;
+    sort_shared_t *sh = task->shared;
+    long long start = task->id * sh->run;
+    long long end = start + sh->run < sh->n ? start + sh->run : sh->n;
+
+    if (start < end)
+    {
+        qsort(sh->src + start, end - start, sizeof(long long), compare_long_long);
+    }
+    return NULL;
+}
+
+// Uma rodada de intercalações: cada thread produz um trecho contíguo de dst
+static void *thread_sort_merge(void *arg)
+{
+    sort_task_t *task = (sort_task_t *)arg;
+    sort_shared_t *sh = task->shared;
+    const long long *src = sh->src;
+    long long *dst = sh->dst;
+    long long n = sh->n, run = sh->run;
+    long long lo, hi;
+
+    gen_chunk(n, task->nThreads, task->id, &lo, &hi);
+    while (lo < hi)
+    {
+        // Par de trechos [a0, a1) e [a1, b1) que produz a posição lo
+        long long a0 = lo / (2 * run) * 2 * run;
+        long long a1 = a0 + run < n ? a0 + run : n;
+        long long b1 = a0 + 2 * run < n ? a0 + 2 * run : n;
+        long long e = hi < b1 ? hi : b1;
+        const long long *A = src + a0, *B = src + a1;
+        long long la = a1 - a0, lb = b1 - a1;
+
+        long long i = merge_corank(A, la, B, lb, lo - a0);
+        long long j = lo - a0 - i;
+        long long ie = merge_corank(A, la, B, lb, e - a0);
+        long long je = e - a0 - ie;
+
+        for (long long k = lo; k < e; k++)
+        {
+            if (j >= je || (i < ie && A[i] <= B[j]))
+            {
+                dst[k] = A[i++];
+            }
+            else
+            {
+                dst[k] = B[j++];
+            }
+        }
+        lo = e;
+    }
+    return NULL;
+}
+
+int mp_gen_sort(long long *v, long long n, int nThreads)
+{
+    nThreads = default_threads(nThreads);
+    if (n <= GEN_SORT_SERIAL || nThreads == 1)
+    {
+        qsort(v, n, sizeof(long long), compare_long_long);
+        return 0;
+    }
+
+    long long *tmp = malloc((size_t)n * sizeof(long long));
+    sort_task_t *tasks = malloc(nThreads * sizeof(sort_task_t));
+    thread_pool_t *pool = thread_pool_create(nThreads);
+    if (tmp == NULL || tasks == NULL || pool == NULL)
+    {
+        free(tmp);
+        free(tasks);
+        thread_pool_destroy(pool);
+        return -1;
+    }
+
+    sort_shared_t sh = {v, tmp, n, (n + nThreads - 1) / nThreads};
+    for (int t = 0; t < nThreads; t++)
+    {
+        tasks[t] = (sort_task_t){&sh, t, nThreads};
+    }
+
+    // Trechos ordenados em paralelo e intercalados até restar um só
+    run_tasks(pool, thread_sort_chunk, tasks, sizeof(sort_task_t), nThreads);
+    while (sh.run < n)
+    {
+        run_tasks(pool, thread_sort_merge, tasks, sizeof(sort_task_t), nThreads);
+        long long *swap = sh.src;
+        sh.src = sh.dst;
+        sh.dst = swap;
+        sh.run = sh.run > n / 2 ? n : sh.run * 2;
+    }
+    if (sh.src != v)
+    {
+        memcpy(v, sh.src, (size_t)n * sizeof(long long));
+    }
+
+    thread_pool_destroy(pool);
+    free(tasks);
+    free(tmp);
+    return 0;
+}
+
+int mp_gen_splitters(long long *P, int np, unsigned long long seed, int nThreads)
+{
+    mp_gen_options_t opt = {MP_DIST_UNIFORM, stream_seed(seed, GEN_STREAM_SPLITTER), 0, 0, 0, 0};
+
+    if (np <= 0 || mp_gen_fill(P, np - 1, 0, &opt, nThreads) != 0 || mp_gen_sort(P, np - 1, nThreads) != 0)
+    {
+        return -1;
+    }
+    P[np - 1] = LLONG_MAX;
+    return 0;
+}
+
+static const char *dist_names[] = {"uniform", "zipf", "sorted", "reverse", "fewunique", "clustered"};
+
+int mp_gen_parse_dist(const char *name, mp_dist_t *dist)
+{
+    for (int d = 0; d < (int)(sizeof(dist_names) / sizeof(dist_names[0])); d++)
+    {
+        if (strcmp(name, dist_names[d]) == 0)
+        {
+            *dist = (mp_dist_t)d;
+            return 0;
+        }
+    }
+    return -1; // Distribuição desconhecida
+}
+
+const char *mp_gen_dist_name(mp_dist_t dist)
+{
+    return dist >= MP_DIST_UNIFORM && dist <= MP_DIST_CLUSTERED ? dist_names[dist] : "desconhecida";
+}
@@ -0,0 +1,96 @@
+#ifndef MP_GEN_H
+#define MP_GEN_H
+
+/**
+ * Geração paralela de dados sintéticos (chaves de 64 bits) e ordenação
+ * paralela de vetores de partições.
+ *
+ * O gerador é baseado em contador: o elemento i é uma função apenas da
+ * semente e de i (splitmix64 da posição i da sequência), de modo que o
+ * resultado é o mesmo com qualquer número de threads e qualquer divisão em
+ * blocos.
+ */
+
+/**
+ * @brief Distribuições das chaves.
+ */
+typedef enum
+{
+    MP_DIST_UNIFORM = 0, // Uniforme em todo o intervalo de 64 bits.
+    MP_DIST_ZIPF,        // Zipf sobre `distinct` valores (poucos valores muito frequentes).
+    MP_DIST_SORTED,      // Crescente, espalhada pelos 64 bits.
+    MP_DIST_REVERSE,     // Decrescente, espalhada pelos 64 bits.
+    MP_DIST_FEWUNIQUE,   // `distinct` valores, todos com a mesma frequência.
+    MP_DIST_CLUSTERED    // Aglomerados de largura 2^32 em torno de `clusters` centros.
+} mp_dist_t;
+
+/**
+ * @brief Parâmetros da geração.
+ */
+typedef struct
+{
+    mp_dist_t dist;          // Distribuição.
+    unsigned long long seed; // Semente.
+    double zipf_theta;       // Expoente da Zipf, em (0, 1) (0 = 0,99).
+    int distinct;            // Valores distintos da Zipf e de fewunique (0 = 2^20 e 16).
+    int clusters;            // Centros da distribuição clustered (0 = 16).
+    long long total;         // Tamanho da sequência inteira, para sorted/reverse em blocos (0 = n).
+} mp_gen_options_t;
+
+/**
+ * @brief Preenche v[0..n-1] com os elementos first..first+n-1 da sequência.
+ *
+ * @param v Vetor de destino.
+ * @param n Número de elementos.
+ * @param first Posição do primeiro elemento na sequência (0 para um vetor inteiro).
+ * @param opt Distribuição e semente (NULL = uniforme, semente 1).
+ * @param nThreads Threads usadas (<= 0 = CPUs disponíveis).
+ * @return int 0 em caso de sucesso ou -1 em caso de falha de alocação ou
+ *             de parâmetros inválidos.
+ *
+ * Gerar um vetor em vários blocos (ex.: um arquivo maior que a memória)
+ * produz os mesmos valores que gerá-lo de uma vez, desde que `total` seja o
+ * tamanho da sequência inteira.
+ */
+int mp_gen_fill(long long *v, long long n, long long first, const mp_gen_options_t *opt, int nThreads);
+
+/**
+ * @brief Gera np partições: np - 1 chaves uniformes ordenadas e P[np-1] = LLONG_MAX.
+ *
+ * @param P Vetor de destino (np elementos).
+ * @param np Número de partições.
+ * @param seed Semente.
+ * @param nThreads Threads usadas na geração e na ordenação (<= 0 = CPUs disponíveis).
+ * @return int 0 em caso de sucesso ou -1 em caso de falha de alocação.
+ */
+int mp_gen_splitters(long long *P, int np, unsigned long long seed, int nThreads);
+
+/**
+ * @brief Ordena v em paralelo (ordem crescente).
+ *
+ * @param v Vetor com n elementos.
+ * @param n Número de elementos.
+ * @param nThreads Threads usadas (<= 0 = CPUs disponíveis).
+ * @return int 0 em caso de sucesso ou -1 em caso de falha de alocação.
+ *
+ * Cada thread ordena um trecho com qsort; os trechos são depois
+ * intercalados dois a dois, com cada intercalação dividida entre todas as
+ * threads (merge path), usando um vetor auxiliar de n elementos.
+ */
+int mp_gen_sort(long long *v, long long n, int nThreads);
+
+/**
+ * @brief Converte o nome de uma distribuição.
+ *
+ * @param name uniform, zipf, sorted, reverse, fewunique ou clustered.
+ * @param dist Saída.
+ * @return int 0 em caso de sucesso ou -1 se o nome é desconhecido.
+ */
+int mp_gen_parse_dist(const char *name, mp_dist_t *dist);
+
+/**
+ * @brief Nome de uma distribuição.
+ */
+const char *mp_gen_dist_name(mp_dist_t dist);
+
+#endif // MP_GEN_H
@@ -0,0 +1,245 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "mp_profile.h"
+
+static const char *phase_names[MP_PHASE_COUNT] = {"classify", "prefix", "scatter", "refine", "barrier"};
+static const char *event_names[MP_EVENT_COUNT] = {"cycles", "instr", "llc-miss", "dtlb-miss", "br-miss"};
+
+// Descritores dos contadores da thread atual (-1 se indisponível)
+typedef struct
+{
+    int opened;
+    int fd[MP_EVENT_COUNT];
+} perf_state_t;
+
+static __thread perf_state_t perf_state;
+static pthread_key_t perf_key;
+static pthread_once_t perf_key_once = PTHREAD_ONCE_INIT;
+
+static long long now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// Fecha os contadores quando a thread termina
+static void perf_close(void *arg)
+{
+    perf_state_t *st = (perf_state_t *)arg;
+    for (int e = 0; e < MP_EVENT_COUNT; e++)
+    {
+        if (st->fd[e] >= 0)
+        {
+            close(st->fd[e]);
+            st->fd[e] = -1;
+        }
+    }
+}
+
+static void perf_key_create(void)
+{
+    pthread_key_create(&perf_key, perf_close);
+}
+
+static int perf_open(unsigned int type, unsigned long long config)
+{
+#ifdef __linux__
+    struct perf_event_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+
+    // Conta apenas a thread atual, em qualquer CPU
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    (void)type;
+    (void)config;
+    return -1;
+#endif
+}
+
+static void perf_init_thread(void)
+{
+    perf_state_t *st = &perf_state;
+
+    st->opened = 1;
+    for (int e = 0; e < MP_EVENT_COUNT; e++)
+    {
+        st->fd[e] = -1;
+    }
+
+#ifdef __linux__
+    st->fd[MP_EVENT_CYCLES] = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    st->fd[MP_EVENT_INSTRUCTIONS] = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    st->fd[MP_EVENT_LLC_MISSES] = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    st->fd[MP_EVENT_DTLB_MISSES] = perf_open(PERF_TYPE_HW_CACHE,
+                                             PERF_COUNT_HW_CACHE_DTLB |
+                                                 (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    st->fd[MP_EVENT_BRANCH_MISSES] = perf_open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES);
+#endif
+
+    pthread_once(&perf_key_once, perf_key_create);
+    pthread_setspecific(perf_key, st);
+}
+
+static void read_events(long long *values)
+{
+    for (int e = 0; e < MP_EVENT_COUNT; e++)
+    {
+        long long v = 0;
+        int fd = perf_state.fd[e];
+        values[e] = fd >= 0 && read(fd, &v, sizeof(v)) == sizeof(v) ? v : -1;
+    }
+}
+
+mp_profile_t *mp_profile_create(int nThreads)
+{
+    mp_profile_t *prof = (mp_profile_t *)calloc(1, sizeof(mp_profile_t));
+    if (prof == NULL)
+    {
+        return NULL;
+    }
+
+    prof->nThreads = nThreads;
+    prof->threads = aligned_alloc(64, nThreads * sizeof(mp_thread_profile_t));
+    if (prof->threads == NULL)
+    {
+        free(prof);
+        return NULL;
+    }
+
+    mp_profile_reset(prof);
+    return prof;
+}
+
+void mp_profile_reset(mp_profile_t *prof)
+{
+    prof->calls = 0;
+    memset(prof->threads, 0, prof->nThreads * sizeof(mp_thread_profile_t));
+}
+
+void mp_profile_destroy(mp_profile_t *prof)
+{
+    if (prof != NULL)
+    {
+        free(prof->threads);
+        free(prof);
+    }
+}
+
+void mp_profile_start(mp_thread_profile_t *tp)
+{
+    if (!perf_state.opened)
+    {
+        perf_init_thread();
+    }
+
+    read_events(tp->mark_events);
+    tp->has_events = perf_state.fd[MP_EVENT_CYCLES] >= 0;
+    tp->mark_ns = now_ns();
+}
+
+void mp_profile_mark(mp_thread_profile_t *tp, mp_phase_t phase)
+{
+    long long t = now_ns();
+    long long values[MP_EVENT_COUNT];
+
+    read_events(values);
+    tp->ns[phase] += t - tp->mark_ns;
+    for (int e = 0; e < MP_EVENT_COUNT; e++)
+    {
+        if (values[e] >= 0 && tp->mark_events[e] >= 0)
+        {
+            tp->events[phase][e] += values[e] - tp->mark_events[e];
+        }
+        tp->mark_events[e] = values[e];
+    }
+
+    // O custo da própria leitura não entra no próximo trecho
+    tp->mark_ns = now_ns();
+}
+
+void mp_profile_report(const mp_profile_t *prof, FILE *out)
+{
+    if (prof == NULL)
+    {
+        fprintf(out, "perfil desabilitado (compile com make PROFILE=1)\n");
+        return;
+    }
+
+    long long calls = prof->calls > 0 ? prof->calls : 1;
+    int has_events = 0;
+
+    for (int t = 0; t < prof->nThreads; t++)
+    {
+        has_events |= prof->threads[t].has_events;
+    }
+
+    fprintf(out, "# perfil: %lld execuções, %d threads (tempos em us por execução)\n", prof->calls, prof->nThreads);
+    fprintf(out, "%-9s %10s %10s %10s %7s", "fase", "media", "min", "max", "desbal");
+    if (has_events)
+    {
+        for (int e = 0; e < MP_EVENT_COUNT; e++)
+        {
+            fprintf(out, " %12s", event_names[e]);
+        }
+    }
+    fprintf(out, "\n");
+
+    for (int ph = 0; ph < MP_PHASE_COUNT; ph++)
+    {
+        long long sum = 0, min = -1, max = 0;
+        long long events[MP_EVENT_COUNT] = {0};
+
+        for (int t = 0; t < prof->nThreads; t++)
+        {
+            const mp_thread_profile_t *tp = &prof->threads[t];
+            long long ns = tp->ns[ph];
+
+            sum += ns;
+            min = min < 0 || ns < min ? ns : min;
+            max = ns > max ? ns : max;
+            for (int e = 0; e < MP_EVENT_COUNT; e++)
+            {
+                events[e] += tp->events[ph][e];
+            }
+        }
+        if (sum == 0)
+        {
+            continue; // Fase não executada (ex.: refine com um nível)
+        }
+
+        double avg = (double)sum / prof->nThreads;
+        fprintf(out, "%-9s %10.1f %10.1f %10.1f %7.2f", phase_names[ph],
+                avg / calls / 1000.0, (double)min / calls / 1000.0, (double)max / calls / 1000.0, max / avg);
+        if (has_events)
+        {
+            for (int e = 0; e < MP_EVENT_COUNT; e++)
+            {
+                fprintf(out, " %12lld", events[e] / calls);
+            }
+        }
+        fprintf(out, "\n");
+    }
+
+    if (!has_events)
+    {
+        fprintf(out, "# contadores de hardware indisponíveis (perf_event_open)\n");
+    }
+}
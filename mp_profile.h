@@ -0,0 +1,103 @@
+#ifndef MP_PROFILE_H
+#define MP_PROFILE_H
+
+#include <stdio.h>
+
+/**
+ * Instrumentação opcional de `multi_partition` (compile com `make PROFILE=1`,
+ * que define MP_PROFILE). Sem MP_PROFILE as macros abaixo não geram código.
+ */
+
+/**
+ * @brief Fases medidas em cada thread.
+ */
+typedef enum
+{
+    MP_PHASE_CLASSIFY = 0, // Busca + contagem (thread_count_partition).
+    MP_PHASE_PREFIX,       // Merge e prefix sum das contagens.
+    MP_PHASE_SCATTER,      // Escrita em Output.
+    MP_PHASE_REFINE,       // Segundo nível do particionamento hierárquico.
+    MP_PHASE_BARRIER,      // Espera nas barreiras (desbalanceamento).
+    MP_PHASE_COUNT
+} mp_phase_t;
+
+/**
+ * @brief Contadores de hardware lidos com perf_event_open (Linux).
+ */
+typedef enum
+{
+    MP_EVENT_CYCLES = 0,
+    MP_EVENT_INSTRUCTIONS,
+    MP_EVENT_LLC_MISSES,
+    MP_EVENT_DTLB_MISSES,
+    MP_EVENT_BRANCH_MISSES,
+    MP_EVENT_COUNT
+} mp_event_t;
+
+/**
+ * @brief Medidas acumuladas de uma thread (uma linha de cache própria).
+ */
+typedef struct
+{
+    long long ns[MP_PHASE_COUNT];                    // Tempo de parede por fase.
+    long long events[MP_PHASE_COUNT][MP_EVENT_COUNT]; // Contadores por fase.
+    long long mark_ns;                               // Início do trecho atual.
+    long long mark_events[MP_EVENT_COUNT];           // Contadores no início do trecho atual.
+    int has_events;                                  // Contadores disponíveis nesta thread.
+} __attribute__((aligned(64))) mp_thread_profile_t;
+
+/**
+ * @brief Medidas de todas as threads de um plano.
+ */
+typedef struct
+{
+    int nThreads;                 // Número de threads.
+    long long calls;              // Execuções acumuladas.
+    mp_thread_profile_t *threads; // Medidas de cada thread.
+} mp_profile_t;
+
+/**
+ * @brief Cria a estrutura de medidas para nThreads threads (zerada).
+ */
+mp_profile_t *mp_profile_create(int nThreads);
+
+/**
+ * @brief Zera as medidas acumuladas.
+ */
+void mp_profile_reset(mp_profile_t *prof);
+
+/**
+ * @brief Libera a estrutura de medidas (pode ser NULL).
+ */
+void mp_profile_destroy(mp_profile_t *prof);
+
+/**
+ * @brief Inicia um trecho medido na thread atual.
+ *
+ * Na primeira chamada em cada thread, abre os contadores de hardware da
+ * thread; se perf_event_open não estiver disponível, só o tempo é medido.
+ */
+void mp_profile_start(mp_thread_profile_t *tp);
+
+/**
+ * @brief Atribui à fase `phase` o tempo e os eventos desde a última marca.
+ */
+void mp_profile_mark(mp_thread_profile_t *tp, mp_phase_t phase);
+
+/**
+ * @brief Imprime um relatório compacto por fase.
+ *
+ * Para cada fase: tempo médio por execução (média/máximo entre as threads),
+ * desbalanceamento (máximo/média) e os contadores de hardware somados.
+ */
+void mp_profile_report(const mp_profile_t *prof, FILE *out);
+
+#ifdef MP_PROFILE
+#define MP_PROFILE_START(tp) mp_profile_start(tp)
+#define MP_PROFILE_MARK(tp, phase) mp_profile_mark(tp, phase)
+#else
+#define MP_PROFILE_START(tp) ((void)0)
+#define MP_PROFILE_MARK(tp, phase) ((void)0)
+#endif
+
+#endif // MP_PROFILE_H
@@ -0,0 +1,327 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "mp_sort.h"
+#include "mp_gen.h"
+#include "multi_partition.h"
+#include "thread_pool.h"
+
+// Abaixo disso, o introsort termina com inserção
+#define SORT_INSERTION 24
+
+// Argumento de cada worker da amostragem
+typedef struct
+{
+    const long long *Input;
+    long long n;
+    long long *sample;
+    long long count; // Tamanho da amostra.
+    unsigned long long seed;
+    int id;
+    int nThreads;
+} sample_task_t;
+
+// Argumento de cada worker da ordenação das faixas
+typedef struct
+{
+    long long *Data;
+    const long long *Tmp;
+    const long long *Pos;
+    long long n;
+    int np;
+    int *next; // Próxima faixa livre (compartilhado).
+} sort_task_t;
+
+// Finalizador do splitmix64
+static inline unsigned long long sort_mix64(unsigned long long z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static int sort_threads(int nThreads)
+{
+    if (nThreads > 0)
+    {
+        return nThreads;
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (int)cpus : 1;
+}
+
+static inline void swap_keys(long long *a, long long *b)
+{
+    long long t = *a;
+    *a = *b;
+    *b = t;
+}
+
+static void insertion_sort(long long *a, long long n)
+{
+    for (long long i = 1; i < n; i++)
+    {
+        long long v = a[i], j = i;
+        while (j > 0 && a[j - 1] > v)
+        {
+            a[j] = a[j - 1];
+            j--;
+        }
+        a[j] = v;
+    }
+}
+
+static void sift_down(long long *a, long long root, long long n)
+{
+    for (;;)
+    {
+        long long child = 2 * root + 1;
+        if (child >= n)
+        {
+            return;
+        }
+        if (child + 1 < n && a[child + 1] > a[child])
+        {
+            child++;
+        }
+        if (a[root] >= a[child])
+        {
+            return;
+        }
+        swap_keys(&a[root], &a[child]);
+        root = child;
+    }
+}
+
+static void heap_sort(long long *a, long long n)
+{
+    for (long long i = n / 2; i-- > 0;)
+    {
+        sift_down(a, i, n);
+    }
+    for (long long i = n - 1; i > 0; i--)
+    {
+        swap_keys(&a[0], &a[i]);
+        sift_down(a, 0, i);
+    }
+}
+
+// Introsort: quicksort com mediana de três, heapsort se a recursão ficar
+// funda demais e inserção nos trechos pequenos
+static void intro_sort(long long *a, long long n, int depth)
+{
+    while (n > SORT_INSERTION)
+    {
+        if (depth-- == 0)
+        {
+            heap_sort(a, n);
+            return;
+        }
+
+        long long mid = n / 2;
+        if (a[mid] < a[0])
+        {
+            swap_keys(&a[mid], &a[0]);
+        }
+        if (a[n - 1] < a[0])
+        {
+            swap_keys(&a[n - 1], &a[0]);
+        }
+        if (a[n - 1] < a[mid])
+        {
+            swap_keys(&a[n - 1], &a[mid]);
+        }
+        long long pivot = a[mid];
+
+        // Hoare: chaves iguais ao pivô se dividem entre os dois lados
+        long long i = -1, j = n;
+        for (;;)
+        {
+            while (a[++i] < pivot)
+            {
+            }
+            while (a[--j] > pivot)
+            {
+            }
+            if (i >= j)
+            {
+                break;
+            }
+            swap_keys(&a[i], &a[j]);
+        }
+
+        // Recursão no lado menor, laço no maior
+        long long left = j + 1;
+        if (left < n - left)
+        {
+            intro_sort(a, left, depth);
+            a += left;
+            n -= left;
+        }
+        else
+        {
+            intro_sort(a + left, n - left, depth);
+            n = left;
+        }
+    }
+    insertion_sort(a, n);
+}
+
+static void sort_keys(long long *a, long long n)
+{
+    int depth = 0;
+    for (long long m = n; m > 1; m >>= 1)
+    {
+        depth += 2;
+    }
+    intro_sort(a, n, depth);
+}
+
+static void *thread_sample(void *arg)
+{
+    sample_task_t *task = (sample_task_t *)arg;
+    long long size = (task->count + task->nThreads - 1) / task->nThreads;
+    long long start = task->id * size > task->count ? task->count : task->id * size;
+    long long end = start + size > task->count ? task->count : start + size;
+
+    // Posição da amostra i depende só da semente e de i
+    for (long long i = start; i < end; i++)
+    {
+        unsigned long long r = sort_mix64(task->seed + (i + 1) * 0x9e3779b97f4a7c15ULL);
+        task->sample[i] = task->Input[r % (unsigned long long)task->n];
+    }
+    return NULL;
+}
+
+int mp_sample_splitters(const long long *Input, long long n, long long *P, int np, unsigned long long seed,
+                        int nThreads)
+{
+    if (np <= 0 || n < 0 || (n > 0 && Input == NULL))
+    {
+        return -1;
+    }
+    P[np - 1] = LLONG_MAX;
+    if (np == 1)
+    {
+        return 0;
+    }
+    if (n == 0)
+    {
+        for (int j = 0; j < np - 1; j++)
+        {
+            P[j] = LLONG_MAX; // Sem dados: todas as faixas menos a primeira vazias
+        }
+        return 0;
+    }
+
+    nThreads = sort_threads(nThreads);
+    long long count = (long long)np * MP_SAMPLE_OVERSAMPLE;
+    count = count > n ? n : count;
+
+    long long *sample = malloc((size_t)count * sizeof(long long));
+    sample_task_t *tasks = malloc(nThreads * sizeof(sample_task_t));
+    thread_pool_t *pool = nThreads > 1 ? thread_pool_create(nThreads) : NULL;
+    if (sample == NULL || tasks == NULL || (nThreads > 1 && pool == NULL))
+    {
+        free(sample);
+        free(tasks);
+        thread_pool_destroy(pool);
+        return -1;
+    }
+
+    for (int t = 0; t < nThreads; t++)
+    {
+        tasks[t] = (sample_task_t){Input, n, sample, count, sort_mix64(seed), t, nThreads};
+    }
+    if (pool != NULL)
+    {
+        thread_pool_run(pool, thread_sample, tasks, sizeof(sample_task_t));
+    }
+    else
+    {
+        thread_sample(tasks);
+    }
+    thread_pool_destroy(pool);
+    free(tasks);
+
+    int ret = mp_gen_sort(sample, count, nThreads);
+    if (ret == 0)
+    {
+        // Quantis (j + 1) / np da amostra
+        for (int j = 0; j < np - 1; j++)
+        {
+            P[j] = sample[(long long)(j + 1) * count / np];
+        }
+    }
+    free(sample);
+    return ret;
+}
+
+// Cada worker pega faixas livres, copia de volta para Data e ordena no lugar
+static void *thread_sort_ranges(void *arg)
+{
+    sort_task_t *task = (sort_task_t *)arg;
+
+    for (;;)
+    {
+        int j = __atomic_fetch_add(task->next, 1, __ATOMIC_RELAXED);
+        if (j >= task->np)
+        {
+            break;
+        }
+
+        long long lo = task->Pos[j];
+        long long hi = j + 1 < task->np ? task->Pos[j + 1] : task->n;
+        if (hi > lo)
+        {
+            memcpy(task->Data + lo, task->Tmp + lo, (size_t)(hi - lo) * sizeof(long long));
+            sort_keys(task->Data + lo, hi - lo);
+        }
+    }
+    return NULL;
+}
+
+int mp_sample_sort(long long *Data, long long n, int nThreads)
+{
+    nThreads = sort_threads(nThreads);
+    if (n <= MP_SORT_RANGE_ELEMS)
+    {
+        sort_keys(Data, n);
+        return 0;
+    }
+
+    long long ranges = (n + MP_SORT_RANGE_ELEMS - 1) / MP_SORT_RANGE_ELEMS;
+    int np = ranges > INT_MAX / MP_SAMPLE_OVERSAMPLE ? INT_MAX / MP_SAMPLE_OVERSAMPLE : (int)ranges;
+    long long *P = malloc(np * sizeof(long long));
+    long long *Pos = malloc(np * sizeof(long long));
+    long long *Tmp = malloc((size_t)n * sizeof(long long));
+    multi_partition_plan_t *plan = NULL;
+    int ret = -1;
+
+    if (P != NULL && Pos != NULL && Tmp != NULL && mp_sample_splitters(Data, n, P, np, 1, nThreads) == 0 &&
+        (plan = multi_partition_plan_create(P, np, nThreads, n)) != NULL &&
+        multi_partition_execute(plan, Data, n, Tmp, Pos) == 0)
+    {
+        sort_task_t *tasks = malloc(nThreads * sizeof(sort_task_t));
+        int next = 0;
+
+        if (tasks != NULL)
+        {
+            for (int t = 0; t < nThreads; t++)
+            {
+                tasks[t] = (sort_task_t){Data, Tmp, Pos, n, np, &next};
+            }
+            thread_pool_run(plan->pool, thread_sort_ranges, tasks, sizeof(sort_task_t));
+            free(tasks);
+            ret = 0;
+        }
+    }
+
+    multi_partition_plan_destroy(plan);
+    free(Tmp);
+    free(Pos);
+    free(P);
+    return ret;
+}
@@ -0,0 +1,50 @@
+#ifndef MP_SORT_H
+#define MP_SORT_H
+
+/**
+ * Escolha de partições por amostragem e ordenação paralela (sample sort)
+ * construída sobre `multi_partition`.
+ */
+
+#define MP_SAMPLE_OVERSAMPLE 32    // Amostras por faixa na escolha das partições.
+#define MP_SORT_RANGE_ELEMS 32768 // Tamanho alvo de cada faixa do sample sort (256 KB, cabe na L2).
+
+/**
+ * @brief Escolhe np - 1 partições a partir dos quantis de uma amostra de Input.
+ *
+ * @param Input Vetor de entrada (n elementos).
+ * @param n Número de elementos.
+ * @param P Vetor de destino (np elementos, P[np-1] = LLONG_MAX).
+ * @param np Número de partições.
+ * @param seed Semente das posições amostradas.
+ * @param nThreads Threads usadas (<= 0 = CPUs disponíveis).
+ * @return int 0 em caso de sucesso ou -1 em caso de falha de alocação ou
+ *             de parâmetros inválidos.
+ *
+ * A amostra tem MP_SAMPLE_OVERSAMPLE * np posições (no máximo n), sorteadas
+ * por um gerador baseado em contador e lidas em paralelo; é ordenada com
+ * `mp_gen_sort` e P[j] recebe o quantil (j + 1) / np. As faixas ficam com
+ * tamanhos próximos de n / np mesmo com dados enviesados; uma chave muito
+ * repetida ocupa uma faixa só (e as faixas vizinhas podem ficar vazias).
+ * A escolha não depende do número de threads.
+ */
+int mp_sample_splitters(const long long *Input, long long n, long long *P, int np, unsigned long long seed,
+                        int nThreads);
+
+/**
+ * @brief Ordena Data em paralelo (ordem crescente) com um sample sort.
+ *
+ * @param Data Vetor com n elementos.
+ * @param n Número de elementos.
+ * @param nThreads Threads usadas (<= 0 = CPUs disponíveis).
+ * @return int 0 em caso de sucesso ou -1 em caso de falha de alocação.
+ *
+ * Escolhe n / MP_SORT_RANGE_ELEMS partições por amostragem, particiona Data
+ * em um vetor auxiliar com `multi_partition_execute` e, em seguida, os
+ * workers pegam faixas dinamicamente: cada faixa (do tamanho da cache) é
+ * copiada de volta para a sua posição em Data e ordenada ali (introsort sem
+ * chamadas de comparação).
+ */
+int mp_sample_sort(long long *Data, long long n, int nThreads);
+
+#endif // MP_SORT_H
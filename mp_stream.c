@@ -0,0 +1,596 @@
+#define _GNU_SOURCE // O_DIRECT
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include "mp_stream.h"
+#include "mp_arena.h"
+#include "multi_partition.h"
+#include "splitter_index.h"
+
+#define STREAM_DEFAULT_CHUNK (8 << 20) // Elementos por bloco (64 MB)
+#define STREAM_ALIGN_ELEMS 512         // Blocos múltiplos de 4 KB (exigência de O_DIRECT)
+
+// Estado de uma execução de `multi_partition_stream`
+typedef struct
+{
+    int in_fd;            // Arquivo de entrada.
+    int direct;           // Entrada aberta com O_DIRECT.
+    int out_fd;           // Arquivo de saída (MP_STREAM_FILE) ou -1.
+    int *bucket_fd;       // Arquivos de faixa (MP_STREAM_BUCKETS) ou NULL.
+    int np;               // Número de partições.
+    long long n;          // Elementos na entrada.
+    int chunk;            // Elementos por bloco.
+    int nchunks;          // Número de blocos.
+    long long *offsets;   // Próxima posição (em elementos) de cada faixa no seu arquivo.
+    mp_stream_stats_t *stats;
+} stream_t;
+
+// Trabalho da thread de E/S durante o particionamento de um bloco
+typedef struct
+{
+    stream_t *st;
+    int read_chunk;       // Bloco a ler (-1 = nenhum).
+    long long *read_buf;  // Destino da leitura.
+    long long *write_buf; // Bloco particionado a gravar (NULL = nenhum).
+    long long *write_pos; // Início de cada faixa em write_buf.
+    int write_len;        // Elementos em write_buf.
+    int error;            // Falha de E/S.
+} stream_io_t;
+
+// Thread de E/S de vida longa: recebe um trabalho por bloco, durante toda a execução
+typedef struct
+{
+    pthread_t thread;          // Thread de E/S.
+    int running;               // Thread criada (senão, quem entrega o trabalho faz a E/S).
+    pthread_mutex_t mutex;     // Protege os campos abaixo.
+    pthread_cond_t cond_start; // Sinaliza um novo trabalho (ou encerramento).
+    pthread_cond_t cond_done;  // Sinaliza o fim do trabalho atual.
+    unsigned long generation;  // Trabalhos entregues (evita despertares espúrios).
+    unsigned long finished;    // Trabalhos concluídos.
+    int shutdown;              // Indica que a thread deve encerrar.
+    stream_io_t *job;          // Trabalho atual.
+} stream_io_thread_t;
+
+// Contagem por faixa de um bloco (primeira passada do modo MP_STREAM_FILE)
+typedef struct
+{
+    const splitter_index_t *index;
+    int np;
+    const long long *Input;
+    int start, end;
+    long long *counts; // Contagens acumuladas da thread (linha própria).
+} stream_count_t;
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int chunk_len(const stream_t *st, int k)
+{
+    long long left = st->n - (long long)k * st->chunk;
+    return left < st->chunk ? (int)left : st->chunk;
+}
+
+static int pread_all(int fd, char *buf, size_t bytes, off_t offset)
+{
+    while (bytes > 0)
+    {
+        ssize_t r = pread(fd, buf, bytes, offset);
+        if (r < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (r <= 0)
+        {
+            return -1;
+        }
+        buf += r;
+        bytes -= r;
+        offset += r;
+    }
+    return 0;
+}
+
+static int pwrite_all(int fd, const char *buf, size_t bytes, off_t offset)
+{
+    while (bytes > 0)
+    {
+        ssize_t w = pwrite(fd, buf, bytes, offset);
+        if (w < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (w <= 0)
+        {
+            return -1;
+        }
+        buf += w;
+        bytes -= w;
+        offset += w;
+    }
+    return 0;
+}
+
+static int read_chunk(stream_t *st, int k, long long *buf)
+{
+    size_t bytes = (size_t)chunk_len(st, k) * sizeof(long long);
+    off_t offset = (off_t)k * st->chunk * sizeof(long long);
+
+    if (st->direct)
+    {
+        // O_DIRECT lê blocos inteiros; o último bloco do arquivo volta curto
+        size_t aligned = (bytes + 4095) & ~(size_t)4095;
+        ssize_t r;
+        do
+        {
+            r = pread(st->in_fd, buf, aligned, offset);
+        } while (r < 0 && errno == EINTR);
+        if (r < (ssize_t)bytes)
+        {
+            // Leitura parcial com O_DIRECT: completa sem alinhamento
+            return r < 0 ? -1 : pread_all(st->in_fd, (char *)buf + r, bytes - r, offset + r);
+        }
+        return 0;
+    }
+    return pread_all(st->in_fd, (char *)buf, bytes, offset);
+}
+
+// Anexa cada faixa de um bloco particionado à sua faixa na saída
+static int write_chunk(stream_t *st, const long long *buf, const long long *pos, int len)
+{
+    for (int j = 0; j < st->np; j++)
+    {
+        long long count = (j + 1 < st->np ? pos[j + 1] : len) - pos[j];
+        if (count == 0)
+        {
+            continue;
+        }
+
+        int fd = st->bucket_fd != NULL ? st->bucket_fd[j] : st->out_fd;
+        if (pwrite_all(fd, (const char *)(buf + pos[j]), (size_t)count * sizeof(long long),
+                       (off_t)st->offsets[j] * sizeof(long long)) != 0)
+        {
+            return -1;
+        }
+        st->offsets[j] += count;
+    }
+    return 0;
+}
+
+static void *thread_stream_io(void *arg)
+{
+    stream_io_t *io = (stream_io_t *)arg;
+    stream_t *st = io->st;
+
+    if (io->write_buf != NULL)
+    {
+        double t0 = now_s();
+        io->error |= write_chunk(st, io->write_buf, io->write_pos, io->write_len);
+        st->stats->write += now_s() - t0;
+    }
+    if (io->read_chunk >= 0)
+    {
+        double t0 = now_s();
+        io->error |= read_chunk(st, io->read_chunk, io->read_buf);
+        st->stats->read += now_s() - t0;
+    }
+    return NULL;
+}
+
+static void *stream_io_worker(void *arg)
+{
+    stream_io_thread_t *iot = (stream_io_thread_t *)arg;
+    unsigned long seen = 0;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&iot->mutex);
+
+        // Estaciona até um novo trabalho (ou encerramento)
+        while (iot->generation == seen && !iot->shutdown)
+        {
+            pthread_cond_wait(&iot->cond_start, &iot->mutex);
+        }
+
+        if (iot->shutdown)
+        {
+            pthread_mutex_unlock(&iot->mutex);
+            return NULL;
+        }
+
+        seen = iot->generation;
+        stream_io_t *job = iot->job;
+        pthread_mutex_unlock(&iot->mutex);
+
+        thread_stream_io(job);
+
+        pthread_mutex_lock(&iot->mutex);
+        iot->finished = seen;
+        pthread_cond_signal(&iot->cond_done);
+        pthread_mutex_unlock(&iot->mutex);
+    }
+}
+
+static void stream_io_start(stream_io_thread_t *iot)
+{
+    memset(iot, 0, sizeof(*iot));
+    pthread_mutex_init(&iot->mutex, NULL);
+    pthread_cond_init(&iot->cond_start, NULL);
+    pthread_cond_init(&iot->cond_done, NULL);
+    iot->running = pthread_create(&iot->thread, NULL, stream_io_worker, iot) == 0;
+}
+
+// Entrega um trabalho sem esperar (ou o executa, se a thread não existe)
+static void stream_io_submit(stream_io_thread_t *iot, stream_io_t *job)
+{
+    if (!iot->running)
+    {
+        thread_stream_io(job);
+        return;
+    }
+    pthread_mutex_lock(&iot->mutex);
+    iot->job = job;
+    iot->generation++;
+    pthread_cond_signal(&iot->cond_start);
+    pthread_mutex_unlock(&iot->mutex);
+}
+
+// Espera o fim do último trabalho entregue
+static void stream_io_wait(stream_io_thread_t *iot)
+{
+    pthread_mutex_lock(&iot->mutex);
+    while (iot->finished != iot->generation)
+    {
+        pthread_cond_wait(&iot->cond_done, &iot->mutex);
+    }
+    pthread_mutex_unlock(&iot->mutex);
+}
+
+static void stream_io_stop(stream_io_thread_t *iot)
+{
+    if (iot->running)
+    {
+        pthread_mutex_lock(&iot->mutex);
+        iot->shutdown = 1;
+        pthread_cond_signal(&iot->cond_start);
+        pthread_mutex_unlock(&iot->mutex);
+        pthread_join(iot->thread, NULL);
+    }
+    pthread_cond_destroy(&iot->cond_start);
+    pthread_cond_destroy(&iot->cond_done);
+    pthread_mutex_destroy(&iot->mutex);
+}
+
+static void *thread_stream_count(void *arg)
+{
+    stream_count_t *c = (stream_count_t *)arg;
+
+    for (int i = c->start; i < c->end; i++)
+    {
+        int id = splitter_index_search(c->index, c->Input[i]);
+        c->counts[id < c->np ? id : c->np - 1]++;
+    }
+    return NULL;
+}
+
+/**
+ * Uma passada sobre a entrada com leitura antecipada: enquanto o bloco k é
+ * processado, a thread de E/S lê o bloco k + 1 e (se `plan` != NULL) grava o
+ * bloco k - 1 já particionado. Sem plano, apenas conta (com `counts`).
+ */
+static int stream_pass(stream_t *st, stream_io_thread_t *iot, multi_partition_plan_t *plan, stream_count_t *counts,
+                       thread_pool_t *pool, long long **in, long long **out, long long **pos)
+{
+    double t0 = now_s();
+    if (read_chunk(st, 0, in[0]) != 0)
+    {
+        return -1;
+    }
+    st->stats->read += now_s() - t0;
+
+    for (int k = 0; k < st->nchunks; k++)
+    {
+        int len = chunk_len(st, k);
+        stream_io_t io = {st, -1, NULL, NULL, NULL, 0, 0};
+        int io_pending = 0;
+
+        if (k + 1 < st->nchunks)
+        {
+            io.read_chunk = k + 1;
+            io.read_buf = in[(k + 1) & 1];
+        }
+        if (plan != NULL && k > 0)
+        {
+            io.write_buf = out[(k - 1) & 1];
+            io.write_pos = pos[(k - 1) & 1];
+            io.write_len = chunk_len(st, k - 1);
+        }
+
+        if (io.read_chunk >= 0 || io.write_buf != NULL)
+        {
+            stream_io_submit(iot, &io);
+            io_pending = 1;
+        }
+
+        t0 = now_s();
+        if (plan != NULL)
+        {
+            multi_partition_execute(plan, in[k & 1], len, out[k & 1], pos[k & 1]);
+        }
+        else
+        {
+            int nThreads = pool->nThreads;
+            int size = (len + nThreads - 1) / nThreads;
+            for (int t = 0; t < nThreads; t++)
+            {
+                long long s = (long long)t * size, e = s + size;
+                counts[t].Input = in[k & 1];
+                counts[t].start = s > len ? len : (int)s;
+                counts[t].end = e > len ? len : (int)e;
+            }
+            thread_pool_run(pool, thread_stream_count, counts, sizeof(stream_count_t));
+        }
+        st->stats->compute += now_s() - t0;
+
+        if (io_pending)
+        {
+            stream_io_wait(iot);
+        }
+        if (io.error)
+        {
+            return -1;
+        }
+    }
+
+    // Último bloco particionado
+    if (plan != NULL && st->nchunks > 0)
+    {
+        int k = st->nchunks - 1;
+        t0 = now_s();
+        if (write_chunk(st, out[k & 1], pos[k & 1], chunk_len(st, k)) != 0)
+        {
+            return -1;
+        }
+        st->stats->write += now_s() - t0;
+    }
+    return 0;
+}
+
+// Abre um arquivo por faixa, elevando o limite de descritores se preciso
+static int open_buckets(stream_t *st, const char *prefix)
+{
+    struct rlimit rl;
+
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < (rlim_t)st->np + 16)
+    {
+        rl.rlim_cur = rl.rlim_max == RLIM_INFINITY || rl.rlim_max >= (rlim_t)st->np + 16 ? (rlim_t)st->np + 16 : rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
+
+    st->bucket_fd = malloc(st->np * sizeof(int));
+    if (st->bucket_fd == NULL)
+    {
+        return -1;
+    }
+
+    size_t len = strlen(prefix) + 16;
+    char *path = malloc(len);
+    for (int j = 0; j < st->np; j++)
+    {
+        st->bucket_fd[j] = -1;
+    }
+    for (int j = 0; path != NULL && j < st->np; j++)
+    {
+        snprintf(path, len, "%s.%d", prefix, j);
+        st->bucket_fd[j] = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (st->bucket_fd[j] < 0)
+        {
+            break;
+        }
+    }
+    free(path);
+    return st->bucket_fd[st->np - 1] >= 0 ? 0 : -1;
+}
+
+static void close_stream(stream_t *st)
+{
+    if (st->in_fd >= 0)
+    {
+        close(st->in_fd);
+    }
+    if (st->out_fd >= 0)
+    {
+        close(st->out_fd);
+    }
+    if (st->bucket_fd != NULL)
+    {
+        for (int j = 0; j < st->np && st->bucket_fd[j] >= 0; j++)
+        {
+            close(st->bucket_fd[j]);
+        }
+        free(st->bucket_fd);
+    }
+    free(st->offsets);
+}
+
+int multi_partition_stream(const char *input_path, long long *P, int np, const char *output_path, long long *Pos,
+                           const mp_stream_options_t *opt, mp_stream_stats_t *stats)
+{
+    mp_stream_options_t defaults = {1, 0, MP_STREAM_FILE, 0};
+    mp_stream_stats_t local_stats;
+    stream_t st;
+    struct stat sb;
+    int ret = -1;
+
+    opt = opt != NULL ? opt : &defaults;
+    stats = stats != NULL ? stats : &local_stats;
+    memset(stats, 0, sizeof(*stats));
+    memset(&st, 0, sizeof(st));
+    st.in_fd = st.out_fd = -1;
+    st.np = np;
+    st.stats = stats;
+
+    if (P == NULL || np <= 0 || opt->nThreads <= 0 || opt->chunk_elems < 0)
+    {
+        return -1;
+    }
+
+    double start = now_s();
+
+#ifdef O_DIRECT
+    if (opt->direct)
+    {
+        st.in_fd = open(input_path, O_RDONLY | O_DIRECT);
+        st.direct = st.in_fd >= 0;
+    }
+#endif
+    if (st.in_fd < 0)
+    {
+        st.in_fd = open(input_path, O_RDONLY);
+    }
+    if (st.in_fd < 0 || fstat(st.in_fd, &sb) != 0 || sb.st_size % sizeof(long long) != 0)
+    {
+        close_stream(&st);
+        return -1;
+    }
+    if (!st.direct)
+    {
+        posix_fadvise(st.in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    st.n = sb.st_size / sizeof(long long);
+    st.chunk = opt->chunk_elems > 0 ? opt->chunk_elems : STREAM_DEFAULT_CHUNK;
+    st.chunk = (st.chunk + STREAM_ALIGN_ELEMS - 1) / STREAM_ALIGN_ELEMS * STREAM_ALIGN_ELEMS;
+    st.nchunks = (int)((st.n + st.chunk - 1) / st.chunk);
+    st.offsets = calloc(np, sizeof(long long));
+    stats->n = st.n;
+    stats->chunks = st.nchunks;
+
+    if (st.offsets == NULL)
+    {
+        close_stream(&st);
+        return -1;
+    }
+    if (opt->output == MP_STREAM_BUCKETS)
+    {
+        if (open_buckets(&st, output_path) != 0)
+        {
+            close_stream(&st);
+            return -1;
+        }
+    }
+    else
+    {
+        st.out_fd = open(output_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (st.out_fd < 0 || ftruncate(st.out_fd, (off_t)st.n * sizeof(long long)) != 0)
+        {
+            close_stream(&st);
+            return -1;
+        }
+    }
+
+    // Memória limitada: dois blocos de entrada, dois de saída e o plano
+    multi_partition_plan_t *plan = multi_partition_plan_create(P, np, opt->nThreads, st.chunk);
+    mp_arena_t *arena = mp_arena_create(0);
+    long long *in[2] = {NULL, NULL}, *out[2] = {NULL, NULL};
+    long long *pos[2] = {malloc(np * sizeof(long long)), malloc(np * sizeof(long long))};
+    stream_count_t *counts = malloc(opt->nThreads * sizeof(stream_count_t));
+    splitter_index_t *index = splitter_index_create(P, np);
+
+    if (plan != NULL && arena != NULL)
+    {
+        // Blocos de entrada primeiro: ficam alinhados a 4 KB para O_DIRECT
+        for (int b = 0; b < 2; b++)
+        {
+            in[b] = mp_arena_alloc(arena, (size_t)st.chunk * sizeof(long long));
+        }
+        for (int b = 0; b < 2; b++)
+        {
+            out[b] = mp_arena_alloc(arena, (size_t)st.chunk * sizeof(long long));
+        }
+        mp_arena_prefault(arena, plan->pool);
+    }
+
+    if (plan != NULL && arena != NULL && in[0] != NULL && in[1] != NULL && out[0] != NULL && out[1] != NULL &&
+        pos[0] != NULL && pos[1] != NULL && counts != NULL && index != NULL)
+    {
+        stream_io_thread_t iot;
+        stream_io_start(&iot);
+        ret = 0;
+
+        // Primeira passada (arquivo único): contagem de cada faixa fixa Pos
+        if (opt->output == MP_STREAM_FILE && st.nchunks > 0)
+        {
+            for (int t = 0; t < opt->nThreads && ret == 0; t++)
+            {
+                counts[t] = (stream_count_t){index, np, NULL, 0, 0, mp_arena_alloc(arena, np * sizeof(long long))};
+                ret = counts[t].counts != NULL ? 0 : -1;
+                if (ret == 0)
+                {
+                    memset(counts[t].counts, 0, np * sizeof(long long));
+                }
+            }
+
+            if (ret == 0)
+            {
+                ret = stream_pass(&st, &iot, NULL, counts, plan->pool, in, out, pos);
+            }
+
+            // Cada faixa começa no fim das anteriores
+            long long offset = 0;
+            for (int j = 0; j < np && ret == 0; j++)
+            {
+                st.offsets[j] = offset;
+                for (int t = 0; t < opt->nThreads; t++)
+                {
+                    offset += counts[t].counts[j];
+                }
+            }
+        }
+
+        // Arquivo único: Pos é o início de cada faixa, fixado antes da escrita
+        for (int j = 0; j < np && opt->output == MP_STREAM_FILE; j++)
+        {
+            Pos[j] = st.offsets[j];
+        }
+
+        if (ret == 0 && st.nchunks > 0)
+        {
+            ret = stream_pass(&st, &iot, plan, NULL, plan->pool, in, out, pos);
+        }
+        stream_io_stop(&iot);
+
+        // Arquivos de faixa: Pos como se os arquivos fossem concatenados
+        if (ret == 0 && opt->output == MP_STREAM_BUCKETS)
+        {
+            long long offset = 0;
+            for (int j = 0; j < np; j++)
+            {
+                Pos[j] = offset;
+                offset += st.offsets[j];
+            }
+        }
+    }
+
+    splitter_index_destroy(index);
+    free(counts);
+    free(pos[0]);
+    free(pos[1]);
+    mp_arena_destroy(arena);
+    multi_partition_plan_destroy(plan);
+    close_stream(&st);
+
+    stats->total = now_s() - start;
+    return ret;
+}
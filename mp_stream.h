@@ -0,0 +1,74 @@
+#ifndef MP_STREAM_H
+#define MP_STREAM_H
+
+/**
+ * Particionamento out-of-core: a entrada é um arquivo de chaves de 64 bits
+ * (long long, na ordem de bytes da máquina), possivelmente maior que a
+ * memória, processado em blocos de tamanho fixo.
+ */
+
+/**
+ * @brief Formato da saída de `multi_partition_stream`.
+ */
+typedef enum
+{
+    MP_STREAM_FILE = 0, // Um único arquivo com as faixas em ordem, como Output.
+    MP_STREAM_BUCKETS   // Um arquivo por faixa: "<saída>.<j>".
+} mp_stream_output_t;
+
+/**
+ * @brief Opções de `multi_partition_stream`.
+ */
+typedef struct
+{
+    int nThreads;              // Workers do particionamento de cada bloco.
+    int chunk_elems;           // Elementos por bloco (0 = 8M, isto é, 64 MB).
+    mp_stream_output_t output; // Formato da saída.
+    int direct;                // Lê a entrada com O_DIRECT (sem cache de páginas), se suportado.
+} mp_stream_options_t;
+
+/**
+ * @brief Tempos de uma execução de `multi_partition_stream` (segundos).
+ *
+ * Leitura e escrita acontecem em uma thread de E/S, em paralelo com o
+ * particionamento; `total` próximo de `read + write` indica que o disco,
+ * e não a CPU, é o limite.
+ */
+typedef struct
+{
+    long long n; // Elementos particionados.
+    int chunks;  // Blocos processados (por passada).
+    double read;    // Tempo da thread de E/S lendo a entrada.
+    double write;   // Tempo da thread de E/S gravando a saída.
+    double compute; // Tempo de contagem e particionamento dos blocos.
+    double total;   // Tempo de parede total.
+} mp_stream_stats_t;
+
+/**
+ * @brief Particiona um arquivo de chaves em np faixas, bloco a bloco.
+ *
+ * @param input_path Arquivo de entrada (n chaves de 8 bytes).
+ * @param P Vetor de partições (ordenado, P[np-1] = LLONG_MAX).
+ * @param np Número de partições.
+ * @param output_path Arquivo de saída (MP_STREAM_FILE) ou prefixo dos arquivos de faixa (MP_STREAM_BUCKETS).
+ * @param Pos Vetor (tamanho np) com o início de cada faixa na saída, contado em elementos
+ *            (no modo MP_STREAM_BUCKETS, o início que a faixa teria com os arquivos concatenados).
+ * @param opt Opções (NULL = padrão, uma thread).
+ * @param stats Tempos da execução (pode ser NULL).
+ * @return int 0 em caso de sucesso ou -1 em caso de erro de E/S ou de alocação.
+ *
+ * Cada bloco é particionado com um plano de `multi_partition` (mesmo P em
+ * todos os blocos) e cada faixa do bloco é anexada à sua faixa na saída, de
+ * modo que o resultado é estável e igual ao de `multi_partition` sobre o
+ * arquivo inteiro. No modo MP_STREAM_FILE, uma primeira passada conta os
+ * elementos de cada faixa para fixar Pos; no modo MP_STREAM_BUCKETS basta
+ * uma passada.
+ *
+ * A memória usada é limitada a dois blocos de entrada, dois de saída e o
+ * plano, independentemente do tamanho do arquivo: enquanto os workers
+ * particionam o bloco k, a thread de E/S grava o bloco k - 1 e lê o k + 1.
+ */
+int multi_partition_stream(const char *input_path, long long *P, int np, const char *output_path, long long *Pos,
+                           const mp_stream_options_t *opt, mp_stream_stats_t *stats);
+
+#endif // MP_STREAM_H
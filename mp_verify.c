@@ -0,0 +1,239 @@
+#include <limits.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "mp_verify.h"
+#include "thread_pool.h"
+
+// Elementos verificados de cada vez antes de olhar o indicador de erro
+#define VERIFY_BLOCK 1024
+
+// Argumento de cada worker
+typedef struct
+{
+    const long long *Input;
+    const long long *P;
+    const long long *Output;
+    const long long *Pos;
+    long long n;
+    int np;
+    int id;
+    int nThreads;
+    long long first_bad;    // Primeiro índice errado da fatia de Output (-1 = nenhum).
+    int bad_range;          // Faixa desse índice.
+    unsigned long long in_sum, in_xor, out_sum, out_xor;
+} verify_task_t;
+
+// Finalizador do splitmix64: espalha cada chave pelos 64 bits antes de somar
+static inline unsigned long long mix_key(long long key)
+{
+    unsigned long long z = (unsigned long long)key + 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// Intervalo [start, end) de n verificado pela thread t
+static void verify_chunk(long long n, int nThreads, int t, long long *start, long long *end)
+{
+    long long size = (n + nThreads - 1) / nThreads;
+    long long s = t * size, e = s + size;
+
+    *start = s > n ? n : s;
+    *end = e > n ? n : e;
+}
+
+// Faixa que contém a posição k de Output (última j com Pos[j] <= k)
+static int range_of(const long long *Pos, int np, long long k)
+{
+    int left = 0, right = np - 1;
+
+    while (left < right)
+    {
+        int mid = left + (right - left + 1) / 2;
+        if (Pos[mid] <= k)
+        {
+            left = mid;
+        }
+        else
+        {
+            right = mid - 1;
+        }
+    }
+    return left;
+}
+
+static void *thread_verify(void *arg)
+{
+    verify_task_t *task = (verify_task_t *)arg;
+    const long long *Output = task->Output;
+    const long long *P = task->P;
+    const long long *Pos = task->Pos;
+    int np = task->np;
+    long long n = task->n;
+    unsigned long long sum = 0, x = 0;
+    long long start, end;
+
+    // Hash de Input
+    verify_chunk(n, task->nThreads, task->id, &start, &end);
+    for (long long i = start; i < end; i++)
+    {
+        unsigned long long h = mix_key(task->Input[i]);
+        sum += h;
+        x ^= h;
+    }
+    task->in_sum = sum;
+    task->in_xor = x;
+
+    // Limites e hash de Output, faixa por faixa dentro da fatia
+    sum = 0;
+    x = 0;
+    task->first_bad = -1;
+    task->bad_range = -1;
+    long long k = start;
+    int j = start < end ? range_of(Pos, np, k) : 0;
+    while (k < end)
+    {
+        while (j + 1 < np && Pos[j + 1] <= k)
+        {
+            j++; // Pula faixas vazias
+        }
+
+        long long stop = j + 1 < np && Pos[j + 1] < end ? Pos[j + 1] : end;
+        long long lo = j > 0 ? P[j - 1] : LLONG_MIN;
+        long long hi = j < np - 1 ? P[j] : LLONG_MAX;
+        int has_hi = j < np - 1; // A última faixa também recebe as chaves >= P[np-1]
+
+        // Indicador sem desvios por bloco; o índice exato só é procurado se houver erro
+        for (long long b = k; b < stop; b += VERIFY_BLOCK)
+        {
+            long long e = b + VERIFY_BLOCK < stop ? b + VERIFY_BLOCK : stop;
+            int bad = 0;
+            for (long long i = b; i < e; i++)
+            {
+                long long v = Output[i];
+                unsigned long long h = mix_key(v);
+                sum += h;
+                x ^= h;
+                bad |= (v < lo) | (has_hi & (v >= hi));
+            }
+            if (bad)
+            {
+                for (long long i = b; i < e; i++)
+                {
+                    long long v = Output[i];
+                    if (v < lo || (has_hi && v >= hi))
+                    {
+                        task->first_bad = i;
+                        task->bad_range = j;
+                        break;
+                    }
+                }
+                // Fatias posteriores não têm como conter um erro anterior a este
+                task->out_sum = sum;
+                task->out_xor = x;
+                return NULL;
+            }
+        }
+        k = stop;
+    }
+    task->out_sum = sum;
+    task->out_xor = x;
+    return NULL;
+}
+
+int multi_partition_verify(const long long *Input, long long n, const long long *P, int np, const long long *Output,
+                           const long long *Pos, int nThreads, mp_verify_result_t *result)
+{
+    mp_verify_result_t res = {MP_VERIFY_OK, -1, -1, 0, 0, 0, 0};
+
+    if (nThreads <= 0)
+    {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        nThreads = cpus > 0 ? (int)cpus : 1;
+    }
+
+    // Pos: começa em 0, não decresce e não passa de n
+    for (int j = 0; j < np; j++)
+    {
+        long long prev = j > 0 ? Pos[j - 1] : 0;
+        if ((j == 0 && Pos[0] != 0) || Pos[j] < prev || Pos[j] > n)
+        {
+            res.status = MP_VERIFY_POS;
+            res.index = j;
+            res.range = j;
+            break;
+        }
+    }
+
+    if (res.status == MP_VERIFY_OK)
+    {
+        verify_task_t *tasks = malloc(nThreads * sizeof(verify_task_t));
+        thread_pool_t *pool = nThreads > 1 ? thread_pool_create(nThreads) : NULL;
+        if (tasks == NULL || (nThreads > 1 && pool == NULL))
+        {
+            free(tasks);
+            thread_pool_destroy(pool);
+            return -1;
+        }
+
+        for (int t = 0; t < nThreads; t++)
+        {
+            tasks[t] = (verify_task_t){Input, P, Output, Pos, n, np, t, nThreads, -1, -1, 0, 0, 0, 0};
+        }
+        if (pool != NULL)
+        {
+            thread_pool_run(pool, thread_verify, tasks, sizeof(verify_task_t));
+        }
+        else
+        {
+            thread_verify(tasks);
+        }
+
+        // O primeiro erro é o da primeira fatia que encontrou algum
+        for (int t = 0; t < nThreads; t++)
+        {
+            if (res.status == MP_VERIFY_OK && tasks[t].first_bad >= 0)
+            {
+                res.status = MP_VERIFY_RANGE;
+                res.index = tasks[t].first_bad;
+                res.range = tasks[t].bad_range;
+            }
+            res.input_sum += tasks[t].in_sum;
+            res.input_xor ^= tasks[t].in_xor;
+            res.output_sum += tasks[t].out_sum;
+            res.output_xor ^= tasks[t].out_xor;
+        }
+
+        // Com um erro de faixa, o hash de Output ficou incompleto
+        if (res.status == MP_VERIFY_OK && (res.input_sum != res.output_sum || res.input_xor != res.output_xor))
+        {
+            res.status = MP_VERIFY_MULTISET;
+        }
+
+        thread_pool_destroy(pool);
+        free(tasks);
+    }
+
+    if (result != NULL)
+    {
+        *result = res;
+    }
+    return res.status == MP_VERIFY_OK ? 0 : 1;
+}
+
+const char *multi_partition_verify_status(mp_verify_status_t status)
+{
+    switch (status)
+    {
+    case MP_VERIFY_OK:
+        return "correto";
+    case MP_VERIFY_POS:
+        return "Pos inválido";
+    case MP_VERIFY_RANGE:
+        return "elemento fora da faixa";
+    case MP_VERIFY_MULTISET:
+        return "Output não é uma permutação de Input";
+    }
+    return "desconhecido";
+}
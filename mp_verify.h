@@ -0,0 +1,65 @@
+#ifndef MP_VERIFY_H
+#define MP_VERIFY_H
+
+/**
+ * Verificação paralela e completa do resultado de `multi_partition`.
+ */
+
+/**
+ * @brief Resultado de `multi_partition_verify`.
+ */
+typedef enum
+{
+    MP_VERIFY_OK = 0,  // Particionamento correto.
+    MP_VERIFY_POS,     // Pos inválido (início diferente de 0, decrescente ou além de n).
+    MP_VERIFY_RANGE,   // Elemento fora dos limites da sua faixa.
+    MP_VERIFY_MULTISET // Output não é uma permutação de Input.
+} mp_verify_status_t;
+
+/**
+ * @brief Detalhes da verificação.
+ */
+typedef struct
+{
+    mp_verify_status_t status;
+    long long index;               // MP_VERIFY_POS: posição de Pos; MP_VERIFY_RANGE: primeiro índice errado em Output; senão -1.
+    int range;                     // Faixa do elemento (ou de Pos) com erro; -1 se não se aplica.
+    unsigned long long input_sum;  // Soma das chaves misturadas de Input.
+    unsigned long long input_xor;  // Xor das chaves misturadas de Input.
+    unsigned long long output_sum; // Soma das chaves misturadas de Output.
+    unsigned long long output_xor; // Xor das chaves misturadas de Output.
+} mp_verify_result_t;
+
+/**
+ * @brief Verifica em paralelo se Output e Pos são um particionamento de Input por P.
+ *
+ * @param Input Vetor de entrada (n elementos).
+ * @param n Número de elementos.
+ * @param P Vetor de partições (ordenado).
+ * @param np Número de partições.
+ * @param Output Vetor particionado.
+ * @param Pos Início de cada faixa em Output (np posições).
+ * @param nThreads Threads usadas na verificação (<= 0 = CPUs disponíveis).
+ * @param result Detalhes do primeiro erro encontrado (pode ser NULL).
+ * @return int 0 se correto, 1 se há erro ou -1 em caso de falha de alocação.
+ *
+ * Confere que Pos começa em 0, não decresce e não passa de n (as faixas
+ * somam n) e que cada elemento da faixa j está em [P[j-1], P[j]) — sem limite
+ * inferior na primeira faixa e sem limite superior na última, que também
+ * recebe as chaves >= P[np-1]. Em seguida, compara a soma e o xor das chaves
+ * misturadas (splitmix64) de Input e de Output, que independem da ordem:
+ * diferença indica que Output não é uma permutação de Input.
+ *
+ * Cada thread lê uma fatia contígua de Output (limites e hash na mesma
+ * passada) e uma de Input, de modo que o custo é o de ler os dois vetores
+ * uma vez.
+ */
+int multi_partition_verify(const long long *Input, long long n, const long long *P, int np, const long long *Output,
+                           const long long *Pos, int nThreads, mp_verify_result_t *result);
+
+/**
+ * @brief Descrição curta de um resultado de `multi_partition_verify`.
+ */
+const char *multi_partition_verify_status(mp_verify_status_t status);
+
+#endif // MP_VERIFY_H
@@ -3,242 +3,1921 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
 
 #include "multi_partition.h"
+#include "mp_arena.h"
+#include "mp_profile.h"
+#include "mp_verify.h"
+#include "splitter_index.h"
+#include "thread_pool.h"
+#include "topology.h"
 #include "util.h"
 
+// Índice da faixa de `value`; valores >= P[np-1] pertencem à última faixa
+static inline int classify_partition(const splitter_index_t *index, int np, long long value)
+{
+    int partition = splitter_index_search(index, value);
+    return partition < np ? partition : np - 1;
+}
+
+// Elementos contados de cada vez com contadores de 32 bits, antes de
+// somá-los às contagens de 64 bits
+#define COUNT32_BLOCK (1LL << 31)
+
+// Menor árvore (em nós de 64 bytes) classificada com a busca em lote: abaixo
+// disso (32 KB de chaves) o índice fica na L1 e a busca de uma chave por vez
+// é mais rápida
+#define BATCH_SEARCH_MIN_BLOCKS 512
+
+// Usa a busca em lote com o índice `index`?
+static inline int use_batch_search(int enabled, const splitter_index_t *index)
+{
+    return enabled && index->nblocks >= BATCH_SEARCH_MIN_BLOCKS;
+}
+
+// Classifica `values` (até SPLITTER_BATCH chaves) e conta cada uma, chamando
+// `emit(i, partition)` para a chave i do lote
+#define CLASSIFY_BATCH(index, np, values, m, counts32, emit)                 \
+    do                                                                       \
+    {                                                                        \
+        int part_[SPLITTER_BATCH];                                           \
+        splitter_index_search_batch(index, values, m, part_);                \
+        for (int b_ = 0; b_ < (m); b_++)                                     \
+        {                                                                    \
+            int partition_ = part_[b_] < (np) ? part_[b_] : (np) - 1;        \
+            emit(b_, partition_);                                            \
+            counts32[partition_]++;                                          \
+        }                                                                    \
+    } while (0)
+
+// Classifica cada elemento uma única vez: grava o índice da faixa em `ids`
+// (com a largura `type`) e conta o elemento na mesma passada. Com árvores
+// grandes, as chaves são classificadas em lotes intercalados.
+#define CLASSIFY_AND_COUNT(type)                                   \
+    do                                                             \
+    {                                                              \
+        type *ids = (type *)data->T;                               \
+        if (batch)                                                 \
+        {                                                          \
+            for (long long i = lo; i < hi; i += SPLITTER_BATCH)    \
+            {                                                      \
+                int m = hi - i < SPLITTER_BATCH ? (int)(hi - i) : SPLITTER_BATCH; \
+                type *out = ids + i;                               \
+                CLASSIFY_BATCH(index, np, Input + i, m, counts32, STORE_ID); \
+            }                                                      \
+            break;                                                 \
+        }                                                          \
+        for (long long i = lo; i < hi; i++)                        \
+        {                                                          \
+            int partition = classify_partition(index, np, Input[i]); \
+            ids[i] = (type)partition;                              \
+            counts32[partition]++;                                 \
+        }                                                          \
+    } while (0)
+
+// Grava o índice da faixa da chave b do lote em `out`
+#define STORE_ID(b, partition) (out[b] = (partition))
+
+// Só conta (contagem do in-place)
+#define COUNT_ONLY(b, partition) ((void)0)
+
+// Intervalo [start, end) de Input coberto pelo morsel m
+static inline void morsel_range(const morsel_shared_t *ms, int m, long long *start, long long *end)
+{
+    long long s = m * ms->size, e = s + ms->size;
+
+    *start = s > ms->n ? ms->n : s;
+    *end = e > ms->n ? ms->n : e;
+}
+
+// Classifica e conta [start, end) em local_counts. O laço usa contadores de
+// 32 bits (metade da banda e da cache das contagens) em blocos de até 2^31
+// elementos, somados às contagens de 64 bits no fim de cada bloco.
+static void count_range(thread_data_t *data, long long start, long long end, long long *local_counts)
+{
+    long long *Input = data->Input;
+    const splitter_index_t *index = data->index;
+    unsigned int *counts32 = data->counts32;
+    int np = data->np;
+    int batch = use_batch_search(data->batch_search, index);
+
+    memset(local_counts, 0, np * sizeof(long long));
+    for (long long lo = start; lo < end; lo += COUNT32_BLOCK)
+    {
+        long long hi = end - lo > COUNT32_BLOCK ? lo + COUNT32_BLOCK : end;
+
+        memset(counts32, 0, np * sizeof(unsigned int));
+
+        // Contagem local com busca no índice de P, guardando o índice da faixa em T
+        switch (data->id_bytes)
+        {
+        case 1:
+            CLASSIFY_AND_COUNT(unsigned char);
+            break;
+        case 2:
+            CLASSIFY_AND_COUNT(unsigned short);
+            break;
+        default:
+            CLASSIFY_AND_COUNT(int);
+            break;
+        }
+
+        for (int j = 0; j < np; j++)
+        {
+            local_counts[j] += counts32[j];
+        }
+    }
+}
+
 void *thread_count_partition(void *arg)
 {
     thread_data_t *data = (thread_data_t *)arg;
-    int start = data->start, end = data->end;
-    long long *Input = data->Input, *P = data->P;
-    int np = data->np;
-    int *local_counts = data->local_counts;
+    morsel_shared_t *ms = data->morsels;
 
-    // Contagem local com busca binária
-    for (int i = start; i < end; i++)
+    if (ms == NULL)
     {
-        int partition = binary_search_partition(P, np, Input[i]);
-        local_counts[partition]++;
+        count_range(data, data->start, data->end, data->local_counts);
+    }
+    else
+    {
+        // Cada morsel é contado em sua própria linha, seja qual for a thread
+        int m;
+        while ((m = __atomic_fetch_add(&ms->next_count, 1, __ATOMIC_RELAXED)) < ms->count)
+        {
+            long long start, end;
+            morsel_range(ms, m, &start, &end);
+            count_range(data, start, end, ms->counts[m]);
+        }
     }
+    MP_PROFILE_MARK(data->prof, MP_PHASE_CLASSIFY);
 
     pthread_barrier_wait(data->barrier); // Sincroniza threads
+    MP_PROFILE_MARK(data->prof, MP_PHASE_BARRIER);
     return NULL;
 }
 
-void merge_counts(int *global_counts, int **local_counts, int nThreads, int np)
+void *thread_prefix_counts(void *arg)
 {
-    for (int t = 0; t < nThreads; t++)
+    thread_data_t *data = (thread_data_t *)arg;
+    int nThreads = data->nThreads;
+    int np = data->np;
+    // Uma linha de contagens por thread ou, no modo de morsels, por morsel
+    int nrows = data->morsels != NULL ? data->morsels->count : nThreads;
+    long long **all_counts = data->morsels != NULL ? data->morsels->counts : data->all_counts;
+    long long *global_counts = data->global_counts;
+    long long *Pos = data->Pos;
+
+    // Cada thread cuida de uma fatia contígua das np faixas
+    int slice = (np + nThreads - 1) / nThreads;
+    int first = data->id * slice > np ? np : data->id * slice;
+    int last = first + slice > np ? np : first + slice;
+
+    // Prefix sum exclusivo por coluna: all_counts[t][j] passa a ser o
+    // deslocamento da thread t dentro da faixa j
+    long long slice_sum = 0;
+    for (int j = first; j < last; j++)
     {
-        for (int j = 0; j < np; j++)
+        long long sum = 0;
+        for (int t = 0; t < nrows; t++)
+        {
+            long long c = all_counts[t][j];
+            all_counts[t][j] = sum;
+            sum += c;
+        }
+        global_counts[j] = sum;
+        slice_sum += sum;
+    }
+    data->slice_sums[data->id] = slice_sum;
+    MP_PROFILE_MARK(data->prof, MP_PHASE_PREFIX);
+
+    pthread_barrier_wait(data->barrier);
+    MP_PROFILE_MARK(data->prof, MP_PHASE_BARRIER);
+
+    // Início da fatia = soma das fatias anteriores
+    long long base = 0;
+    for (int t = 0; t < data->id; t++)
+    {
+        base += data->slice_sums[t];
+    }
+
+    // Pos e deslocamentos absolutos de cada thread em cada faixa
+    for (int j = first; j < last; j++)
+    {
+        Pos[j] = base;
+        for (int t = 0; t < nrows; t++)
         {
-            global_counts[j] += local_counts[t][j];
+            all_counts[t][j] += base;
         }
+        base += global_counts[j];
     }
+    MP_PROFILE_MARK(data->prof, MP_PHASE_PREFIX);
+
+    pthread_barrier_wait(data->barrier);
+    MP_PROFILE_MARK(data->prof, MP_PHASE_BARRIER);
+    return NULL;
 }
 
-thread_data_t *create_thread_data(int start, int end, long long *Input, long long *P, int np, int *local_counts, int *T, pthread_mutex_t *mutex, pthread_barrier_t *barrier)
+#define SCATTER(type)                                    \
+    do                                                   \
+    {                                                    \
+        const type *ids = (const type *)data->T;         \
+        for (long long i = start; i < end; i++)                \
+        {                                                \
+            Output[current_index[ids[i]]++] = Input[i];  \
+        }                                                \
+    } while (0)
+
+void *thread_scatter_output(void *arg)
 {
-    // Alocar memória para a estrutura
-    thread_data_t *data = (thread_data_t *)malloc(sizeof(thread_data_t));
-    if (data == NULL)
+    thread_data_t *data = (thread_data_t *)arg;
+
+    long long *Input = data->Input;
+    long long *Output = data->Output;
+    long long *current_index = data->local_counts; // Deslocamentos desta thread
+    long long start = data->start;
+    long long end = data->end;
+
+    // Percorre o intervalo em ordem, mantendo o particionamento estável
+    switch (data->id_bytes)
     {
-        return NULL; // Retorna NULL se a alocação falhar
+    case 1:
+        SCATTER(unsigned char);
+        break;
+    case 2:
+        SCATTER(unsigned short);
+        break;
+    default:
+        SCATTER(int);
+        break;
     }
+    MP_PROFILE_MARK(data->prof, MP_PHASE_SCATTER);
+
+    return NULL;
+}
 
-    // Preencher os campos da estrutura
-    data->start = start;
-    data->end = end;
-    data->Input = Input;
-    data->P = P;
-    data->np = np;
-    data->local_counts = local_counts;
-    data->T = T;
-    data->mutex = mutex;
-    data->barrier = barrier;
+// Posição (0 a 7) de um elemento dentro de sua linha de cache de 64 bytes
+#define LINE_SLOT(ptr) ((int)(((uintptr_t)(ptr) >> 3) & 7))
 
-    return data;
+// Copia uma linha de cache completa para Output com stores não temporais
+static inline void stream_line(long long *dst, const long long *src)
+{
+#if defined(__SSE2__)
+    for (int j = 0; j < 8; j += 2)
+    {
+        _mm_stream_si128((__m128i *)(dst + j), _mm_load_si128((const __m128i *)(src + j)));
+    }
+#else
+    memcpy(dst, src, 8 * sizeof(long long));
+#endif
 }
 
-void *thread_fill_partition_indices(void *arg)
+// Cada faixa acumula os elementos em um buffer espelhando a linha de cache
+// de destino; linhas completas vão para Output com stores não temporais. As
+// linhas parciais (início da região da thread em cada faixa) usam stores
+// normais, pois são compartilhadas com as threads vizinhas.
+#define SCATTER_WC(type)                                                \
+    do                                                                  \
+    {                                                                   \
+        const type *ids = (const type *)data->T;                        \
+        for (long long i = start; i < end; i++)                               \
+        {                                                               \
+            int p = ids[i];                                             \
+            long long pos = current_index[p]++;                               \
+            long long *line = buffers + (size_t)p * 8;                  \
+            int slot = LINE_SLOT(Output + pos);                         \
+            line[slot] = Input[i];                                      \
+            if (slot == 7)                                              \
+            {                                                           \
+                long long *dst = Output + pos - 7;                      \
+                if (first_slot[p] == 0)                                 \
+                {                                                       \
+                    stream_line(dst, line);                             \
+                }                                                       \
+                else                                                    \
+                {                                                       \
+                    for (int j = first_slot[p]; j < 8; j++)             \
+                    {                                                   \
+                        dst[j] = line[j];                               \
+                    }                                                   \
+                    first_slot[p] = 0;                                  \
+                }                                                       \
+            }                                                           \
+        }                                                               \
+    } while (0)
+
+void *thread_scatter_output_wc(void *arg)
 {
     thread_data_t *data = (thread_data_t *)arg;
 
     long long *Input = data->Input;
-    long long *P = data->P;
-    int *T = data->T;
-    int start = data->start;
-    int end = data->end;
+    long long *Output = data->Output;
+    long long *current_index = data->local_counts; // Deslocamentos desta thread
+    long long *buffers = data->wc_buffers;
+    unsigned char *first_slot = data->wc_first_slot;
+    long long start = data->start;
+    long long end = data->end;
     int np = data->np;
 
-    // Cada thread preenche seu intervalo no vetor `T`
-    for (int i = start; i < end; i++)
+    // Primeira posição válida da linha atual de cada faixa
+    for (int p = 0; p < np; p++)
+    {
+        first_slot[p] = LINE_SLOT(Output + current_index[p]);
+    }
+
+    switch (data->id_bytes)
+    {
+    case 1:
+        SCATTER_WC(unsigned char);
+        break;
+    case 2:
+        SCATTER_WC(unsigned short);
+        break;
+    default:
+        SCATTER_WC(int);
+        break;
+    }
+
+    // Descarrega as linhas incompletas
+    for (int p = 0; p < np; p++)
     {
-        T[i] = binary_search_partition(P, np, Input[i]);
+        long long pos = current_index[p];
+        int last_slot = LINE_SLOT(Output + pos);
+        long long *dst = Output + pos - last_slot;
+        long long *line = buffers + (size_t)p * 8;
+
+        for (int j = first_slot[p]; j < last_slot; j++)
+        {
+            dst[j] = line[j];
+        }
     }
 
+#if defined(__SSE2__)
+    _mm_sfence(); // Stores não temporais visíveis antes do retorno
+#endif
+    MP_PROFILE_MARK(data->prof, MP_PHASE_SCATTER);
     return NULL;
 }
 
-void fill_output(long long *Input, int n, long long *P, int np, long long *Output, int *Pos, int *T)
+// Escrita com payload e/ou permutação; `width` constante (8, 16, 32) deixa o
+// compilador trocar o memcpy por loads/stores diretos
+#define SCATTER_EXTRA(type, width)                                                        \
+    do                                                                                    \
+    {                                                                                     \
+        const type *ids = (const type *)data->T;                                          \
+        for (long long i = start; i < end; i++)                                                 \
+        {                                                                                 \
+            long long pos = current_index[ids[i]]++;                                            \
+            if (Output != NULL)                                                           \
+            {                                                                             \
+                Output[pos] = Input[i];                                                   \
+            }                                                                             \
+            if (payload != NULL)                                                          \
+            {                                                                             \
+                memcpy(out_payload + (size_t)pos * (width), payload + (size_t)i * (width), (width)); \
+            }                                                                             \
+            if (perm32 != NULL)                                                           \
+            {                                                                             \
+                perm32[pos] = (uint32_t)i;                                                \
+            }                                                                             \
+            else if (perm64 != NULL)                                                      \
+            {                                                                             \
+                perm64[pos] = (uint64_t)i;                                                \
+            }                                                                             \
+        }                                                                                 \
+    } while (0)
+
+#define SCATTER_EXTRA_WIDTH(type)           \
+    do                                      \
+    {                                       \
+        switch (width)                      \
+        {                                   \
+        case 8:                             \
+            SCATTER_EXTRA(type, 8);         \
+            break;                          \
+        case 16:                            \
+            SCATTER_EXTRA(type, 16);        \
+            break;                          \
+        case 32:                            \
+            SCATTER_EXTRA(type, 32);        \
+            break;                          \
+        default:                            \
+            SCATTER_EXTRA(type, width);     \
+            break;                          \
+        }                                   \
+    } while (0)
+
+// Só a permutação: cada posição de Output recebe o índice de origem
+#define SCATTER_PERM(type, ptype)                        \
+    do                                                   \
+    {                                                    \
+        const type *ids = (const type *)data->T;         \
+        ptype *perm = (ptype *)data->perm;               \
+        for (long long i = start; i < end; i++)                \
+        {                                                \
+            perm[current_index[ids[i]]++] = (ptype)i;    \
+        }                                                \
+    } while (0)
+
+#define SCATTER_PERM_WIDTH(type)                  \
+    do                                            \
+    {                                             \
+        if (data->perm_bytes == 4)                \
+        {                                         \
+            SCATTER_PERM(type, uint32_t);         \
+        }                                         \
+        else                                      \
+        {                                         \
+            SCATTER_PERM(type, uint64_t);         \
+        }                                         \
+    } while (0)
+
+void *thread_scatter_payload(void *arg)
 {
-    // Vetores temporários para cada faixa no Output
-    int *current_index = malloc(np * sizeof(int));
-    for (int i = 0; i < np; i++)
+    thread_data_t *data = (thread_data_t *)arg;
+
+    long long *Input = data->Input;
+    long long *Output = data->Output;
+    const char *payload = data->payload;
+    char *out_payload = data->out_payload;
+    size_t width = data->payload_bytes;
+    uint32_t *perm32 = data->perm_bytes == 4 ? (uint32_t *)data->perm : NULL;
+    uint64_t *perm64 = data->perm_bytes == 8 ? (uint64_t *)data->perm : NULL;
+    long long *current_index = data->local_counts; // Deslocamentos desta thread
+    long long start = data->start;
+    long long end = data->end;
+
+    if (Output == NULL && payload == NULL && data->perm != NULL)
     {
-        current_index[i] = Pos[i];
+        switch (data->id_bytes)
+        {
+        case 1:
+            SCATTER_PERM_WIDTH(unsigned char);
+            break;
+        case 2:
+            SCATTER_PERM_WIDTH(unsigned short);
+            break;
+        default:
+            SCATTER_PERM_WIDTH(int);
+            break;
+        }
     }
-
-    // Preenche o vetor Output particionado
-    for (int i = 0; i < n; i++)
+    else
     {
-        Output[current_index[T[i]]] = Input[i];
-        current_index[T[i]]++;
+        switch (data->id_bytes)
+        {
+        case 1:
+            SCATTER_EXTRA_WIDTH(unsigned char);
+            break;
+        case 2:
+            SCATTER_EXTRA_WIDTH(unsigned short);
+            break;
+        default:
+            SCATTER_EXTRA_WIDTH(int);
+            break;
+        }
     }
+    MP_PROFILE_MARK(data->prof, MP_PHASE_SCATTER);
 
-    free(current_index);
+    return NULL;
 }
 
-void multi_partition(long long *Input, int n, long long *P, int np, long long *Output, int *Pos, int nT)
+// Escreve o intervalo [start, end) da thread com o modo de escrita do plano
+static void scatter_range(thread_data_t *data)
 {
-    int nThreads = nT; // Número de threads
-    pthread_t threads[nThreads];
-    pthread_barrier_t barrier;
-    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    if (data->payload != NULL || data->perm != NULL || data->Output == NULL)
+    {
+        thread_scatter_payload(data);
+    }
+    else if (data->wc_buffers != NULL)
+    {
+        thread_scatter_output_wc(data);
+    }
+    else
+    {
+        thread_scatter_output(data);
+    }
+}
 
-    pthread_barrier_init(&barrier, NULL, nThreads);
+// Escreve os morsels livres, cada um com os deslocamentos do próprio morsel
+static void scatter_morsels(thread_data_t *data)
+{
+    morsel_shared_t *ms = data->morsels;
+    long long *own_counts = data->local_counts;
+    int m;
 
-    // Estruturas de contagem local/global
-    int **local_counts = malloc(nThreads * sizeof(int *));
-    for (int i = 0; i < nThreads; i++)
+    while ((m = __atomic_fetch_add(&ms->next_scatter, 1, __ATOMIC_RELAXED)) < ms->count)
     {
-        local_counts[i] = calloc(np + 1, sizeof(int)); // Inicializa contagens locais
+        morsel_range(ms, m, &data->start, &data->end);
+        data->local_counts = ms->counts[m];
+        scatter_range(data);
     }
+    data->local_counts = own_counts;
+}
 
-    // Divisão de trabalho entre threads
-    int chunk_size = (n + nThreads - 1) / nThreads;
-    thread_data_t *thread_data[nThreads];
+// Executa todas as fases para o intervalo (ou os morsels) de uma thread
+static void *thread_multi_partition(void *arg)
+{
+    thread_data_t *data = (thread_data_t *)arg;
 
-    for (int t = 0; t < nThreads; t++)
+    MP_PROFILE_START(data->prof);
+    thread_count_partition(arg);
+    thread_prefix_counts(arg);
+    if (data->morsels != NULL)
+    {
+        scatter_morsels(data);
+    }
+    else
+    {
+        scatter_range(data);
+    }
+    return NULL;
+}
+
+// Configuração usada pelos planos criados a partir de agora
+static mp_scatter_t mp_scatter = MP_SCATTER_DIRECT;
+static int mp_levels = 0; // 0 = automático
+static int mp_numa = 0;
+static mp_balance_t mp_balance = MP_BALANCE_STATIC;
+static int mp_batch_search = 1;
+static splitter_predict_t mp_predict = SPLITTER_PREDICT_NONE;
+
+void multi_partition_set_scatter(mp_scatter_t mode)
+{
+    mp_scatter = mode;
+}
+
+void multi_partition_set_balance(mp_balance_t mode)
+{
+    mp_balance = mode;
+}
+
+void multi_partition_set_numa(int enabled)
+{
+    mp_numa = enabled != 0;
+}
+
+void multi_partition_set_batch_search(int enabled)
+{
+    mp_batch_search = enabled != 0;
+}
+
+void multi_partition_set_predict(splitter_predict_t predict)
+{
+    mp_predict = predict;
+}
+
+void multi_partition_set_levels(int levels)
+{
+    mp_levels = levels;
+}
+
+int partition_id_bytes(int np)
+{
+    if (np <= 256)
+    {
+        return 1;
+    }
+    if (np <= 65536)
     {
-        // Criar thread_data_t utilizando a função `create_thread_data`
-        thread_data[t] = create_thread_data(
-            t * chunk_size,                                      // Início do intervalo
-            (t + 1) * chunk_size > n ? n : (t + 1) * chunk_size, // Fim do intervalo
-            Input,                                               // Ponteiro para Input
-            P,                                                   // Ponteiro para P
-            np,                                                  // Número de partições
-            local_counts[t],                                     // Vetor de contagem local
-            NULL,
-            &mutex,  // Mutex compartilhado
-            &barrier // Barreira compartilhada
-        );
+        return 2;
+    }
+    return sizeof(int);
+}
+
+// Maior número de entradas da TLB de dados para páginas de 4 KB (0 se desconhecido)
+static int detect_tlb_entries(void)
+{
+    int entries = 0;
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned int eax, ebx, ecx, edx;
 
-        if (thread_data[t] == NULL)
+    // Intel: folha 0x18 (parâmetros determinísticos de tradução de endereços)
+    if (__get_cpuid_count(0x18, 0, &eax, &ebx, &ecx, &edx))
+    {
+        unsigned int max_subleaf = eax;
+        for (unsigned int sub = 0; sub <= max_subleaf && sub < 16; sub++)
         {
-            fprintf(stderr, "Erro ao alocar memória para thread_data_t\n");
-            exit(EXIT_FAILURE);
+            __get_cpuid_count(0x18, sub, &eax, &ebx, &ecx, &edx);
+            unsigned int type = edx & 0x1f;      // 2 = dados, 3 = unificada
+            unsigned int has_4k = ebx & 1;
+            unsigned int ways = (ebx >> 16) & 0xffff;
+            if ((type == 2 || type == 3) && has_4k && (int)(ways * ecx) > entries)
+            {
+                entries = ways * ecx;
+            }
         }
-
-        pthread_create(&threads[t], NULL, thread_count_partition, thread_data[t]);
     }
 
-    // Esperar todas as threads terminarem
-    for (int t = 0; t < nThreads; t++)
+    // AMD: folha 0x80000006 (TLB de nível 2 para páginas de 4 KB)
+    if (entries == 0 && __get_cpuid(0x80000006, &eax, &ebx, &ecx, &edx))
     {
-        pthread_join(threads[t], NULL);
-        free(thread_data[t]); // Liberar memória da estrutura thread_data_t
+        entries = (ebx >> 16) & 0xfff;
     }
+#endif
+    return entries;
+}
 
-    // Junta os resultados de todas as threads
-    int *global_counts = calloc(np, sizeof(int));
-    merge_counts(global_counts, local_counts, nThreads, np);
+// Maior leque de saída em que cada faixa ativa ainda cabe na L1 e na TLB
+static int fanout_limit(void)
+{
+    static int limit = 0;
 
-    // Libera recursos
-    for (int i = 0; i < nThreads; i++)
+    if (limit == 0)
     {
-        free(local_counts[i]);
+        long l1 = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+        long line = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+        int l1_lines = l1 > 0 && line > 0 ? (int)(l1 / line) : 512;
+        int tlb = detect_tlb_entries();
+
+        limit = tlb > l1_lines ? tlb : l1_lines;
     }
-    free(local_counts);
 
-    // Global counts agora pode ser usado para calcular Pos (prefix sum)
+    return limit;
+}
+
+int multi_partition_levels(int np)
+{
+    int levels = mp_levels;
 
-    // Inicializa o vetor Pos com o prefix sum de global_counts
-    Pos[0] = 0;
-    for (int i = 1; i < np; i++)
+    if (levels <= 0)
     {
-        Pos[i] = Pos[i - 1] + global_counts[i - 1];
+        levels = np > fanout_limit() ? 2 : 1;
     }
 
-    int *T = create_pos_vector(n);
+    // Com poucas faixas não há o que dividir em dois níveis
+    return np < 4 ? 1 : (levels > 2 ? 2 : levels);
+}
 
-    for (int t = 0; t < nThreads; t++)
+// Modo de morsels: morsels por thread, tamanho mínimo (elementos) e memória
+// máxima das contagens por morsel
+#define MP_MORSELS_PER_THREAD 16
+#define MP_MORSEL_MIN 16384
+#define MP_MORSEL_COUNTS_BYTES (16 << 20)
+
+// Bytes por thread dos buffers de write-combining (np linhas + np bytes de estado)
+static size_t wc_thread_bytes(int np)
+{
+    // Múltiplo de 64 para evitar falso compartilhamento entre threads
+    return (size_t)np * 64 + (((size_t)np + 63) & ~(size_t)63);
+}
+
+// Contadores por thread ocupam linhas de cache próprias
+static size_t padded_counts(int np)
+{
+    return ((size_t)np + 15) & ~(size_t)15;
+}
+
+// Intervalo [start, end) de n processado pela thread t
+static void thread_chunk(long long n, int nThreads, int t, long long *start, long long *end)
+{
+    long long chunk_size = (n + nThreads - 1) / nThreads;
+    long long s = t * chunk_size, e = s + chunk_size;
+
+    *start = s > n ? n : s;
+    *end = e > n ? n : e;
+}
+
+// Trecho de um vetor tocado ou movido por um worker no modo NUMA
+typedef struct
+{
+    multi_partition_plan_t *plan;
+    int id;
+    char *base;        // Início do vetor.
+    size_t elem_bytes; // Bytes por elemento.
+    long long n;       // Elementos do vetor.
+    int bind;          // 1 = mover páginas com mbind, 0 = first-touch.
+} numa_chunk_t;
+
+static void *thread_numa_chunk(void *arg)
+{
+    numa_chunk_t *c = (numa_chunk_t *)arg;
+    multi_partition_plan_t *plan = c->plan;
+    long long start, end;
+    int node;
+
+    thread_chunk(c->n, plan->nThreads, c->id, &start, &end);
+    if (end <= start)
     {
-        // Criar thread_data_t utilizando a função `create_thread_data`
-        thread_data[t] = create_thread_data(
-            t * chunk_size,                                      // Início do intervalo
-            (t + 1) * chunk_size > n ? n : (t + 1) * chunk_size, // Fim do intervalo
-            Input,                                               // Ponteiro para Input
-            P,                                                   // Ponteiro para P
-            np,                                                  // Número de partições
-            NULL,                                                // Vetor de contagem local
-            T,
-            &mutex,  // Mutex compartilhado
-            &barrier // Barreira compartilhada
-        );
+        return NULL;
+    }
 
-        if (thread_data[t] == NULL)
+    char *lo = c->base + (size_t)start * c->elem_bytes;
+    size_t bytes = (size_t)(end - start) * c->elem_bytes;
+    if (c->bind)
+    {
+        topology_thread_cpu(plan->topo, c->id, plan->nThreads, &node);
+        if (topology_bind_memory(plan->topo, lo, bytes, node) != 0)
         {
-            fprintf(stderr, "Erro ao alocar memória para thread_data_t\n");
-            exit(EXIT_FAILURE);
+            c->bind = -1; // Falha reportada por multi_partition_place
         }
-
-        pthread_create(&threads[t], NULL, thread_fill_partition_indices, thread_data[t]);
     }
-
-    // Esperar todas as threads terminarem
-    for (int t = 0; t < nThreads; t++)
+    else
     {
-        pthread_join(threads[t], NULL);
-        free(thread_data[t]); // Liberar memória da estrutura thread_data_t
+        memset(lo, 0, bytes);
     }
+    return NULL;
+}
+
+// Executa thread_numa_chunk nos workers do plano sobre um vetor
+static int plan_numa_chunks(multi_partition_plan_t *plan, void *base, size_t elem_bytes, long long n, int bind)
+{
+    numa_chunk_t *chunks = malloc(plan->nThreads * sizeof(numa_chunk_t));
+    int ret = 0;
 
-    fill_output(Input, n, P, np, Output, Pos, T);
+    if (chunks == NULL)
+    {
+        return -1;
+    }
+    for (int t = 0; t < plan->nThreads; t++)
+    {
+        chunks[t] = (numa_chunk_t){plan, t, (char *)base, elem_bytes, n, bind};
+    }
+    thread_pool_run(plan->pool, thread_numa_chunk, chunks, sizeof(numa_chunk_t));
+    for (int t = 0; t < plan->nThreads; t++)
+    {
+        ret |= chunks[t].bind < 0 ? -1 : 0;
+    }
+    free(chunks);
+    return ret;
+}
 
-    destroy_pos_vector(T);
+// Fixa cada worker em sua CPU e toca primeiro os buffers por thread do plano
+static void *thread_numa_setup(void *arg)
+{
+    numa_chunk_t *c = (numa_chunk_t *)arg;
+    multi_partition_plan_t *plan = c->plan;
+    thread_data_t *data = &plan->thread_data[c->id];
+    int node;
 
-    free(global_counts);
+    topology_pin_current_thread(topology_thread_cpu(plan->topo, c->id, plan->nThreads, &node));
 
-    pthread_barrier_destroy(&barrier);
-    pthread_mutex_destroy(&mutex);
+    memset(data->local_counts, 0, padded_counts(data->np) * sizeof(long long));
+    memset(data->counts32, 0, padded_counts(data->np) * sizeof(unsigned int));
+    if (data->wc_buffers != NULL)
+    {
+        memset(data->wc_buffers, 0, wc_thread_bytes(data->np));
+    }
+    if (plan->levels == 2)
+    {
+        memset(plan->refine_data[c->id].counts, 0, padded_counts(plan->stride) * sizeof(long long));
+    }
+    return NULL;
 }
 
-void verifica_particoes(long long *Input, int n, long long *P, int np, long long *Output, int *Pos)
+// Classifica e conta os elementos de uma super-faixa com as partições locais
+#define REFINE_CLASSIFY(type)                                               \
+    do                                                                      \
+    {                                                                       \
+        type *ids = (type *)sh->T;                                          \
+        if (batch)                                                          \
+        {                                                                   \
+            for (long long i = blo; i < bhi; i += SPLITTER_BATCH)           \
+            {                                                               \
+                int m = bhi - i < SPLITTER_BATCH ? (int)(bhi - i) : SPLITTER_BATCH; \
+                type *out = ids + i;                                        \
+                CLASSIFY_BATCH(index, len, Tmp + i, m, counts32, STORE_ID); \
+            }                                                               \
+            break;                                                          \
+        }                                                                   \
+        for (long long i = blo; i < bhi; i++)                               \
+        {                                                                   \
+            int id = classify_partition(index, len, Tmp[i]);                \
+            ids[i] = (type)id;                                              \
+            counts32[id]++;                                                 \
+        }                                                                   \
+    } while (0)
+
+#define REFINE_SCATTER(type)                                                \
+    do                                                                      \
+    {                                                                       \
+        const type *ids = (const type *)sh->T;                              \
+        for (long long i = lo; i < hi; i++)                                 \
+        {                                                                   \
+            Output[counts[ids[i]]++] = Tmp[i];                              \
+        }                                                                   \
+    } while (0)
+
+// Segundo nível com payload/permutação: o índice de origem de cada elemento
+// veio do primeiro nível em tmp_idx
+#define REFINE_SCATTER_EXTRA(type)                                                          \
+    do                                                                                      \
+    {                                                                                       \
+        const type *ids = (const type *)sh->T;                                              \
+        size_t width = sh->payload_bytes;                                                   \
+        for (long long i = lo; i < hi; i++)                                                 \
+        {                                                                                   \
+            long long pos = counts[ids[i]]++;                                               \
+            unsigned long long src = sh->tmp_idx_bytes == 4 ? ((const uint32_t *)sh->tmp_idx)[i] \
+                                                            : ((const uint64_t *)sh->tmp_idx)[i]; \
+            if (Output != NULL)                                                             \
+            {                                                                               \
+                Output[pos] = Tmp[i];                                                       \
+            }                                                                               \
+            if (sh->payload != NULL)                                                        \
+            {                                                                               \
+                memcpy(sh->out_payload + (size_t)pos * width, sh->payload + (size_t)src * width, width); \
+            }                                                                               \
+            if (sh->perm_bytes == 4)                                                        \
+            {                                                                               \
+                ((uint32_t *)sh->perm)[pos] = (uint32_t)src;                                \
+            }                                                                               \
+            else if (sh->perm_bytes == 8)                                                   \
+            {                                                                               \
+                ((uint64_t *)sh->perm)[pos] = src;                                          \
+            }                                                                               \
+        }                                                                                   \
+    } while (0)
+
+// Segundo nível: cada thread pega super-faixas inteiras dinamicamente e as
+// particiona (de forma estável) nas faixas finais correspondentes
+static void *thread_refine_partition(void *arg)
 {
-    int erro = 0;
+    refine_data_t *data = (refine_data_t *)arg;
+    refine_shared_t *sh = data->shared;
+    long long *Tmp = sh->Tmp;
+    long long *Output = sh->Output;
+    long long *counts = data->counts;
+    unsigned int *counts32 = data->counts32;
 
-    // Verifica cada partição
-    for (int i = 0; i < np - 1; i++)
+    MP_PROFILE_START(data->prof);
+    for (;;)
     {
-        for (int j = Pos[i]; j < Pos[i + 1]; j++)
+        int b = __atomic_fetch_add(&sh->next, 1, __ATOMIC_RELAXED);
+        if (b >= sh->nsuper)
+        {
+            break;
+        }
+
+        long long lo = sh->super_pos[b];
+        long long hi = b + 1 < sh->nsuper ? sh->super_pos[b + 1] : sh->n;
+        int first = b * sh->stride;
+        int len = sh->np - first < sh->stride ? sh->np - first : sh->stride;
+        const splitter_index_t *index = sh->sub_index[b];
+        int batch = use_batch_search(sh->batch_search, index);
+
+        // Contadores de 32 bits em blocos de até 2^31 elementos, como em count_range
+        memset(counts, 0, len * sizeof(long long));
+        for (long long blo = lo; blo < hi; blo += COUNT32_BLOCK)
         {
-            if (Output[j] >= P[i])
+            long long bhi = hi - blo > COUNT32_BLOCK ? blo + COUNT32_BLOCK : hi;
+
+            memset(counts32, 0, len * sizeof(unsigned int));
+            if (sh->id_bytes == 1)
             {
-                erro = 1;
-                break;
+                REFINE_CLASSIFY(unsigned char);
+            }
+            else
+            {
+                REFINE_CLASSIFY(unsigned short);
+            }
+            for (int j = 0; j < len; j++)
+            {
+                counts[j] += counts32[j];
             }
         }
 
-        if (erro)
+        // Início de cada faixa final da super-faixa
+        long long offset = lo;
+        for (int j = 0; j < len; j++)
         {
-            break;
+            long long c = counts[j];
+            sh->Pos[first + j] = offset;
+            counts[j] = offset;
+            offset += c;
+        }
+
+        if (sh->tmp_idx != NULL)
+        {
+            if (sh->id_bytes == 1)
+            {
+                REFINE_SCATTER_EXTRA(unsigned char);
+            }
+            else
+            {
+                REFINE_SCATTER_EXTRA(unsigned short);
+            }
+        }
+        else if (sh->id_bytes == 1)
+        {
+            REFINE_SCATTER(unsigned char);
+        }
+        else
+        {
+            REFINE_SCATTER(unsigned short);
         }
     }
+    MP_PROFILE_MARK(data->prof, MP_PHASE_REFINE);
 
-    // Resultado da verificação
-    if (erro)
+    return NULL;
+}
+
+// Reconstrói os índices de busca do plano a partir de P (sem alocar)
+static int plan_set_splitters(multi_partition_plan_t *plan, long long *P)
+{
+    plan->P = P;
+
+    if (plan->levels == 1)
+    {
+        return splitter_index_build(plan->index, P, plan->np);
+    }
+
+    // A super-faixa k reúne as faixas finais [k * stride, (k + 1) * stride)
+    int stride = plan->stride, nsuper = plan->nsuper;
+    for (int k = 0; k < nsuper - 1; k++)
+    {
+        plan->super_P[k] = P[(k + 1) * stride - 1];
+    }
+    plan->super_P[nsuper - 1] = P[plan->np - 1];
+
+    if (splitter_index_build(plan->index, plan->super_P, nsuper) != 0)
+    {
+        return -1;
+    }
+
+    for (int k = 0; k < nsuper; k++)
+    {
+        int first = k * stride;
+        int len = plan->np - first < stride ? plan->np - first : stride;
+        if (splitter_index_build(plan->sub_index[k], P + first, len) != 0)
+        {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Cria um plano com os buffers na arena dada (ou em uma arena própria se NULL)
+static multi_partition_plan_t *plan_create(long long *P, int np, int nThreads, long long max_n, mp_arena_t *arena)
+{
+    if (P == NULL || np <= 0 || nThreads <= 0 || max_n < 0)
+    {
+        return NULL; // Parâmetros inválidos
+    }
+
+    multi_partition_plan_t *plan = (multi_partition_plan_t *)calloc(1, sizeof(multi_partition_plan_t));
+    if (plan == NULL)
     {
-        printf("\n===> particionamento COM ERROS\n");
+        return NULL;
+    }
+
+    plan->owns_arena = arena == NULL;
+    plan->arena = arena != NULL ? arena : mp_arena_create(0);
+    if (plan->arena == NULL)
+    {
+        free(plan);
+        return NULL;
+    }
+
+    plan->np = np;
+    plan->nThreads = nThreads;
+    plan->max_n = max_n;
+    plan->scatter = mp_scatter;
+    plan->levels = multi_partition_levels(np);
+    plan->numa = mp_numa;
+    plan->balance = mp_balance;
+    plan->batch_search = mp_batch_search;
+    plan->predict = mp_predict;
+    if (plan->numa && (plan->topo = topology_discover()) == NULL)
+    {
+        multi_partition_plan_destroy(plan);
+        return NULL;
+    }
+
+    // O primeiro nível usa P (um nível) ou as partições das super-faixas
+    int l1_np = np;
+    int id_bytes = partition_id_bytes(np);
+    if (plan->levels == 2)
+    {
+        plan->stride = 1;
+        while (plan->stride * plan->stride < np)
+        {
+            plan->stride++; // ceil(sqrt(np))
+        }
+        plan->nsuper = (np + plan->stride - 1) / plan->stride;
+        l1_np = plan->nsuper;
+
+        int l1_bytes = partition_id_bytes(l1_np);
+        int l2_bytes = plan->stride <= 256 ? 1 : 2;
+        id_bytes = l1_bytes > l2_bytes ? l1_bytes : l2_bytes;
+
+        plan->tmp = mp_arena_alloc(plan->arena, (size_t)max_n * sizeof(long long));
+        plan->super_P = malloc(l1_np * sizeof(long long));
+        plan->super_pos = mp_arena_alloc(plan->arena, l1_np * sizeof(long long));
+        plan->sub_index = calloc(l1_np, sizeof(splitter_index_t *));
+        plan->refine_counts = mp_arena_alloc(plan->arena, padded_counts(plan->stride) * nThreads * sizeof(long long));
+        plan->refine_data = malloc(nThreads * sizeof(refine_data_t));
+        if (plan->tmp == NULL || plan->super_P == NULL || plan->super_pos == NULL || plan->sub_index == NULL ||
+            plan->refine_counts == NULL || plan->refine_data == NULL)
+        {
+            multi_partition_plan_destroy(plan);
+            return NULL;
+        }
+        for (int k = 0; k < l1_np; k++)
+        {
+            plan->sub_index[k] = splitter_index_create(P, 1); // Reconstruído em plan_set_splitters
+            if (plan->sub_index[k] == NULL || splitter_index_set_predict(plan->sub_index[k], plan->predict) < 0)
+            {
+                multi_partition_plan_destroy(plan);
+                return NULL;
+            }
+        }
+    }
+
+    plan->index = splitter_index_create(P, 1);
+    plan->local_counts = mp_arena_alloc(plan->arena, padded_counts(l1_np) * nThreads * sizeof(long long));
+    plan->all_counts = malloc(nThreads * sizeof(long long *));
+    plan->global_counts = mp_arena_alloc(plan->arena, l1_np * sizeof(long long));
+    plan->slice_sums = mp_arena_alloc(plan->arena, nThreads * sizeof(long long));
+    // Contadores de 32 bits do laço de contagem (um nível ou cada nível do refinamento)
+    size_t counts32_len = padded_counts(plan->levels == 2 && plan->stride > l1_np ? plan->stride : l1_np);
+    plan->counts32 = mp_arena_alloc(plan->arena, counts32_len * nThreads * sizeof(unsigned int));
+    plan->T = mp_arena_alloc(plan->arena, (size_t)max_n * id_bytes);
+    plan->thread_data = malloc(nThreads * sizeof(thread_data_t));
+    plan->wc = plan->scatter == MP_SCATTER_WC ? mp_arena_alloc(plan->arena, wc_thread_bytes(l1_np) * nThreads) : NULL;
+    plan->pool = thread_pool_create(nThreads);
+    if (plan->balance == MP_BALANCE_MORSEL)
+    {
+        // Até MP_MORSELS_PER_THREAD morsels por thread, limitados pela memória das contagens
+        size_t row_bytes = padded_counts(l1_np) * sizeof(long long);
+        size_t fit = MP_MORSEL_COUNTS_BYTES / row_bytes;
+        plan->max_morsels = MP_MORSELS_PER_THREAD * nThreads;
+        if ((size_t)plan->max_morsels > fit)
+        {
+            plan->max_morsels = fit > (size_t)nThreads ? (int)fit : nThreads;
+        }
+        plan->morsel_counts = mp_arena_alloc(plan->arena, row_bytes * plan->max_morsels);
+        plan->morsels.counts = malloc(plan->max_morsels * sizeof(long long *));
+        if (plan->morsel_counts == NULL || plan->morsels.counts == NULL)
+        {
+            multi_partition_plan_destroy(plan);
+            return NULL;
+        }
+        for (int m = 0; m < plan->max_morsels; m++)
+        {
+            plan->morsels.counts[m] = plan->morsel_counts + padded_counts(l1_np) * m;
+        }
+    }
+#ifdef MP_PROFILE
+    plan->profile = mp_profile_create(nThreads);
+    if (plan->profile == NULL)
+    {
+        multi_partition_plan_destroy(plan);
+        return NULL;
+    }
+#endif
+
+    if (plan->index == NULL || splitter_index_set_predict(plan->index, plan->predict) < 0 ||
+        plan->local_counts == NULL || plan->counts32 == NULL || plan->all_counts == NULL ||
+        plan->global_counts == NULL ||
+        plan->slice_sums == NULL || plan->T == NULL || plan->thread_data == NULL || plan->pool == NULL ||
+        (plan->scatter == MP_SCATTER_WC && plan->wc == NULL) ||
+        pthread_barrier_init(&plan->barrier, NULL, nThreads) != 0)
+    {
+        multi_partition_plan_destroy(plan);
+        return NULL;
+    }
+    plan->barrier_ready = 1;
+    pthread_mutex_init(&plan->mutex, NULL);
+
+    if (plan_set_splitters(plan, P) != 0)
+    {
+        multi_partition_plan_destroy(plan);
+        return NULL;
+    }
+
+    // Dados fixos de cada thread; o intervalo e os vetores de cada chamada
+    // são preenchidos em `multi_partition_execute`
+    for (int t = 0; t < nThreads; t++)
+    {
+        thread_data_t *data = &plan->thread_data[t];
+
+        plan->all_counts[t] = plan->local_counts + padded_counts(l1_np) * t;
+
+        data->id = t;
+        data->nThreads = nThreads;
+        data->index = plan->index;
+        data->batch_search = plan->batch_search;
+        data->np = l1_np;
+        data->local_counts = plan->all_counts[t];
+        data->counts32 = plan->counts32 + counts32_len * t;
+        data->all_counts = plan->all_counts;
+        data->global_counts = plan->global_counts;
+        data->slice_sums = plan->slice_sums;
+        data->T = plan->T;
+        data->id_bytes = partition_id_bytes(l1_np);
+        data->wc_buffers = NULL;
+        data->wc_first_slot = NULL;
+        data->morsels = NULL;
+        if (plan->wc != NULL)
+        {
+            char *block = plan->wc + wc_thread_bytes(l1_np) * t;
+            data->wc_buffers = (long long *)block;
+            data->wc_first_slot = (unsigned char *)(block + (size_t)l1_np * 64);
+        }
+        data->mutex = &plan->mutex;     // Mutex compartilhado
+        data->barrier = &plan->barrier; // Barreira compartilhada
+        data->prof = plan->profile != NULL ? &plan->profile->threads[t] : NULL;
+
+        if (plan->levels == 2)
+        {
+            plan->refine_data[t].shared = &plan->refine;
+            plan->refine_data[t].counts = plan->refine_counts + padded_counts(plan->stride) * t;
+            plan->refine_data[t].counts32 = data->counts32;
+            plan->refine_data[t].prof = data->prof;
+        }
+    }
+
+    // Modo NUMA: workers fixados e buffers grandes tocados primeiro por quem os usa
+    if (plan->numa)
+    {
+        numa_chunk_t *setup = malloc(nThreads * sizeof(numa_chunk_t));
+        if (setup == NULL)
+        {
+            multi_partition_plan_destroy(plan);
+            return NULL;
+        }
+        for (int t = 0; t < nThreads; t++)
+        {
+            setup[t] = (numa_chunk_t){plan, t, NULL, 0, 0, 0};
+        }
+        thread_pool_run(plan->pool, thread_numa_setup, setup, sizeof(numa_chunk_t));
+        free(setup);
+
+        if (plan_numa_chunks(plan, plan->T, id_bytes, max_n, 0) != 0 ||
+            (plan->tmp != NULL && plan_numa_chunks(plan, plan->tmp, sizeof(long long), max_n, 0) != 0))
+        {
+            multi_partition_plan_destroy(plan);
+            return NULL;
+        }
+    }
+
+    // Páginas novas da arena tocadas agora, fora das execuções
+    mp_arena_prefault(plan->arena, plan->pool);
+
+    return plan;
+}
+
+multi_partition_plan_t *multi_partition_plan_create(long long *P, int np, int nThreads, long long max_n)
+{
+    return plan_create(P, np, nThreads, max_n, NULL);
+}
+
+// Execução comum a `multi_partition_execute` e `multi_partition_execute_payload`
+static int plan_execute(multi_partition_plan_t *plan, long long *Input, long long n, long long *Output, long long *Pos,
+                        const mp_payload_t *extra)
+{
+    if (n < 0 || n > plan->max_n)
+    {
+        return -1; // O plano não comporta n elementos
+    }
+
+    int nThreads = plan->nThreads;
+    int two_level = plan->levels == 2;
+    long long *l1_Output = two_level ? plan->tmp : Output;
+    long long *l1_Pos = two_level ? plan->super_pos : Pos;
+    mp_payload_t l1_extra = {NULL, NULL, 0, NULL, 0};
+
+    if (extra != NULL)
+    {
+        if (extra->perm != NULL && extra->perm_bytes != 4 && extra->perm_bytes != 8)
+        {
+            return -1;
+        }
+        if (extra->perm != NULL && extra->perm_bytes == 4 && n > UINT32_MAX)
+        {
+            return -1; // Índices de 32 bits não alcançam todo Input
+        }
+
+        // Dois níveis: o primeiro nível só carrega o índice de origem, com
+        // 32 bits sempre que max_n couber
+        l1_extra = *extra;
+        if (two_level)
+        {
+            if (plan->tmp_idx == NULL)
+            {
+                plan->tmp_idx_bytes = plan->max_n <= UINT32_MAX ? 4 : 8;
+                plan->tmp_idx = mp_arena_alloc(plan->arena, (size_t)plan->max_n * plan->tmp_idx_bytes);
+                if (plan->tmp_idx == NULL)
+                {
+                    return -1;
+                }
+            }
+            l1_extra = (mp_payload_t){NULL, NULL, 0, plan->tmp_idx, plan->tmp_idx_bytes};
+        }
+    }
+
+    // Morsels: o bastante para equilibrar a carga, sem ficarem pequenos demais
+    morsel_shared_t *morsels = NULL;
+    if (plan->balance == MP_BALANCE_MORSEL)
+    {
+        long long count = (n + MP_MORSEL_MIN - 1) / MP_MORSEL_MIN;
+        count = count < 1 ? 1 : (count > plan->max_morsels ? plan->max_morsels : count);
+
+        morsels = &plan->morsels;
+        morsels->n = n;
+        morsels->size = (n + count - 1) / count;
+        morsels->count = morsels->size > 0 ? (int)((n + morsels->size - 1) / morsels->size) : 0;
+        morsels->next_count = 0;
+        morsels->next_scatter = 0;
+    }
+
+    // Divisão de trabalho entre threads
+    for (int t = 0; t < nThreads; t++)
+    {
+        thread_data_t *data = &plan->thread_data[t];
+
+        thread_chunk(n, nThreads, t, &data->start, &data->end);
+        data->Input = Input;
+        data->P = two_level ? plan->super_P : plan->P;
+        data->Output = l1_Output;
+        data->Pos = l1_Pos;
+        data->payload = (const char *)l1_extra.payload;
+        data->out_payload = (char *)l1_extra.out_payload;
+        data->payload_bytes = l1_extra.payload_bytes;
+        data->perm = l1_extra.perm;
+        data->perm_bytes = l1_extra.perm_bytes;
+        data->morsels = morsels;
+    }
+
+    // Contagem, prefix sum e escrita em Output em uma única rodada do pool
+    thread_pool_run(plan->pool, thread_multi_partition, plan->thread_data, sizeof(thread_data_t));
+#ifdef MP_PROFILE
+    plan->profile->calls++;
+#endif
+
+    if (two_level)
+    {
+        // O vetor T do primeiro nível já foi consumido e é reaproveitado aqui
+        refine_shared_t *sh = &plan->refine;
+        sh->Tmp = plan->tmp;
+        sh->n = n;
+        sh->P = plan->P;
+        sh->np = plan->np;
+        sh->stride = plan->stride;
+        sh->nsuper = plan->nsuper;
+        sh->super_pos = plan->super_pos;
+        sh->sub_index = plan->sub_index;
+        sh->batch_search = plan->batch_search;
+        sh->T = plan->T;
+        sh->id_bytes = plan->stride <= 256 ? 1 : 2;
+        sh->Output = Output;
+        sh->Pos = Pos;
+        sh->next = 0;
+        sh->tmp_idx = extra != NULL ? plan->tmp_idx : NULL;
+        sh->tmp_idx_bytes = plan->tmp_idx_bytes;
+        sh->payload = extra != NULL ? (const char *)extra->payload : NULL;
+        sh->out_payload = extra != NULL ? (char *)extra->out_payload : NULL;
+        sh->payload_bytes = extra != NULL ? extra->payload_bytes : 0;
+        sh->perm = extra != NULL ? extra->perm : NULL;
+        sh->perm_bytes = extra != NULL && extra->perm != NULL ? extra->perm_bytes : 0;
+
+        thread_pool_run(plan->pool, thread_refine_partition, plan->refine_data, sizeof(refine_data_t));
+    }
+
+    return 0;
+}
+
+int multi_partition_execute(multi_partition_plan_t *plan, long long *Input, long long n, long long *Output,
+                            long long *Pos)
+{
+    return plan_execute(plan, Input, n, Output, Pos, NULL);
+}
+
+int multi_partition_execute_payload(multi_partition_plan_t *plan, long long *Input, long long n, long long *Output,
+                                    long long *Pos, const mp_payload_t *extra)
+{
+    mp_payload_t none = {NULL, NULL, 0, NULL, 0};
+    return plan_execute(plan, Input, n, Output, Pos, extra != NULL ? extra : &none);
+}
+
+// Distância do prefetch do gather, em elementos
+#define GATHER_PREFETCH 16
+
+// Intervalo de dst copiado por um worker em `multi_partition_gather`
+typedef struct
+{
+    const char *src;
+    size_t width;
+    const void *perm;
+    int perm_bytes;
+    char *dst;
+    long long start, end;
+} gather_task_t;
+
+#define GATHER(ptype, width)                                                              \
+    do                                                                                    \
+    {                                                                                     \
+        const ptype *perm = (const ptype *)g->perm;                                       \
+        for (long long k = g->start; k < g->end; k++)                                     \
+        {                                                                                 \
+            if (k + GATHER_PREFETCH < g->end)                                             \
+            {                                                                             \
+                __builtin_prefetch(g->src + (size_t)perm[k + GATHER_PREFETCH] * (width)); \
+            }                                                                             \
+            memcpy(g->dst + (size_t)k * (width), g->src + (size_t)perm[k] * (width), (width)); \
+        }                                                                                 \
+    } while (0)
+
+#define GATHER_WIDTH(ptype)          \
+    do                               \
+    {                                \
+        switch (g->width)            \
+        {                            \
+        case 8:                      \
+            GATHER(ptype, 8);        \
+            break;                   \
+        case 16:                     \
+            GATHER(ptype, 16);       \
+            break;                   \
+        case 32:                     \
+            GATHER(ptype, 32);       \
+            break;                   \
+        default:                     \
+            GATHER(ptype, g->width); \
+            break;                   \
+        }                            \
+    } while (0)
+
+static void *thread_gather(void *arg)
+{
+    gather_task_t *g = (gather_task_t *)arg;
+
+    if (g->perm_bytes == 4)
+    {
+        GATHER_WIDTH(uint32_t);
+    }
+    else
+    {
+        GATHER_WIDTH(uint64_t);
+    }
+    return NULL;
+}
+
+int multi_partition_gather(multi_partition_plan_t *plan, const void *src, size_t width, const void *perm, int perm_bytes,
+                           long long n, void *dst)
+{
+    int nThreads = plan->nThreads;
+
+    if ((perm_bytes != 4 && perm_bytes != 8) || n < 0)
+    {
+        return -1;
+    }
+
+    gather_task_t *tasks = malloc(nThreads * sizeof(gather_task_t));
+    if (tasks == NULL)
+    {
+        return -1;
+    }
+
+    for (int t = 0; t < nThreads; t++)
+    {
+        tasks[t] = (gather_task_t){(const char *)src, width, perm, perm_bytes, (char *)dst, 0, 0};
+        thread_chunk(n, nThreads, t, &tasks[t].start, &tasks[t].end);
+    }
+    thread_pool_run(plan->pool, thread_gather, tasks, sizeof(gather_task_t));
+    free(tasks);
+    return 0;
+}
+
+// Abaixo disso, o fim do particionamento in-place é feito por uma thread
+#define INPLACE_SERIAL_TAIL 4096
+
+// Trecho [ph, pt) da thread t na parte não resolvida [head, tail) de cada faixa
+static void inplace_stripes(const inplace_shared_t *sh, int np, int t, int nThreads, long long *ph, long long *pt)
+{
+    for (int j = 0; j < np; j++)
+    {
+        long long len = sh->tail[j] - sh->head[j];
+        ph[j] = sh->head[j] + len * t / nThreads;
+        pt[j] = sh->head[j] + len * (t + 1) / nThreads;
+    }
+}
+
+// Permutação especulativa: leva cada elemento dos trechos da thread para o
+// trecho da thread na sua faixa, enquanto houver espaço. Ao final,
+// [início, ph[j]) de cada trecho está no lugar e [ph[j], pt[j]) só tem
+// elementos de outras faixas.
+static void inplace_permute(const splitter_index_t *index, int np, long long *Data, long long *ph, const long long *pt)
+{
+    for (int i = 0; i < np; i++)
+    {
+        for (long long head = ph[i]; head < pt[i]; head++)
+        {
+            long long v = Data[head];
+            int k = classify_partition(index, np, v);
+
+            // Ciclo: troca v com a próxima posição livre da sua faixa
+            while (k != i && ph[k] < pt[k])
+            {
+                long long w = Data[ph[k]];
+                Data[ph[k]++] = v;
+                v = w;
+                k = classify_partition(index, np, v);
+            }
+
+            if (k == i)
+            {
+                Data[head] = Data[ph[i]]; // Elemento de outra faixa (ou o próprio v se head == ph[i])
+                Data[ph[i]++] = v;
+            }
+            else
+            {
+                Data[head] = v; // Sem espaço no destino nesta rodada
+            }
+        }
+    }
+}
+
+// Reparo da faixa i: os elementos fora do lugar vão para o fim da faixa e a
+// parte não resolvida passa a ser só esse fim
+static void inplace_repair(const multi_partition_plan_t *plan, inplace_shared_t *sh, int i)
+{
+    int nThreads = plan->nThreads;
+    long long len = sh->tail[i] - sh->head[i];
+    long long *Data = sh->Data;
+    long long wrong = 0;
+
+    for (int t = 0; t < nThreads; t++)
+    {
+        wrong += plan->inplace_data[t].pt[i] - plan->inplace_data[t].ph[i];
+    }
+
+    // Troca os elementos errados antes de `cut` pelos certos depois de `cut`
+    long long cut = sh->tail[i] - wrong;
+    int ft = 0, bt = nThreads - 1;
+    long long fp = plan->inplace_data[0].ph[i], bp = plan->inplace_data[bt].ph[i] - 1;
+    for (;;)
+    {
+        while (ft < nThreads && fp >= plan->inplace_data[ft].pt[i])
+        {
+            ft++;
+            fp = ft < nThreads ? plan->inplace_data[ft].ph[i] : fp;
+        }
+        if (ft == nThreads || fp >= cut)
+        {
+            break;
+        }
+
+        // Início do trecho bt: os certos estão em [início, ph)
+        while (bp < sh->head[i] + len * bt / nThreads)
+        {
+            bt--;
+            bp = plan->inplace_data[bt].ph[i] - 1;
+        }
+
+        long long v = Data[fp];
+        Data[fp++] = Data[bp];
+        Data[bp--] = v;
+    }
+
+    sh->head[i] = cut;
+}
+
+// Particiona [lo, hi) in-place nas len faixas de `index` (uma thread,
+// American flag sort); head e tail são vetores de trabalho com len posições
+static void inplace_serial(const splitter_index_t *index, int len, long long *Data, long long lo, long long hi,
+                           long long *Pos, long long *head, long long *tail)
+{
+    memset(head, 0, len * sizeof(long long));
+    for (long long i = lo; i < hi; i++)
+    {
+        head[classify_partition(index, len, Data[i])]++;
+    }
+
+    long long base = lo;
+    for (int j = 0; j < len; j++)
+    {
+        long long c = head[j];
+        Pos[j] = head[j] = base;
+        base += c;
+        tail[j] = base;
+    }
+    inplace_permute(index, len, Data, head, tail);
+}
+
+static void *thread_inplace_partition(void *arg)
+{
+    inplace_data_t *data = (inplace_data_t *)arg;
+    inplace_shared_t *sh = data->shared;
+    multi_partition_plan_t *plan = sh->plan;
+    long long *Data = sh->Data;
+    int nThreads = plan->nThreads, id = data->id;
+    int two_level = plan->levels == 2;
+    int np = two_level ? plan->nsuper : plan->np; // Faixas do primeiro nível
+    long long *Pos = two_level ? plan->super_pos : sh->Pos;
+    const splitter_index_t *index = plan->index;
+    long long start, end;
+
+    MP_PROFILE_START(data->prof);
+
+    // Contagem local (ph serve de contador nesta fase)
+    thread_chunk(sh->n, nThreads, id, &start, &end);
+    memset(data->ph, 0, np * sizeof(long long));
+    if (use_batch_search(plan->batch_search, index))
+    {
+        for (long long i = start; i < end; i += SPLITTER_BATCH)
+        {
+            int m = end - i < SPLITTER_BATCH ? (int)(end - i) : SPLITTER_BATCH;
+            CLASSIFY_BATCH(index, np, Data + i, m, data->ph, COUNT_ONLY);
+        }
+    }
+    else
+    {
+        for (long long i = start; i < end; i++)
+        {
+            data->ph[classify_partition(index, np, Data[i])]++;
+        }
+    }
+    MP_PROFILE_MARK(data->prof, MP_PHASE_CLASSIFY);
+
+    pthread_barrier_wait(&plan->barrier);
+    MP_PROFILE_MARK(data->prof, MP_PHASE_BARRIER);
+
+    if (id == 0)
+    {
+        long long base = 0;
+        for (int j = 0; j < np; j++)
+        {
+            Pos[j] = sh->head[j] = base;
+            for (int t = 0; t < nThreads; t++)
+            {
+                base += plan->inplace_data[t].ph[j];
+            }
+            sh->tail[j] = base;
+        }
+        sh->serial = nThreads == 1 || sh->n <= INPLACE_SERIAL_TAIL;
+    }
+    MP_PROFILE_MARK(data->prof, MP_PHASE_PREFIX);
+
+    pthread_barrier_wait(&plan->barrier);
+    MP_PROFILE_MARK(data->prof, MP_PHASE_BARRIER);
+
+    for (;;)
+    {
+        // Última rodada: uma única thread sempre termina a permutação
+        if (sh->serial)
+        {
+            if (id == 0)
+            {
+                inplace_stripes(sh, np, 0, 1, data->ph, data->pt);
+                inplace_permute(index, np, Data, data->ph, data->pt);
+            }
+            MP_PROFILE_MARK(data->prof, MP_PHASE_SCATTER);
+            break;
+        }
+
+        inplace_stripes(sh, np, id, nThreads, data->ph, data->pt);
+        inplace_permute(index, np, Data, data->ph, data->pt);
+        MP_PROFILE_MARK(data->prof, MP_PHASE_SCATTER);
+
+        pthread_barrier_wait(&plan->barrier);
+        MP_PROFILE_MARK(data->prof, MP_PHASE_BARRIER);
+
+        for (;;)
+        {
+            int i = __atomic_fetch_add(&sh->next, 1, __ATOMIC_RELAXED);
+            if (i >= np)
+            {
+                break;
+            }
+            inplace_repair(plan, sh, i);
+        }
+        MP_PROFILE_MARK(data->prof, MP_PHASE_SCATTER);
+
+        pthread_barrier_wait(&plan->barrier);
+        MP_PROFILE_MARK(data->prof, MP_PHASE_BARRIER);
+
+        if (id == 0)
+        {
+            long long remaining = 0;
+            for (int j = 0; j < np; j++)
+            {
+                remaining += sh->tail[j] - sh->head[j];
+            }
+            sh->serial = remaining <= INPLACE_SERIAL_TAIL || remaining == sh->remaining;
+            sh->remaining = remaining;
+            sh->next = 0;
+        }
+
+        pthread_barrier_wait(&plan->barrier);
+        MP_PROFILE_MARK(data->prof, MP_PHASE_BARRIER);
+        if (sh->remaining == 0)
+        {
+            break;
+        }
+    }
+
+    if (!two_level)
+    {
+        return NULL;
+    }
+
+    // Segundo nível: cada thread pega super-faixas inteiras e as particiona
+    // sozinha (leque de saída ~sqrt(np))
+    if (id == 0)
+    {
+        sh->next = 0;
+    }
+    pthread_barrier_wait(&plan->barrier);
+    MP_PROFILE_MARK(data->prof, MP_PHASE_BARRIER);
+
+    for (;;)
+    {
+        int b = __atomic_fetch_add(&sh->next, 1, __ATOMIC_RELAXED);
+        if (b >= plan->nsuper)
+        {
+            break;
+        }
+
+        long long lo = plan->super_pos[b];
+        long long hi = b + 1 < plan->nsuper ? plan->super_pos[b + 1] : sh->n;
+        int first = b * plan->stride;
+        int len = plan->np - first < plan->stride ? plan->np - first : plan->stride;
+        inplace_serial(plan->sub_index[b], len, Data, lo, hi, sh->Pos + first, data->ph, data->pt);
+    }
+    MP_PROFILE_MARK(data->prof, MP_PHASE_REFINE);
+
+    return NULL;
+}
+
+int multi_partition_execute_inplace(multi_partition_plan_t *plan, long long *Data, long long n, long long *Pos)
+{
+    int nThreads = plan->nThreads, np = plan->np;
+    inplace_shared_t *sh = &plan->inplace;
+
+    if (n < 0 || n > plan->max_n)
+    {
+        return -1; // O plano não comporta n elementos
+    }
+
+    // Vetores por thread e limites das faixas, reservados no primeiro uso
+    if (plan->inplace_data == NULL)
+    {
+        size_t row = padded_counts(np);
+        long long *rows = mp_arena_alloc(plan->arena, 2 * row * nThreads * sizeof(long long));
+        long long *bounds = mp_arena_alloc(plan->arena, 2 * (size_t)np * sizeof(long long));
+        inplace_data_t *data = malloc(nThreads * sizeof(inplace_data_t));
+
+        if (rows == NULL || bounds == NULL || data == NULL)
+        {
+            free(data);
+            return -1;
+        }
+        for (int t = 0; t < nThreads; t++)
+        {
+            data[t].shared = sh;
+            data[t].id = t;
+            data[t].ph = rows + 2 * row * t;
+            data[t].pt = rows + 2 * row * t + row;
+            data[t].prof = plan->profile != NULL ? &plan->profile->threads[t] : NULL;
+        }
+        sh->head = bounds;
+        sh->tail = bounds + np;
+        plan->inplace_data = data;
+    }
+
+    sh->plan = plan;
+    sh->Data = Data;
+    sh->n = n;
+    sh->Pos = Pos;
+    sh->remaining = n;
+    sh->serial = 0;
+    sh->next = 0;
+
+    thread_pool_run(plan->pool, thread_inplace_partition, plan->inplace_data, sizeof(inplace_data_t));
+#ifdef MP_PROFILE
+    plan->profile->calls++;
+#endif
+    return 0;
+}
+
+void multi_partition_plan_destroy(multi_partition_plan_t *plan)
+{
+    if (plan == NULL)
+    {
+        return;
+    }
+
+    thread_pool_destroy(plan->pool);
+    if (plan->barrier_ready)
+    {
+        pthread_barrier_destroy(&plan->barrier);
+        pthread_mutex_destroy(&plan->mutex);
+    }
+
+    mp_profile_destroy(plan->profile);
+    topology_destroy(plan->topo);
+    splitter_index_destroy(plan->index);
+    if (plan->sub_index != NULL)
+    {
+        for (int k = 0; k < plan->nsuper; k++)
+        {
+            splitter_index_destroy(plan->sub_index[k]);
+        }
+    }
+    free(plan->sub_index);
+    free(plan->all_counts);
+    free(plan->morsels.counts);
+    free(plan->thread_data);
+    free(plan->super_P);
+    free(plan->refine_data);
+    free(plan->inplace_data);
+    if (plan->owns_arena)
+    {
+        mp_arena_destroy(plan->arena);
+    }
+    free(plan);
+}
+
+long long *multi_partition_alloc(multi_partition_plan_t *plan, long long n)
+{
+    if (!plan->numa)
+    {
+        return calloc(n > 0 ? n : 1, sizeof(long long));
+    }
+
+    // Alinhado à página para que cada trecho comece em páginas ainda não tocadas
+    size_t bytes = ((size_t)(n > 0 ? n : 1) * sizeof(long long) + 4095) & ~(size_t)4095;
+    long long *ptr = aligned_alloc(4096, bytes);
+    if (ptr != NULL && plan_numa_chunks(plan, ptr, sizeof(long long), n, 0) != 0)
+    {
+        free(ptr);
+        return NULL;
+    }
+    return ptr;
+}
+
+void multi_partition_free(long long *ptr)
+{
+    free(ptr);
+}
+
+int multi_partition_place(multi_partition_plan_t *plan, long long *ptr, long long n)
+{
+    if (!plan->numa)
+    {
+        return -1;
+    }
+    return plan_numa_chunks(plan, ptr, sizeof(long long), n, 1);
+}
+
+// Plano reaproveitado por `multi_partition` entre chamadas e arena que
+// sobrevive às recriações do plano
+static multi_partition_plan_t *mp_plan = NULL;
+static mp_arena_t *mp_plan_arena = NULL;
+
+// Plano interno para (P, np, nThreads) que comporta n elementos
+static multi_partition_plan_t *wrapper_plan(long long *P, int np, long long n, int nThreads)
+{
+    multi_partition_plan_t *plan = mp_plan;
+
+    // Recria o plano só quando a forma do problema ou a configuração mudam
+    if (plan == NULL || plan->np != np || plan->nThreads != nThreads || plan->max_n < n ||
+        plan->scatter != mp_scatter || plan->numa != mp_numa || plan->balance != mp_balance || plan->batch_search != mp_batch_search ||
+        plan->predict != mp_predict ||
+        plan->levels != multi_partition_levels(np))
+    {
+        long long max_n = plan != NULL && plan->max_n > n ? plan->max_n : n;
+
+        multi_partition_plan_destroy(plan);
+        plan = mp_plan = NULL;
+
+        // As páginas do plano anterior são reaproveitadas pelo novo
+        if (mp_plan_arena == NULL)
+        {
+            mp_plan_arena = mp_arena_create(0);
+        }
+        if (mp_plan_arena != NULL)
+        {
+            mp_arena_reset(mp_plan_arena);
+            plan = mp_plan = plan_create(P, np, nThreads, max_n, mp_plan_arena);
+        }
+    }
+    else if (plan_set_splitters(plan, P) != 0)
+    {
+        plan = NULL;
+    }
+
+    return plan;
+}
+
+void multi_partition(long long *Input, long long n, long long *P, int np, long long *Output, long long *Pos,
+                     int nThreads)
+{
+    multi_partition_plan_t *plan = wrapper_plan(P, np, n, nThreads);
+
+    if (plan == NULL || multi_partition_execute(plan, Input, n, Output, Pos) != 0)
+    {
+        fprintf(stderr, "Erro ao alocar memória para multi_partition\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void multi_partition_inplace(long long *Data, long long n, long long *P, int np, long long *Pos, int nThreads)
+{
+    multi_partition_plan_t *plan = wrapper_plan(P, np, n, nThreads);
+
+    if (plan == NULL || multi_partition_execute_inplace(plan, Data, n, Pos) != 0)
+    {
+        fprintf(stderr, "Erro ao alocar memória para multi_partition\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+void multi_partition_profile_report(const multi_partition_plan_t *plan, FILE *out)
+{
+    plan = plan != NULL ? plan : mp_plan;
+
+    if (plan == NULL || plan->profile == NULL)
+    {
+        mp_profile_report(NULL, out); // Mensagem de perfil desabilitado
+        return;
+    }
+    mp_profile_report(plan->profile, out);
+}
+
+void multi_partition_profile_reset(multi_partition_plan_t *plan)
+{
+    plan = plan != NULL ? plan : mp_plan;
+
+    if (plan != NULL && plan->profile != NULL)
+    {
+        mp_profile_reset(plan->profile);
+    }
+}
+
+void multi_partition_shutdown(void)
+{
+    multi_partition_plan_destroy(mp_plan);
+    mp_arena_destroy(mp_plan_arena);
+    mp_plan = NULL;
+    mp_plan_arena = NULL;
+}
+
+int multi_partition_restart_workers(void)
+{
+    multi_partition_plan_t *plan = mp_plan;
+
+    if (plan == NULL)
+    {
+        return 0;
+    }
+
+    thread_pool_destroy(plan->pool);
+    plan->pool = thread_pool_create(plan->nThreads);
+    if (plan->pool == NULL)
+    {
+        multi_partition_shutdown(); // A próxima chamada cria um plano novo
+        return -1;
+    }
+
+    // Modo NUMA: os workers novos também ficam fixados em suas CPUs
+    if (plan->numa)
+    {
+        numa_chunk_t *setup = malloc(plan->nThreads * sizeof(numa_chunk_t));
+        if (setup == NULL)
+        {
+            multi_partition_shutdown();
+            return -1;
+        }
+        for (int t = 0; t < plan->nThreads; t++)
+        {
+            setup[t] = (numa_chunk_t){plan, t, NULL, 0, 0, 0};
+        }
+        thread_pool_run(plan->pool, thread_numa_setup, setup, sizeof(numa_chunk_t));
+        free(setup);
+    }
+    return 0;
+}
+
+void verifica_particoes(long long *Input, long long n, long long *P, int np, long long *Output, long long *Pos)
+{
+    mp_verify_result_t res;
+
+    // Verificação paralela completa (limites das faixas, Pos e permutação)
+    int ret = multi_partition_verify(Input, n, P, np, Output, Pos, 0, &res);
+
+    // Resultado da verificação
+    if (ret < 0)
+    {
+        printf("\n===> particionamento NÃO VERIFICADO (falta de memória)\n");
+    }
+    else if (ret != 0)
+    {
+        printf("\n===> particionamento COM ERROS: %s", multi_partition_verify_status(res.status));
+        if (res.index >= 0)
+        {
+            printf(" (índice %lld, faixa %d)", res.index, res.range);
+        }
+        printf("\n");
     }
     else
     {
@@ -5,22 +5,382 @@
 #include <limits.h> // Para LLONG_MAX
 #include <stdlib.h>
 
+#include <stdio.h>
+
+#include "mp_arena.h"
+#include "mp_profile.h"
+#include "splitter_index.h"
+#include "thread_pool.h"
+#include "topology.h"
+
+/**
+ * @brief Modo de escrita dos elementos em Output.
+ */
+typedef enum
+{
+    MP_SCATTER_DIRECT = 0, // Escrita direta de cada elemento em sua posição.
+    MP_SCATTER_WC          // Buffers de write-combining por faixa + stores não temporais.
+} mp_scatter_t;
+
+/**
+ * @brief Divisão do trabalho de contagem e escrita entre as threads.
+ */
+typedef enum
+{
+    MP_BALANCE_STATIC = 0, // Um intervalo fixo de n / nThreads elementos por thread.
+    MP_BALANCE_MORSEL      // Blocos pequenos (morsels) pegos dinamicamente de um contador atômico.
+} mp_balance_t;
+
+/**
+ * @brief Morsels de uma execução no modo MP_BALANCE_MORSEL.
+ *
+ * As contagens são guardadas por morsel, e não por thread: o prefix sum
+ * percorre os morsels na ordem de Input, de modo que Output e Pos não
+ * dependem de qual thread processou cada morsel.
+ */
+typedef struct
+{
+    long long n;      // Elementos da execução atual.
+    long long size;   // Elementos por morsel (o último pode ser menor).
+    int count;        // Morsels da execução atual.
+    long long **counts; // Contagem de cada morsel; após o prefix sum, seus deslocamentos em Output.
+    int next_count;   // Próximo morsel livre na contagem (atômico).
+    int next_scatter; // Próximo morsel livre na escrita (atômico).
+} morsel_shared_t;
+
 /**
  * @brief Estrutura para armazenar os dados de entrada das threads.
  */
 typedef struct
 {
-    int start;                  // Índice inicial da parte do vetor Input processada pela thread.
-    int end;                    // Índice final da parte do vetor Input processada pela thread.
+    int id;                     // Índice da thread (0 a nThreads - 1).
+    int nThreads;               // Número total de threads.
+    long long start;            // Índice inicial da parte do vetor Input processada pela thread.
+    long long end;              // Índice final da parte do vetor Input processada pela thread.
     long long *Input;           // Ponteiro para o vetor de entrada.
     long long *P;               // Ponteiro para o vetor de partições.
+    splitter_index_t *index;    // Índice de busca construído a partir de P.
+    int batch_search;           // Classifica em lotes intercalados quando o índice é grande.
     int np;                     // Número de partições no vetor P.
-    int *local_counts;          // Ponteiro para o vetor de contagem local da thread.
-    int *T;                     // Ponteiro para o vetor temporario que tem tanho de Input.
+    long long *local_counts;    // Contagem local da thread; após o prefix sum, deslocamentos da thread em Output.
+    long long **all_counts;     // Contagens locais de todas as threads (nThreads x np).
+    long long *global_counts;   // Contagem global de cada faixa (tamanho np).
+    long long *slice_sums;      // Soma das contagens da fatia de faixas de cada thread (tamanho nThreads).
+    unsigned int *counts32;     // Contadores de 32 bits do laço de classificação (tamanho np).
+    void *T;                    // Vetor temporario com o índice da faixa de cada elemento de Input.
+    int id_bytes;               // Largura em bytes de cada índice em T (1, 2 ou sizeof(int)).
+    long long *Output;          // Ponteiro para o vetor de saída (NULL = só payload/permutação).
+    const char *payload;        // Payload de cada elemento de Input (ou NULL).
+    char *out_payload;          // Payload de cada elemento de Output.
+    size_t payload_bytes;       // Largura do payload em bytes.
+    void *perm;                 // Permutação de saída: índice em Input de cada posição de Output (ou NULL).
+    int perm_bytes;             // Largura de cada índice da permutação (4 ou 8).
+    long long *wc_buffers;      // Buffers de write-combining da thread (np x 8), ou NULL no modo direto.
+    unsigned char *wc_first_slot; // Primeira posição válida do buffer de cada faixa (tamanho np).
+    long long *Pos;             // Ponteiro para o vetor de início das faixas.
+    morsel_shared_t *morsels;   // Morsels compartilhados (NULL = intervalo fixo [start, end)).
     pthread_mutex_t *mutex;     // Mutex compartilhado (não utilizado nesta versão).
     pthread_barrier_t *barrier; // Barreira para sincronização entre threads.
+    mp_thread_profile_t *prof;  // Medidas da thread (NULL sem MP_PROFILE).
 } thread_data_t;
 
+/**
+ * @brief Dados compartilhados do segundo nível do particionamento hierárquico.
+ */
+typedef struct
+{
+    long long *Tmp;               // Saída do primeiro nível.
+    long long n;                  // Número de elementos.
+    long long *P;                 // Partições finais.
+    int np;                       // Número de partições finais.
+    int stride;                   // Faixas finais por super-faixa.
+    int nsuper;                   // Número de super-faixas.
+    long long *super_pos;         // Início de cada super-faixa em Tmp.
+    splitter_index_t **sub_index; // Índice das partições de cada super-faixa.
+    int batch_search;             // Classifica em lotes intercalados quando o índice é grande.
+    void *T;                      // Índices locais de faixa (alinhados com Tmp).
+    int id_bytes;                 // Largura dos índices locais (1 ou 2).
+    long long *Output;            // Vetor de saída (NULL = só payload/permutação).
+    long long *Pos;               // Início de cada faixa final.
+    int next;                     // Próxima super-faixa livre (atômico).
+    const void *tmp_idx;          // Índice em Input de cada elemento de Tmp (NULL = só chaves).
+    int tmp_idx_bytes;            // Largura dos índices de tmp_idx (4 ou 8).
+    const char *payload;          // Payload de Input (ou NULL).
+    char *out_payload;            // Payload de Output.
+    size_t payload_bytes;         // Largura do payload.
+    void *perm;                   // Permutação de saída (ou NULL).
+    int perm_bytes;               // Largura dos índices da permutação (4 ou 8).
+} refine_shared_t;
+
+/**
+ * @brief Dados de cada thread no segundo nível do particionamento hierárquico.
+ */
+typedef struct
+{
+    refine_shared_t *shared; // Dados compartilhados.
+    long long *counts;         // Contagens locais da thread (tamanho stride).
+    unsigned int *counts32;    // Contadores de 32 bits do laço de classificação (tamanho stride).
+    mp_thread_profile_t *prof; // Medidas da thread (NULL sem MP_PROFILE).
+} refine_data_t;
+
+/**
+ * @brief Dados compartilhados do particionamento in-place.
+ */
+typedef struct
+{
+    struct multi_partition_plan *plan; // Plano em execução.
+    long long *Data;  // Vetor particionado in-place.
+    long long n;         // Número de elementos.
+    long long *Pos;      // Início de cada faixa.
+    long long *head;     // Início da parte ainda não resolvida de cada faixa.
+    long long *tail;     // Fim de cada faixa.
+    long long remaining; // Elementos fora do lugar no fim da rodada.
+    int serial;       // Próxima rodada feita só pela thread 0.
+    int next;         // Próxima faixa livre no reparo (atômico).
+} inplace_shared_t;
+
+/**
+ * @brief Dados de cada thread no particionamento in-place.
+ */
+typedef struct
+{
+    inplace_shared_t *shared;  // Dados compartilhados.
+    int id;                    // Índice da thread.
+    long long *ph;             // Próxima posição livre da thread em cada faixa (tamanho np).
+    long long *pt;             // Fim do trecho da thread em cada faixa (tamanho np).
+    mp_thread_profile_t *prof; // Medidas da thread (NULL sem MP_PROFILE).
+} inplace_data_t;
+
+/**
+ * @brief Plano de particionamento: tudo o que depende apenas de P, np e nThreads.
+ *
+ * Criado uma vez com `multi_partition_plan_create` e executado quantas vezes
+ * for preciso com `multi_partition_execute`. O plano é dono do índice de
+ * busca, dos buffers temporários e dos workers.
+ */
+typedef struct multi_partition_plan
+{
+    long long *P;                 // Vetor de partições (não copiado).
+    int np;                       // Número de partições.
+    int nThreads;                 // Número de workers.
+    long long max_n;              // Maior n aceito por `multi_partition_execute`.
+    mp_scatter_t scatter;         // Modo de escrita capturado na criação.
+    int levels;                   // 1 ou 2 níveis (capturado na criação).
+    int numa;                     // Workers fixados e buffers locais a cada nó (capturado na criação).
+    mp_balance_t balance;         // Divisão do trabalho (capturada na criação).
+    int batch_search;             // Busca em lote nas árvores grandes (capturada na criação).
+    splitter_predict_t predict;   // Previsão da faixa nos índices (capturada na criação).
+    topology_t *topo;             // Topologia da máquina (NULL sem NUMA).
+    thread_pool_t *pool;          // Workers do plano.
+    pthread_barrier_t barrier;    // Barreira entre as fases.
+    pthread_mutex_t mutex;        // Mutex compartilhado.
+    int barrier_ready;            // Indica se barrier/mutex foram inicializados.
+    splitter_index_t *index;      // Índice do primeiro nível (P ou super_P).
+    thread_data_t *thread_data;   // Dados de cada thread.
+    long long *local_counts;      // Contagens locais, uma linha de cache própria por thread.
+    long long **all_counts;       // Ponteiros para as contagens de cada thread.
+    long long *global_counts;     // Contagem global de cada faixa.
+    long long *slice_sums;        // Somas das fatias de faixas de cada thread.
+    unsigned int *counts32;       // Contadores de 32 bits de cada thread (contagem e segundo nível).
+    void *T;                      // Índices de faixa (max_n elementos).
+    char *wc;                     // Buffers de write-combining (ou NULL).
+    int stride;                   // [2 níveis] Faixas finais por super-faixa.
+    int nsuper;                   // [2 níveis] Número de super-faixas.
+    long long *tmp;               // [2 níveis] Saída do primeiro nível (max_n elementos).
+    long long *super_P;           // [2 níveis] Partições das super-faixas.
+    long long *super_pos;         // [2 níveis] Início de cada super-faixa em tmp.
+    splitter_index_t **sub_index; // [2 níveis] Índice das partições de cada super-faixa.
+    long long *refine_counts;     // [2 níveis] Contagens do segundo nível por thread.
+    refine_data_t *refine_data;   // [2 níveis] Dados de cada thread no segundo nível.
+    refine_shared_t refine;       // [2 níveis] Dados compartilhados do segundo nível.
+    inplace_data_t *inplace_data; // [in-place] Dados de cada thread (reservados no primeiro uso).
+    inplace_shared_t inplace;     // [in-place] Dados compartilhados.
+    mp_profile_t *profile;        // Medidas por fase e por thread (NULL sem MP_PROFILE).
+    void *tmp_idx;                // [2 níveis] Índice em Input de cada elemento de tmp (reservado no primeiro uso com payload).
+    int tmp_idx_bytes;            // [2 níveis] Largura dos índices de tmp_idx (4 até 2^32 elementos, senão 8).
+    mp_arena_t *arena;            // Arena dos buffers (contagens, T, wc, tmp).
+    int owns_arena;               // O plano libera a arena ao ser destruído.
+    int max_morsels;              // [morsels] Maior número de morsels de uma execução.
+    long long *morsel_counts;     // [morsels] Contagens por morsel, uma linha de cache própria por morsel.
+    morsel_shared_t morsels;      // [morsels] Estado da execução atual.
+} multi_partition_plan_t;
+
+/**
+ * @brief Cria um plano de particionamento para o vetor de partições P.
+ *
+ * @param P Vetor de partições (ordenado); deve continuar válido enquanto o plano existir.
+ * @param np Número de partições no vetor P.
+ * @param nThreads Número de workers.
+ * @param max_n Maior número de elementos de uma execução.
+ * @return multi_partition_plan_t* Plano criado ou NULL em caso de falha.
+ *
+ * Aloca todos os buffers, constrói o índice de busca e cria os workers. O
+ * modo de escrita e o número de níveis são os configurados no momento da
+ * criação. O plano deve ser liberado com `multi_partition_plan_destroy`.
+ *
+ * Os buffers (T, contagens por thread, buffers de write-combining e saída do
+ * primeiro nível) vêm de uma arena própria do plano: blocos alinhados a 64
+ * bytes em regiões de páginas de 2 MB, tocadas em paralelo pelos workers na
+ * criação, para que nenhuma falha de página aconteça nas execuções.
+ */
+multi_partition_plan_t *multi_partition_plan_create(long long *P, int np, int nThreads, long long max_n);
+
+/**
+ * @brief Particiona Input usando um plano, sem nenhuma alocação.
+ *
+ * @param plan Plano criado por `multi_partition_plan_create`.
+ * @param Input Vetor de entrada com n elementos.
+ * @param n Número de elementos (no máximo `plan->max_n`).
+ * @param Output Vetor de saída, particionado em np faixas.
+ * @param Pos Vetor (tamanho np) com o início de cada faixa em Output.
+ * @return int 0 em caso de sucesso ou -1 se n excede `plan->max_n`.
+ */
+int multi_partition_execute(multi_partition_plan_t *plan, long long *Input, long long n, long long *Output,
+                            long long *Pos);
+
+/**
+ * @brief Particiona Data in-place (sem Output nem T), usando um plano.
+ *
+ * @param plan Plano criado por `multi_partition_plan_create`.
+ * @param Data Vetor com n elementos, reorganizado nas np faixas.
+ * @param n Número de elementos (no máximo `plan->max_n`).
+ * @param Pos Vetor (tamanho np) com o início de cada faixa.
+ * @return int 0 em caso de sucesso ou -1 se n excede `plan->max_n` ou falta
+ *             memória para os vetores por thread.
+ *
+ * Permutação paralela especulativa com reparo (no estilo do PARADIS): após a
+ * contagem, cada faixa ainda não resolvida é dividida em um trecho por
+ * thread; cada thread leva os elementos dos seus trechos para os seus
+ * trechos de destino enquanto houver espaço (ciclos do American flag sort).
+ * O reparo junta, no fim de cada faixa, os elementos que ficaram fora do
+ * lugar, e a próxima rodada trabalha só com eles. Quando restam poucos
+ * elementos ou uma rodada não progride, a thread 0 termina sozinha.
+ *
+ * Memória extra: 2 x nThreads x np índices (reservados na primeira chamada)
+ * em vez de Output e T. Ao contrário de `multi_partition_execute`, a ordem
+ * dos elementos dentro de cada faixa não é preservada. Pos é o mesmo.
+ */
+int multi_partition_execute_inplace(multi_partition_plan_t *plan, long long *Data, long long n, long long *Pos);
+
+/**
+ * @brief Particiona Data in-place nas np faixas definidas por P.
+ *
+ * Versão de `multi_partition_execute_inplace` com o plano interno de
+ * `multi_partition` (mesmas regras de reaproveitamento).
+ */
+void multi_partition_inplace(long long *Data, long long n, long long *P, int np, long long *Pos, int nThreads);
+
+/**
+ * @brief Colunas movidas junto com as chaves por `multi_partition_execute_payload`.
+ */
+typedef struct
+{
+    const void *payload;  // Payload de cada elemento de Input (n x payload_bytes) ou NULL.
+    void *out_payload;    // Destino do payload, na ordem de Output.
+    size_t payload_bytes; // Largura do payload em bytes (ex.: 8, 16, 32).
+    void *perm;           // Permutação de saída (uint32_t ou uint64_t, n elementos) ou NULL.
+    int perm_bytes;       // 4 (uint32_t) ou 8 (uint64_t).
+} mp_payload_t;
+
+/**
+ * @brief Particiona Input movendo também um payload e/ou gerando a permutação.
+ *
+ * @param plan Plano criado por `multi_partition_plan_create`.
+ * @param Input Vetor de chaves com n elementos.
+ * @param n Número de elementos (no máximo `plan->max_n`).
+ * @param Output Vetor de saída das chaves ou NULL para não mover as chaves
+ *               (ex.: só a permutação).
+ * @param Pos Vetor (tamanho np) com o início de cada faixa.
+ * @param extra Payload e/ou permutação.
+ * @return int 0 em caso de sucesso ou -1 se n excede `plan->max_n`,
+ *             `perm_bytes` não é 4 nem 8 (ou é 4 com n > UINT32_MAX) ou
+ *             falta memória para os índices intermediários.
+ *
+ * Usa a mesma contagem e os mesmos deslocamentos de `multi_partition_execute`:
+ * a chave Input[i] e o payload i vão para a mesma posição k, e `perm[k] = i`.
+ * A escrita é sempre direta (sem write-combining). Em planos de dois níveis, o
+ * primeiro nível carrega o índice de cada elemento (vetor de max_n índices de
+ * 32 bits, ou 64 se max_n > UINT32_MAX, reservado na primeira chamada) e o
+ * payload é copiado só no segundo.
+ */
+int multi_partition_execute_payload(multi_partition_plan_t *plan, long long *Input, long long n, long long *Output,
+                                    long long *Pos, const mp_payload_t *extra);
+
+/**
+ * @brief Gather paralelo: dst[k] = src[perm[k]] para colunas de `width` bytes.
+ *
+ * @param plan Plano cujos workers fazem a cópia.
+ * @param src Coluna de origem (na ordem de Input).
+ * @param width Largura de cada elemento em bytes.
+ * @param perm Permutação (gerada por `multi_partition_execute_payload`).
+ * @param perm_bytes 4 (uint32_t) ou 8 (uint64_t).
+ * @param n Número de elementos.
+ * @param dst Coluna de destino (na ordem de Output).
+ * @return int 0 em caso de sucesso ou -1 se perm_bytes é inválido ou falta memória.
+ *
+ * Cada worker copia um intervalo contíguo de dst e antecipa (prefetch) as
+ * leituras aleatórias de src alguns elementos à frente.
+ */
+int multi_partition_gather(multi_partition_plan_t *plan, const void *src, size_t width, const void *perm, int perm_bytes,
+                           long long n, void *dst);
+
+/**
+ * @brief Aloca um vetor de n elementos distribuído entre os nós dos workers.
+ *
+ * @param plan Plano que vai processar o vetor.
+ * @param n Número de elementos.
+ * @return long long* Vetor zerado (liberar com `multi_partition_free`) ou NULL.
+ *
+ * Cada worker toca primeiro o trecho de n que processa em
+ * `multi_partition_execute`, de modo que as páginas desse trecho ficam no nó
+ * do worker (first-touch). Sem o modo NUMA, equivale a um calloc.
+ */
+long long *multi_partition_alloc(multi_partition_plan_t *plan, long long n);
+
+/**
+ * @brief Libera um vetor alocado com `multi_partition_alloc`.
+ */
+void multi_partition_free(long long *ptr);
+
+/**
+ * @brief Move as páginas de um vetor já existente para os nós dos workers.
+ *
+ * @param plan Plano que vai processar o vetor.
+ * @param ptr Vetor de n elementos (ex.: Input ou Output).
+ * @param n Número de elementos.
+ * @return int 0 em caso de sucesso ou -1 se o plano não está no modo NUMA ou
+ *             se o sistema não permite mover as páginas (mbind).
+ *
+ * Cada trecho de n vai para o nó do worker que o processa; páginas
+ * compartilhadas por dois trechos ficam com o primeiro.
+ */
+int multi_partition_place(multi_partition_plan_t *plan, long long *ptr, long long n);
+
+/**
+ * @brief Imprime o perfil por fase e por thread acumulado por um plano.
+ *
+ * @param plan Plano (NULL = plano interno usado por `multi_partition`).
+ * @param out Destino do relatório.
+ *
+ * Só há medidas quando o projeto é compilado com `make PROFILE=1`; caso
+ * contrário, imprime apenas um aviso.
+ */
+void multi_partition_profile_report(const multi_partition_plan_t *plan, FILE *out);
+
+/**
+ * @brief Zera o perfil acumulado por um plano.
+ *
+ * @param plan Plano (NULL = plano interno usado por `multi_partition`).
+ */
+void multi_partition_profile_reset(multi_partition_plan_t *plan);
+
+/**
+ * @brief Encerra os workers e libera o plano.
+ *
+ * @param plan Plano a ser liberado (pode ser NULL).
+ */
+void multi_partition_plan_destroy(multi_partition_plan_t *plan);
+
 /**
  * @brief Função principal para particionar um vetor de entrada em múltiplas faixas.
  *
@@ -32,75 +392,210 @@ typedef struct
  * @param Pos Ponteiro para o vetor que indica os índices iniciais de cada faixa no Output.
  * @param nThreads Número de threads
  *
+ * Equivale a executar um plano criado para (P, np, nThreads); o plano é
+ * guardado e reaproveitado nas chamadas seguintes enquanto np, nThreads e a
+ * configuração não mudam e n não cresce.
+ * Quando o plano é recriado, a memória do anterior é reaproveitada (não é
+ * devolvida à libc).
+ *
  * A função gerencia o fluxo geral do algoritmo, incluindo:
- * - Divisão do trabalho entre threads.
+ * - Divisão do trabalho entre os workers de um pool reaproveitado entre chamadas.
  * - Sincronização e paralelização da contagem de elementos.
- * - Combinação das contagens locais em um vetor global.
+ * - Prefix sum paralelo das contagens locais, gerando Pos e os deslocamentos de cada thread.
+ * - Escrita paralela e estável de cada intervalo diretamente em Output.
+ *
+ * Valores maiores ou iguais a P[np-1] são colocados na última faixa.
+ *
+ * n, Pos e os deslocamentos são de 64 bits, então vetores com mais de 2^31
+ * elementos são aceitos. No laço de classificação cada thread conta com
+ * contadores de 32 bits (metade da cache ocupada pelas contagens), somados às
+ * contagens de 64 bits a cada 2^31 elementos.
+ */
+void multi_partition(long long *Input, long long n, long long *P, int np, long long *Output, long long *Pos,
+                     int nThreads);
+
+/**
+ * @brief Libera o plano (workers e buffers) reaproveitado por `multi_partition`.
+ *
+ * Os workers são criados na primeira chamada de `multi_partition` e ficam
+ * estacionados entre as chamadas seguintes; esta função os encerra e libera
+ * os buffers. Uma chamada posterior de `multi_partition` cria um novo plano.
  */
-void multi_partition(long long *Input, int n, long long *P, int np, long long *Output, int *Pos, int nThreads);
+void multi_partition_shutdown(void);
 
 /**
- * @brief Função executada por cada thread para contar os elementos em suas faixas.
+ * @brief Recria apenas os workers do plano reaproveitado por `multi_partition`.
+ *
+ * @return int 0 em caso de sucesso ou -1 se os workers não puderam ser
+ *             criados (o plano é então liberado, como em `multi_partition_shutdown`).
+ *
+ * Buffers, índice de busca e arena do plano são mantidos; só as threads são
+ * encerradas (join) e criadas de novo. Serve para medir o custo de criação e
+ * join das threads isolado do custo de montar o plano.
+ */
+int multi_partition_restart_workers(void);
+
+/**
+ * @brief Seleciona o modo de escrita em Output usado pelos próximos planos.
+ *
+ * @param mode `MP_SCATTER_DIRECT` (padrão) ou `MP_SCATTER_WC`.
+ *
+ * No modo `MP_SCATTER_WC`, cada thread acumula os elementos de cada faixa
+ * em um buffer do tamanho de uma linha de cache e grava linhas completas em
+ * Output com stores não temporais, evitando o read-for-ownership e a troca
+ * constante de páginas/linhas quando np é grande. Usa np x 64 bytes de
+ * buffer por thread.
+ */
+void multi_partition_set_scatter(mp_scatter_t mode);
+
+/**
+ * @brief Seleciona a divisão do trabalho usada pelos próximos planos.
+ *
+ * @param mode `MP_BALANCE_STATIC` (padrão) ou `MP_BALANCE_MORSEL`.
+ *
+ * No modo `MP_BALANCE_MORSEL`, Input é dividido em até 16 morsels por thread
+ * (de no mínimo 16K elementos) e as threads pegam o próximo morsel livre na
+ * contagem e, de novo, na escrita. Uma thread atrasada (SMT, vizinhos
+ * barulhentos, memória remota) processa menos morsels em vez de segurar as
+ * outras na barreira. Output e Pos são idênticos aos do modo estático.
+ */
+void multi_partition_set_balance(mp_balance_t mode);
+
+/**
+ * @brief Ativa ou desativa o modo NUMA nos próximos planos.
+ *
+ * @param enabled 1 para ativar, 0 para desativar (padrão).
+ *
+ * No modo NUMA, cada worker é fixado em uma CPU (as threads são distribuídas
+ * em blocos contíguos pelos nós, na ordem dos intervalos de Input) e toca
+ * primeiro a sua parte dos buffers do plano (T, contagens, buffers de
+ * write-combining e saída do primeiro nível), que assim ficam no seu nó.
+ * Input e Output podem ser distribuídos com `multi_partition_alloc` ou
+ * `multi_partition_place`. Em máquinas com um único nó, só fixa os workers.
+ */
+void multi_partition_set_numa(int enabled);
+
+/**
+ * @brief Liga ou desliga a busca em lote nos próximos planos.
+ *
+ * @param enabled 1 (padrão) para classificar em lotes, 0 para uma chave por vez.
+ *
+ * Quando a árvore de busca de P passa de 32 KB (np acima de ~4K), a
+ * classificação avança SPLITTER_BATCH chaves juntas pela árvore, com
+ * prefetch do próximo nó de cada uma (`splitter_index_search_batch`), em vez
+ * de esperar a falta de cache de uma chave para começar a seguinte. Árvores
+ * menores continuam com a busca de uma chave por vez. O resultado é o mesmo.
+ */
+void multi_partition_set_batch_search(int enabled);
+
+/**
+ * @brief Escolhe a previsão da faixa usada pelos índices dos próximos planos.
+ *
+ * @param predict `SPLITTER_PREDICT_NONE` (padrão: só a árvore), `_LUT`, `_RMI` ou `_AUTO`.
+ *
+ * Com P próximo de uniforme ou suave, uma tabela pelos bits altos da chave
+ * ou um modelo linear por trechos prevê a faixa, corrigida por uma busca
+ * binária curta em uma cópia de P (ver `splitter_index_set_predict`). O
+ * resultado é exato; se o erro do modelo para o P do plano passar de
+ * SPLITTER_PREDICT_MAX_WINDOW, o índice continua usando a árvore.
+ */
+void multi_partition_set_predict(splitter_predict_t predict);
+
+/**
+ * @brief Define quantos níveis de particionamento os próximos planos usam.
+ *
+ * @param levels 1 (passada única), 2 (hierárquico) ou 0 para escolha automática (padrão).
+ *
+ * No modo hierárquico, Input é primeiro dividido em ~sqrt(np) super-faixas,
+ * usando um subconjunto de P, e cada super-faixa é depois particionada em
+ * paralelo nas suas faixas finais. Cada passada tem leque de saída ~sqrt(np),
+ * que cabe na cache e na TLB. O resultado (Output e Pos) é idêntico ao da
+ * passada única.
+ */
+void multi_partition_set_levels(int levels);
+
+/**
+ * @brief Número de níveis que `multi_partition` usará para np partições.
+ *
+ * @param np Número de partições.
+ * @return int 1 ou 2. No modo automático, usa 2 níveis quando np excede o
+ *             número de linhas da cache L1 de dados e de entradas da TLB
+ *             detectados na máquina.
+ */
+int multi_partition_levels(int np);
+
+/**
+ * @brief Função executada por cada thread para classificar e contar os elementos em suas faixas.
  *
  * @param arg Estrutura de dados do tipo `thread_data_t` contendo:
  *            - Índices de início e fim para processamento.
- *            - Ponteiros para os vetores Input, P, e contagens locais.
+ *            - Ponteiros para os vetores Input, P, T e contagens locais.
  *            - Número de partições e barreiras/mutexes compartilhados.
  *
- * A função realiza:
- * - Contagem local de elementos em cada faixa para a parte do vetor atribuída à thread.
- * - Armazena os resultados no vetor de contagem local associado à thread.
+ * A função realiza, em uma única busca por elemento:
+ * - Grava em T o índice da faixa de cada elemento do intervalo da thread.
+ * - Contagem local de elementos em cada faixa, no vetor de contagem local da thread.
  */
 void *thread_count_partition(void *arg);
 
 /**
- * @brief Combina os vetores de contagem locais das threads em um vetor global.
+ * @brief Largura em bytes do menor tipo capaz de guardar um índice de faixa.
  *
- * @param global_counts Ponteiro para o vetor global de contagens (tamanho np + 1).
- * @param local_counts Vetor bidimensional contendo os resultados das threads (nThreads x (np + 1)).
- * @param nThreads Número total de threads utilizadas.
- * @param np Número de partições no vetor P.
+ * @param np Número de partições.
+ * @return int 1 para np <= 256, 2 para np <= 65536 e sizeof(int) caso contrário.
+ */
+int partition_id_bytes(int np);
+
+/**
+ * @brief Calcula, em paralelo, os deslocamentos de cada thread e o vetor Pos.
  *
- * A função realiza:
- * - Soma os valores correspondentes de cada vetor de contagem local.
- * - Armazena o resultado no vetor global.
+ * @param arg Estrutura `thread_data_t` da thread.
+ *
+ * Cada thread cuida de uma fatia das np faixas e faz um prefix sum exclusivo
+ * por coluna sobre `all_counts`. Ao final, `all_counts[t][j]` é a posição em
+ * Output do primeiro elemento da faixa j vindo do intervalo da thread t, e
+ * `Pos[j]` é o início da faixa j. Sincroniza as threads com a barreira.
+ * No modo de morsels, as linhas são as contagens de cada morsel.
  */
-void merge_counts(int *global_counts, int **local_counts, int nThreads, int np);
+void *thread_prefix_counts(void *arg);
 
 /**
- * @brief Cria e inicializa uma estrutura thread_data_t com os dados fornecidos.
+ * @brief Copia os elementos do intervalo da thread para suas posições em Output.
  *
- * @param start Índice inicial da parte do vetor Input processada pela thread.
- * @param end Índice final da parte do vetor Input processada pela thread.
- * @param Input Ponteiro para o vetor de entrada.
- * @param P Ponteiro para o vetor de partições.
- * @param np Número de partições no vetor P.
- * @param local_counts Ponteiro para o vetor de contagem local da thread.
- * @param T Ponteiro para o vetor temporario de tamanho do Input.
- * @param mutex Ponteiro para o mutex compartilhado (pode ser NULL se não utilizado).
- * @param barrier Ponteiro para a barreira compartilhada entre threads.
- * @return thread_data_t* Ponteiro para a estrutura thread_data_t alocada e inicializada.
+ * @param arg Estrutura `thread_data_t` da thread.
  *
- * A estrutura retornada deve ser liberada manualmente pelo usuário com `free` após o uso.
+ * Usa os índices gravados em T por `thread_count_partition` (sem nova busca)
+ * e os deslocamentos calculados por `thread_prefix_counts`. Como cada
+ * thread percorre seu intervalo em ordem e os intervalos estão em ordem de
+ * thread, o particionamento é estável.
  */
-thread_data_t *create_thread_data(int start, int end, long long *Input, long long *P, int np, int *local_counts, int *T, pthread_mutex_t *mutex, pthread_barrier_t *barrier);
+void *thread_scatter_output(void *arg);
 
 /**
- * @brief Preenche os vetores Output e Pos com base nos resultados de global_counts.
+ * @brief Versão de `thread_scatter_output` com buffers de write-combining.
  *
- * @param Input Vetor de entrada contendo os números a serem particionados.
- * @param n Número de elementos no vetor Input.
- * @param P Vetor de partições (ordenado).
- * @param np Número de partições.
- * @param Output Vetor de saída particionado.
- * @param Pos Vetor que indica os índices iniciais de cada faixa no Output.
- * @param T Vetor temporario tamanho n.
+ * @param arg Estrutura `thread_data_t` da thread (com `wc_buffers` alocado).
+ *
+ * Produz exatamente o mesmo Output que `thread_scatter_output`.
+ */
+void *thread_scatter_output_wc(void *arg);
+
+/**
+ * @brief Versão de `thread_scatter_output` que também move o payload e/ou grava a permutação.
+ *
+ * @param arg Estrutura `thread_data_t` da thread (com `payload` e/ou `perm`).
+ *
+ * Com `Output` NULL, só o payload e a permutação são escritos.
  */
-void fill_output(long long *Input, int n, long long *P, int np, long long *Output, int *Pos, int *T);
+void *thread_scatter_payload(void *arg);
 
 /**
  * @brief Verifica se o particionamento foi realizado corretamente.
  *
+ * Imprime o resultado de `multi_partition_verify` (limites de todas as
+ * faixas, Pos e permutação de Input), com o primeiro índice errado, usando
+ * todas as CPUs disponíveis.
+ *
  * @param Input Vetor de entrada.
  * @param n Tamanho do vetor de entrada.
  * @param P Vetor de partições (ordenado).
@@ -108,7 +603,7 @@ void fill_output(long long *Input, int n, long long *P, int np, long long *Outpu
  * @param Output Vetor de saída particionado.
  * @param Pos Vetor de posições indicando os inícios das partições.
  */
-void verifica_particoes(long long *Input, int n, long long *P, int np, long long *Output, int *Pos);
+void verifica_particoes(long long *Input, long long n, long long *P, int np, long long *Output, long long *Pos);
 
 /**
  * @brief Busca binária para determinar o índice da partição correspondente ao valor.
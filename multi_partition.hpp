@@ -0,0 +1,493 @@
+#ifndef MULTI_PARTITION_HPP
+#define MULTI_PARTITION_HPP
+
+/**
+ * Motor de particionamento genérico em C++ (somente cabeçalho).
+ *
+ * `mp::multi_partition<Key, NP>` particiona vetores de chaves int32_t,
+ * uint32_t, int64_t, uint64_t ou double (ou de registros T com um extrator de
+ * chave) com o mesmo algoritmo da versão em C: contagem com índice de faixa
+ * guardado, prefix sum e escrita estável. Com NP constante, a classificação
+ * é totalmente desenrolada e sem desvios: comparação vetorial da chave
+ * contra todos os separadores + popcount (até 64 faixas) ou busca binária
+ * sem desvios de profundidade fixa. `mp::partition` escolhe em tempo de
+ * execução a instância especializada para np = 8, 16, 32, 64, 128 ou 256.
+ *
+ * A interface em C (`multi_partition` em multi_partition.h) continua a
+ * mesma; este cabeçalho usa apenas o pool de threads da biblioteca.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+#include <pthread.h>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+extern "C"
+{
+#include "thread_pool.h"
+}
+
+namespace mp
+{
+
+// np conhecido só em tempo de execução
+constexpr int dynamic_np = 0;
+
+// Maior NP constante classificado por comparação contra todos os separadores
+constexpr int linear_np_limit = 64;
+
+/**
+ * @brief Extrator de chave padrão: o próprio elemento.
+ */
+template <class Key>
+struct key_identity
+{
+    Key operator()(const Key &value) const { return value; }
+};
+
+namespace detail
+{
+
+// Quantos dos m separadores ordenados são <= v (busca binária sem desvios)
+template <class Key>
+inline int branchless_count(const Key *sp, int m, Key v)
+{
+    if (m == 0)
+    {
+        return 0;
+    }
+
+    const Key *base = sp;
+    int n = m;
+    while (n > 1)
+    {
+        int half = n / 2;
+        base = base[half] <= v ? base + half : base;
+        n -= half;
+    }
+    return (int)(base - sp) + (*base <= v);
+}
+
+// Máscara com os `lanes` primeiros bits (lanes < 64)
+constexpr unsigned lane_mask(int lanes)
+{
+    return lanes >= 32 ? ~0u : (1u << lanes) - 1;
+}
+
+/**
+ * Comparação vetorial de v contra M separadores (M constante): cada vetor
+ * compara v (replicado) com 8 ou 16 separadores e o popcount da máscara
+ * soma os que são <= v. Sem AVX-512/AVX2, o laço constante é desenrolado.
+ */
+template <class Key, int M>
+struct linear_count
+{
+    static int count(const Key *sp, Key v)
+    {
+        int c = 0;
+#pragma GCC unroll 64
+        for (int j = 0; j < M; j++)
+        {
+            c += sp[j] <= v;
+        }
+        return c;
+    }
+};
+
+#if defined(__AVX512F__)
+// Separadores de 64 bits: 8 por vetor
+#define MP_LINEAR_COUNT_512(KeyT, SetT, LoadT, CmpExpr, Lanes)                 \
+    template <int M>                                                           \
+    struct linear_count<KeyT, M>                                               \
+    {                                                                          \
+        static int count(const KeyT *sp, KeyT v)                               \
+        {                                                                      \
+            const auto vv = SetT(v);                                           \
+            int c = 0;                                                         \
+            _Pragma("GCC unroll 16") for (int j = 0; j < M; j += Lanes)        \
+            {                                                                  \
+                const auto s = LoadT((const void *)(sp + j));                  \
+                unsigned m = (unsigned)(CmpExpr);                              \
+                c += __builtin_popcount(m & lane_mask(M - j < Lanes ? M - j : Lanes)); \
+            }                                                                  \
+            return c;                                                          \
+        }                                                                      \
+    };
+
+MP_LINEAR_COUNT_512(int64_t, _mm512_set1_epi64, _mm512_loadu_si512, _mm512_cmple_epi64_mask(s, vv), 8)
+MP_LINEAR_COUNT_512(uint64_t, _mm512_set1_epi64, _mm512_loadu_si512, _mm512_cmple_epu64_mask(s, vv), 8)
+MP_LINEAR_COUNT_512(int32_t, _mm512_set1_epi32, _mm512_loadu_si512, _mm512_cmple_epi32_mask(s, vv), 16)
+MP_LINEAR_COUNT_512(uint32_t, _mm512_set1_epi32, _mm512_loadu_si512, _mm512_cmple_epu32_mask(s, vv), 16)
+MP_LINEAR_COUNT_512(double, _mm512_set1_pd, _mm512_loadu_pd, _mm512_cmp_pd_mask(s, vv, _CMP_LE_OQ), 8)
+#undef MP_LINEAR_COUNT_512
+
+#elif defined(__AVX2__)
+// AVX2: sem comparação "<=" nem sem sinal; conta os separadores > v e subtrai
+template <int M>
+struct linear_count<int64_t, M>
+{
+    static int count(const int64_t *sp, int64_t v)
+    {
+        const __m256i vv = _mm256_set1_epi64x(v);
+        int greater = 0;
+#pragma GCC unroll 16
+        for (int j = 0; j < M; j += 4)
+        {
+            __m256i s = _mm256_loadu_si256((const __m256i *)(sp + j));
+            unsigned m = (unsigned)_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(s, vv)));
+            greater += __builtin_popcount(m & lane_mask(M - j < 4 ? M - j : 4));
+        }
+        return M - greater;
+    }
+};
+
+template <int M>
+struct linear_count<int32_t, M>
+{
+    static int count(const int32_t *sp, int32_t v)
+    {
+        const __m256i vv = _mm256_set1_epi32(v);
+        int greater = 0;
+#pragma GCC unroll 16
+        for (int j = 0; j < M; j += 8)
+        {
+            __m256i s = _mm256_loadu_si256((const __m256i *)(sp + j));
+            unsigned m = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(s, vv)));
+            greater += __builtin_popcount(m & lane_mask(M - j < 8 ? M - j : 8));
+        }
+        return M - greater;
+    }
+};
+
+template <int M>
+struct linear_count<double, M>
+{
+    static int count(const double *sp, double v)
+    {
+        const __m256d vv = _mm256_set1_pd(v);
+        int c = 0;
+#pragma GCC unroll 16
+        for (int j = 0; j < M; j += 4)
+        {
+            __m256d s = _mm256_loadu_pd(sp + j);
+            unsigned m = (unsigned)_mm256_movemask_pd(_mm256_cmp_pd(s, vv, _CMP_LE_OQ));
+            c += __builtin_popcount(m & lane_mask(M - j < 4 ? M - j : 4));
+        }
+        return c;
+    }
+};
+#endif
+
+/**
+ * Classificação em NP faixas: índice = número de separadores P[0..NP-2]
+ * menores ou iguais à chave, o que já coloca as chaves >= P[NP-1] na última
+ * faixa (mesmo resultado de `classify_partition` na versão em C).
+ */
+template <class Key, int NP>
+class classifier
+{
+public:
+    static constexpr int M = NP - 1; // Separadores efetivos
+
+    void build(const Key *P, int)
+    {
+        // Espaço extra para as leituras vetoriais do último grupo
+        std::memset(sp_, 0, sizeof(sp_));
+        std::memcpy(sp_, P, M * sizeof(Key));
+    }
+
+    int np() const { return NP; }
+
+    int operator()(Key v) const
+    {
+        if constexpr (M == 0)
+        {
+            return 0;
+        }
+        else if constexpr (NP <= linear_np_limit)
+        {
+            return linear_count<Key, M>::count(sp_, v);
+        }
+        else
+        {
+            // Profundidade constante: o compilador desenrola o laço inteiro
+            const Key *base = sp_;
+            int n = M;
+#pragma GCC unroll 16
+            while (n > 1)
+            {
+                int half = n / 2;
+                base = base[half] <= v ? base + half : base;
+                n -= half;
+            }
+            return (int)(base - sp_) + (*base <= v);
+        }
+    }
+
+private:
+    alignas(64) Key sp_[NP + 16];
+};
+
+// np em tempo de execução: busca binária sem desvios sobre um vetor
+template <class Key>
+class classifier<Key, dynamic_np>
+{
+public:
+    void build(const Key *P, int np)
+    {
+        sp_.assign(P, P + np);
+        np_ = np;
+    }
+
+    int np() const { return np_; }
+
+    int operator()(Key v) const { return branchless_count(sp_.data(), np_ - 1, v); }
+
+private:
+    std::vector<Key> sp_;
+    int np_ = 0;
+};
+
+// Menor tipo que guarda um índice de faixa
+template <int NP>
+using id_type = std::conditional_t<NP != dynamic_np && NP <= 256, uint8_t,
+                                   std::conditional_t<NP != dynamic_np && NP <= 65536, uint16_t, uint32_t>>;
+
+} // namespace detail
+
+/**
+ * @brief Interface comum às instâncias de `multi_partition` (usada pelo despachante).
+ */
+template <class T>
+class partitioner
+{
+public:
+    virtual ~partitioner() = default;
+
+    /**
+     * @brief Particiona Input em Output (estável) e preenche Pos (np posições).
+     */
+    virtual void run(const T *Input, size_t n, T *Output, size_t *Pos) = 0;
+};
+
+/**
+ * @brief Particionador com tipo de chave e número de faixas fixos.
+ *
+ * @tparam Key Tipo da chave (int32_t, uint32_t, int64_t, uint64_t, double, ...).
+ * @tparam NP Número de faixas constante ou `dynamic_np`.
+ * @tparam T Tipo dos elementos (padrão: a própria chave).
+ * @tparam KeyOf Extrator `Key(const T &)`.
+ *
+ * O construtor copia os separadores e cria os workers, reaproveitados em
+ * todas as chamadas. P deve estar ordenado; chaves >= P[np-1] vão para a
+ * última faixa.
+ */
+template <class Key, int NP = dynamic_np, class T = Key, class KeyOf = key_identity<Key>>
+class multi_partition : public partitioner<T>
+{
+public:
+    multi_partition(const Key *P, int np, int nThreads, KeyOf key_of = KeyOf())
+        : key_of_(key_of), nThreads_(nThreads > 0 ? nThreads : 1), np_(NP != dynamic_np ? NP : np)
+    {
+        classify_.build(P, np_);
+        row_ = (np_ + 7) & ~7; // Contagens de cada thread em linhas de cache próprias
+        counts_.assign((size_t)row_ * nThreads_, 0);
+        work_.resize(nThreads_);
+        for (int t = 0; t < nThreads_; t++)
+        {
+            work_[t].self = this;
+            work_[t].id = t;
+        }
+        pthread_barrier_init(&barrier_, nullptr, nThreads_);
+        pool_ = thread_pool_create(nThreads_);
+    }
+
+    ~multi_partition() override
+    {
+        thread_pool_destroy(pool_);
+        pthread_barrier_destroy(&barrier_);
+    }
+
+    multi_partition(const multi_partition &) = delete;
+    multi_partition &operator=(const multi_partition &) = delete;
+
+    /**
+     * @brief Faixa de uma chave.
+     */
+    int classify(Key key) const { return classify_(key); }
+
+    void run(const T *Input, size_t n, T *Output, size_t *Pos) override
+    {
+        if (ids_.size() < n)
+        {
+            ids_.resize(n);
+        }
+        Input_ = Input;
+        Output_ = Output;
+        Pos_ = Pos;
+        n_ = n;
+
+        if (pool_ == nullptr)
+        {
+            // Sem workers: as fases rodam em sequência na thread atual
+            for (int t = 0; t < nThreads_; t++)
+            {
+                count_phase(t);
+            }
+            prefix_phase();
+            for (int t = 0; t < nThreads_; t++)
+            {
+                scatter_phase(t);
+            }
+            return;
+        }
+        thread_pool_run(pool_, worker, work_.data(), sizeof(work_item));
+    }
+
+    void operator()(const T *Input, size_t n, T *Output, size_t *Pos) { run(Input, n, Output, Pos); }
+
+private:
+    using id_t = detail::id_type<NP>;
+
+    struct work_item
+    {
+        multi_partition *self;
+        int id;
+    };
+
+    void chunk(int t, size_t &start, size_t &end) const
+    {
+        size_t size = (n_ + nThreads_ - 1) / nThreads_;
+        start = t * size < n_ ? t * size : n_;
+        end = start + size < n_ ? start + size : n_;
+    }
+
+    void count_phase(int t)
+    {
+        size_t start, end;
+        size_t *counts = &counts_[(size_t)row_ * t];
+
+        chunk(t, start, end);
+        std::fill(counts, counts + np_, 0);
+        for (size_t i = start; i < end; i++)
+        {
+            int id = classify_(key_of_(Input_[i]));
+            ids_[i] = (id_t)id;
+            counts[id]++;
+        }
+    }
+
+    // Deslocamento de cada thread em cada faixa e Pos (thread 0)
+    void prefix_phase()
+    {
+        size_t base = 0;
+        for (int j = 0; j < np_; j++)
+        {
+            Pos_[j] = base;
+            for (int t = 0; t < nThreads_; t++)
+            {
+                size_t c = counts_[(size_t)row_ * t + j];
+                counts_[(size_t)row_ * t + j] = base;
+                base += c;
+            }
+        }
+    }
+
+    void scatter_phase(int t)
+    {
+        size_t start, end;
+        size_t *offsets = &counts_[(size_t)row_ * t];
+
+        chunk(t, start, end);
+        for (size_t i = start; i < end; i++)
+        {
+            Output_[offsets[ids_[i]]++] = Input_[i];
+        }
+    }
+
+    static void *worker(void *arg)
+    {
+        work_item *w = static_cast<work_item *>(arg);
+        multi_partition *self = w->self;
+
+        self->count_phase(w->id);
+        pthread_barrier_wait(&self->barrier_);
+        if (w->id == 0)
+        {
+            self->prefix_phase();
+        }
+        pthread_barrier_wait(&self->barrier_);
+        self->scatter_phase(w->id);
+        return nullptr;
+    }
+
+    detail::classifier<Key, NP> classify_;
+    KeyOf key_of_;
+    int nThreads_;
+    int np_;
+    int row_;
+    std::vector<size_t> counts_;
+    std::vector<id_t> ids_;
+    std::vector<work_item> work_;
+    pthread_barrier_t barrier_;
+    thread_pool_t *pool_ = nullptr;
+
+    const T *Input_ = nullptr;
+    T *Output_ = nullptr;
+    size_t *Pos_ = nullptr;
+    size_t n_ = 0;
+};
+
+/**
+ * @brief Cria o particionador especializado para np (despachante em tempo de execução).
+ *
+ * Para np = 8, 16, 32, 64, 128 ou 256 devolve a instância com NP constante;
+ * para os demais valores, a instância com `dynamic_np`.
+ */
+template <class Key, class T = Key, class KeyOf = key_identity<Key>>
+std::unique_ptr<partitioner<T>> make_partitioner(const Key *P, int np, int nThreads, KeyOf key_of = KeyOf())
+{
+    switch (np)
+    {
+    case 8:
+        return std::make_unique<multi_partition<Key, 8, T, KeyOf>>(P, np, nThreads, key_of);
+    case 16:
+        return std::make_unique<multi_partition<Key, 16, T, KeyOf>>(P, np, nThreads, key_of);
+    case 32:
+        return std::make_unique<multi_partition<Key, 32, T, KeyOf>>(P, np, nThreads, key_of);
+    case 64:
+        return std::make_unique<multi_partition<Key, 64, T, KeyOf>>(P, np, nThreads, key_of);
+    case 128:
+        return std::make_unique<multi_partition<Key, 128, T, KeyOf>>(P, np, nThreads, key_of);
+    case 256:
+        return std::make_unique<multi_partition<Key, 256, T, KeyOf>>(P, np, nThreads, key_of);
+    default:
+        return std::make_unique<multi_partition<Key, dynamic_np, T, KeyOf>>(P, np, nThreads, key_of);
+    }
+}
+
+/**
+ * @brief Particiona uma única vez com a instância escolhida por `make_partitioner`.
+ *
+ * Para várias chamadas com os mesmos P e np, guarde o particionador de
+ * `make_partitioner` e evite recriar os workers.
+ */
+template <class Key, class T = Key, class KeyOf = key_identity<Key>>
+void partition(const T *Input, size_t n, const Key *P, int np, T *Output, size_t *Pos, int nThreads,
+               KeyOf key_of = KeyOf())
+{
+    make_partitioner<Key, T, KeyOf>(P, np, nThreads, key_of)->run(Input, n, Output, Pos);
+}
+
+} // namespace mp
+
+#endif // MULTI_PARTITION_HPP
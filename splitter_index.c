@@ -0,0 +1,645 @@
+#include <limits.h> // Para LLONG_MAX
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+
+#include "splitter_index.h"
+
+#define B SPLITTER_NODE_KEYS
+
+// Conta as chaves do nó menores ou iguais a `value` (sem desvios)
+static inline int node_count_le_scalar(const long long *node, long long value)
+{
+    int count = 0;
+    for (int j = 0; j < B; j++)
+    {
+        count += node[j] <= value;
+    }
+    return count;
+}
+
+__attribute__((target("sse4.2,popcnt"))) static inline int node_count_le_sse42(const long long *node, long long value)
+{
+    __m128i v = _mm_set1_epi64x(value);
+    int gt = 0;
+
+    // Bits de chave > value em cada metade de 128 bits
+    for (int j = 0; j < B; j += 2)
+    {
+        __m128i keys = _mm_load_si128((const __m128i *)(node + j));
+        gt += __builtin_popcount(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(keys, v))));
+    }
+    return B - gt;
+}
+
+__attribute__((target("avx2,popcnt"))) static inline int node_count_le_avx2(const long long *node, long long value)
+{
+    __m256i v = _mm256_set1_epi64x(value);
+    __m256i lo = _mm256_load_si256((const __m256i *)node);
+    __m256i hi = _mm256_load_si256((const __m256i *)(node + 4));
+    int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(lo, v))) |
+               (_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(hi, v))) << 4);
+    return B - __builtin_popcount(mask);
+}
+
+__attribute__((target("avx512f,popcnt"))) static inline int node_count_le_avx512(const long long *node, long long value)
+{
+    __m512i keys = _mm512_load_si512((const void *)node);
+    __mmask8 mask = _mm512_cmple_epi64_mask(keys, _mm512_set1_epi64(value));
+    return __builtin_popcount(mask);
+}
+
+// Desce a árvore um nó por nível; o resultado é a posição em P da primeira
+// chave maior que `value` (ou np se não houver)
+#define SPLITTER_SEARCH_BODY(count_le)                                 \
+    const long long *keys = index->keys;                               \
+    const int *ids = index->ids;                                       \
+    int nblocks = index->nblocks;                                      \
+    int result = index->np;                                            \
+    int k = 0;                                                         \
+    while (k < nblocks)                                                \
+    {                                                                  \
+        int i = count_le(keys + (size_t)k * B, value);                 \
+        int candidate = ids[(size_t)k * B + (i & (B - 1))];            \
+        result = i < B ? candidate : result;                           \
+        k = k * (B + 1) + i + 1;                                       \
+    }                                                                  \
+    return result;
+
+static int search_scalar(const splitter_index_t *index, long long value)
+{
+    SPLITTER_SEARCH_BODY(node_count_le_scalar)
+}
+
+__attribute__((target("sse4.2,popcnt"))) static int search_sse42(const splitter_index_t *index, long long value)
+{
+    SPLITTER_SEARCH_BODY(node_count_le_sse42)
+}
+
+__attribute__((target("avx2,popcnt"))) static int search_avx2(const splitter_index_t *index, long long value)
+{
+    SPLITTER_SEARCH_BODY(node_count_le_avx2)
+}
+
+__attribute__((target("avx512f,popcnt"))) static int search_avx512(const splitter_index_t *index, long long value)
+{
+    SPLITTER_SEARCH_BODY(node_count_le_avx512)
+}
+
+// Mesma descida para grupos de SPLITTER_BATCH chaves em passo sincronizado:
+// cada nível avança todas as chaves do grupo e já pede (prefetch) o nó do
+// nível seguinte de cada uma, de modo que as faltas de cache das chaves do
+// grupo se sobrepõem em vez de esperarem umas pelas outras
+#define SPLITTER_SEARCH_BATCH_BODY(count_le)                                  \
+    const long long *keys = index->keys;                                      \
+    const int *ids = index->ids;                                              \
+    int nblocks = index->nblocks;                                             \
+    for (int base = 0; base < count; base += SPLITTER_BATCH)                  \
+    {                                                                         \
+        int m = count - base < SPLITTER_BATCH ? count - base : SPLITTER_BATCH; \
+        const long long *v = values + base;                                   \
+        int k[SPLITTER_BATCH], result[SPLITTER_BATCH];                        \
+        for (int b = 0; b < m; b++)                                           \
+        {                                                                     \
+            k[b] = 0;                                                         \
+            result[b] = index->np;                                            \
+        }                                                                     \
+        /* Níveis completos: todas as chaves descem */                        \
+        for (int level = 0; level < index->depth - 1; level++)                \
+        {                                                                     \
+            for (int b = 0; b < m; b++)                                       \
+            {                                                                 \
+                int i = count_le(keys + (size_t)k[b] * B, v[b]);              \
+                int candidate = ids[(size_t)k[b] * B + (i & (B - 1))];        \
+                result[b] = i < B ? candidate : result[b];                    \
+                k[b] = k[b] * (B + 1) + i + 1;                                \
+                __builtin_prefetch(keys + (size_t)k[b] * B);                  \
+                __builtin_prefetch(ids + (size_t)k[b] * B);                   \
+            }                                                                 \
+        }                                                                     \
+        /* Último nível (incompleto): só as chaves que caíram em um nó */     \
+        for (int b = 0; b < m; b++)                                           \
+        {                                                                     \
+            if (k[b] < nblocks)                                               \
+            {                                                                 \
+                int i = count_le(keys + (size_t)k[b] * B, v[b]);              \
+                int candidate = ids[(size_t)k[b] * B + (i & (B - 1))];        \
+                result[b] = i < B ? candidate : result[b];                    \
+            }                                                                 \
+        }                                                                     \
+        for (int b = 0; b < m; b++)                                           \
+        {                                                                     \
+            out[base + b] = result[b];                                        \
+        }                                                                     \
+    }
+
+static void search_batch_scalar(const splitter_index_t *index, const long long *values, int count, int *out)
+{
+    SPLITTER_SEARCH_BATCH_BODY(node_count_le_scalar)
+}
+
+__attribute__((target("sse4.2,popcnt"))) static void search_batch_sse42(const splitter_index_t *index,
+                                                                         const long long *values, int count, int *out)
+{
+    SPLITTER_SEARCH_BATCH_BODY(node_count_le_sse42)
+}
+
+__attribute__((target("avx2,popcnt"))) static void search_batch_avx2(const splitter_index_t *index,
+                                                                      const long long *values, int count, int *out)
+{
+    SPLITTER_SEARCH_BATCH_BODY(node_count_le_avx2)
+}
+
+__attribute__((target("avx512f,popcnt"))) static void search_batch_avx512(const splitter_index_t *index,
+                                                                          const long long *values, int count, int *out)
+{
+    SPLITTER_SEARCH_BATCH_BODY(node_count_le_avx512)
+}
+
+// Chave como inteiro sem sinal na mesma ordem (bit de sinal invertido)
+static inline unsigned long long key_bits(long long value)
+{
+    return (unsigned long long)value ^ (1ULL << 63);
+}
+
+// Quantidade de chaves em sorted[lo, hi) menores ou iguais a `value`, mais
+// lo (busca binária sem desvios na janela)
+static inline int window_count(const long long *sorted, int lo, int hi, long long value)
+{
+    int len = hi - lo;
+    const long long *base = sorted + lo;
+
+    if (len == 0)
+    {
+        return lo;
+    }
+    while (len > 1)
+    {
+        int half = len / 2;
+        base = base[half] <= value ? base + half : base;
+        len -= half;
+    }
+    return (int)(base - sorted) + (*base <= value);
+}
+
+// Janela [lo, hi] da resposta pela tabela de baldes
+static inline void lut_window(const splitter_index_t *index, long long value, int *lo, int *hi)
+{
+    unsigned long long bits = key_bits(value);
+    unsigned long long b = bits < index->lut_base ? 0 : (bits - index->lut_base) >> index->lut_shift;
+    b = b < (unsigned long long)index->lut_buckets ? b : (unsigned long long)index->lut_buckets - 1;
+
+    *lo = index->lut[b];
+    *hi = index->lut[b + 1];
+}
+
+// Folha do RMI de `value` (a mesma expressão na construção e na busca)
+static inline int rmi_leaf(const splitter_index_t *index, long long value)
+{
+    double f = (double)value * index->root_slope + index->root_intercept;
+    return f < 1.0 ? 0 : (f >= index->nleaves ? index->nleaves - 1 : (int)f);
+}
+
+// Posição prevista pela folha, limitada às posições da folha
+static inline int rmi_predict(const splitter_leaf_t *leaf, long long value)
+{
+    double f = (double)value * leaf->slope + leaf->intercept;
+    return f < leaf->start ? leaf->start : (f >= leaf->end ? leaf->end : (int)f);
+}
+
+// Janela [lo, hi] da resposta pelo RMI
+static inline void rmi_window(const splitter_index_t *index, long long value, int *lo, int *hi)
+{
+    const splitter_leaf_t *leaf = &index->leaves[rmi_leaf(index, value)];
+    int p = rmi_predict(leaf, value);
+
+    *lo = p - leaf->err_lo > leaf->start ? p - leaf->err_lo : leaf->start;
+    *hi = p + leaf->err_hi < leaf->end ? p + leaf->err_hi : leaf->end;
+}
+
+// Previsão seguida da busca na janela; em lote, as janelas do grupo são
+// calculadas (e pedidas com prefetch) antes das buscas
+#define SPLITTER_PREDICT_BODIES(name, window)                                                        \
+    static int search_##name(const splitter_index_t *index, long long value)                         \
+    {                                                                                                \
+        int lo, hi;                                                                                  \
+        window(index, value, &lo, &hi);                                                              \
+        return window_count(index->sorted, lo, hi, value);                                           \
+    }                                                                                                \
+                                                                                                     \
+    static void search_batch_##name(const splitter_index_t *index, const long long *values, int count, \
+                                    int *out)                                                        \
+    {                                                                                                \
+        for (int base = 0; base < count; base += SPLITTER_BATCH)                                     \
+        {                                                                                            \
+            int m = count - base < SPLITTER_BATCH ? count - base : SPLITTER_BATCH;                   \
+            int lo[SPLITTER_BATCH], hi[SPLITTER_BATCH];                                              \
+            for (int b = 0; b < m; b++)                                                              \
+            {                                                                                        \
+                window(index, values[base + b], &lo[b], &hi[b]);                                     \
+                __builtin_prefetch(index->sorted + lo[b] + (hi[b] - lo[b]) / 2);                     \
+            }                                                                                        \
+            for (int b = 0; b < m; b++)                                                              \
+            {                                                                                        \
+                out[base + b] = window_count(index->sorted, lo[b], hi[b], values[base + b]);         \
+            }                                                                                        \
+        }                                                                                            \
+    }
+
+SPLITTER_PREDICT_BODIES(lut, lut_window)
+SPLITTER_PREDICT_BODIES(rmi, rmi_window)
+
+// Aponta `search` para o modelo em uso ou para a árvore
+static void select_search(splitter_index_t *index)
+{
+    switch (index->model)
+    {
+    case SPLITTER_PREDICT_LUT:
+        index->search = search_lut;
+        index->search_batch = search_batch_lut;
+        break;
+    case SPLITTER_PREDICT_RMI:
+        index->search = search_rmi;
+        index->search_batch = search_batch_rmi;
+        break;
+    default:
+        index->search = index->tree_search;
+        index->search_batch = index->tree_search_batch;
+        break;
+    }
+}
+
+// Maior chave de P sem contar as LLONG_MAX finais (limite superior dos modelos)
+static long long model_top(const long long *P, int np)
+{
+    int last = np - 1;
+    while (last > 0 && P[last] == LLONG_MAX)
+    {
+        last--;
+    }
+    return P[last];
+}
+
+// Tabela de baldes; devolve a maior janela ou -1 se faltar memória
+static int build_lut(splitter_index_t *index, const long long *P, int np)
+{
+    unsigned long long span = key_bits(model_top(P, np)) - key_bits(P[0]);
+    int buckets = 1;
+
+    // ~2 baldes por partição, em potência de 2, e só o necessário para cobrir P
+    while (buckets < 2 * np && buckets < (1 << 22) && (unsigned long long)buckets <= span)
+    {
+        buckets *= 2;
+    }
+    if (buckets + 1 > index->lut_capacity)
+    {
+        free(index->lut);
+        index->lut = malloc((size_t)(buckets + 1) * sizeof(int));
+        index->lut_capacity = index->lut != NULL ? buckets + 1 : 0;
+        if (index->lut == NULL)
+        {
+            return -1;
+        }
+    }
+
+    int shift = 0;
+    while (shift < 64 && (span >> shift) >= (unsigned long long)buckets)
+    {
+        shift++;
+    }
+
+    index->lut_base = key_bits(P[0]);
+    index->lut_shift = shift;
+    index->lut_buckets = buckets;
+
+    // lut[b] = partições com chave menor que o início do balde b
+    int t = 0, window = 0;
+    for (int b = 0; b < buckets; b++)
+    {
+        unsigned __int128 start = (unsigned __int128)index->lut_base + ((unsigned __int128)b << shift);
+        while (t < np && key_bits(P[t]) < start)
+        {
+            t++;
+        }
+        index->lut[b] = t;
+    }
+    index->lut[buckets] = np;
+    for (int b = 0; b < buckets; b++)
+    {
+        int w = index->lut[b + 1] - index->lut[b];
+        window = w > window ? w : window;
+    }
+    return window;
+}
+
+// Folhas do RMI; devolve a maior janela ou -1 se faltar memória
+static int build_rmi(splitter_index_t *index, const long long *P, int np)
+{
+    int nleaves = np / SPLITTER_RMI_LEAF_KEYS > 0 ? np / SPLITTER_RMI_LEAF_KEYS : 1;
+    double first = (double)P[0], top = (double)model_top(P, np);
+
+    if (nleaves > index->leaves_capacity)
+    {
+        free(index->leaves);
+        index->leaves = malloc(nleaves * sizeof(splitter_leaf_t));
+        index->leaves_capacity = index->leaves != NULL ? nleaves : 0;
+        if (index->leaves == NULL)
+        {
+            return -1;
+        }
+    }
+
+    index->nleaves = nleaves;
+    index->root_slope = top > first ? nleaves / (top - first) : 0.0;
+    index->root_intercept = -first * index->root_slope;
+
+    // Posições de cada folha: a folha de P[i] não decresce com i
+    int i = 0;
+    for (int l = 0; l < nleaves; l++)
+    {
+        splitter_leaf_t *leaf = &index->leaves[l];
+        leaf->start = i;
+        while (i < np && rmi_leaf(index, P[i]) == l)
+        {
+            i++;
+        }
+        leaf->end = i;
+    }
+
+    int window = 0;
+    for (int l = 0; l < nleaves; l++)
+    {
+        splitter_leaf_t *leaf = &index->leaves[l];
+        int s = leaf->start, e = leaf->end;
+
+        // Reta entre a primeira e a última chave finita da folha; y = resposta na chave
+        int last = e - 1;
+        while (last > s && P[last] == LLONG_MAX)
+        {
+            last--;
+        }
+        double dx = e > s ? (double)P[last] - (double)P[s] : 0.0; // Zero se as chaves colidem em double
+        leaf->slope = 0.0;
+        leaf->intercept = s;
+        if (dx > 0.0)
+        {
+            leaf->slope = (double)(last - s) / dx;
+            leaf->intercept = (s + 1) - (double)P[s] * leaf->slope;
+        }
+
+        // Erros medidos em cada degrau da resposta: em [P[j], P[j + 1]) a
+        // resposta é u(j) (posições até a última cópia de P[j]) e a previsão
+        // fica entre a de P[j] e a de P[j + 1]
+        int err_lo = e > s ? rmi_predict(leaf, P[s]) - s : 0, err_hi = 0;
+        for (int j = s; j < e; j++)
+        {
+            int u = j + 1;
+            while (u < e && P[u] == P[j])
+            {
+                u++;
+            }
+            int d = u - rmi_predict(leaf, P[j]);
+            err_hi = d > err_hi ? d : err_hi;
+            if (u < e)
+            {
+                d = rmi_predict(leaf, P[u]) - u;
+                err_lo = d > err_lo ? d : err_lo;
+            }
+            j = u - 1;
+        }
+        leaf->err_lo = err_lo;
+        leaf->err_hi = err_hi;
+
+        int w = err_lo + err_hi < e - s ? err_lo + err_hi : e - s;
+        window = w > window ? w : window;
+    }
+    return window;
+}
+
+// Refaz o modelo pedido sobre P; sem modelo bom o bastante, fica a árvore
+static int build_model(splitter_index_t *index, const long long *P, int np)
+{
+    index->model = SPLITTER_PREDICT_NONE;
+    index->window = 0;
+    if (index->predict == SPLITTER_PREDICT_NONE)
+    {
+        select_search(index);
+        return 0;
+    }
+
+    if (np > index->sorted_capacity)
+    {
+        free(index->sorted);
+        index->sorted = malloc((size_t)np * sizeof(long long));
+        index->sorted_capacity = index->sorted != NULL ? np : 0;
+        if (index->sorted == NULL)
+        {
+            select_search(index);
+            return -1;
+        }
+    }
+    memcpy(index->sorted, P, (size_t)np * sizeof(long long));
+
+    int lut = index->predict != SPLITTER_PREDICT_RMI ? build_lut(index, P, np) : INT_MAX;
+    int rmi = index->predict != SPLITTER_PREDICT_LUT ? build_rmi(index, P, np) : INT_MAX;
+    if (lut < 0 || rmi < 0)
+    {
+        select_search(index);
+        return -1;
+    }
+
+    if (lut <= rmi && lut <= SPLITTER_PREDICT_MAX_WINDOW)
+    {
+        index->model = SPLITTER_PREDICT_LUT;
+        index->window = lut;
+    }
+    else if (rmi <= SPLITTER_PREDICT_MAX_WINDOW)
+    {
+        index->model = SPLITTER_PREDICT_RMI;
+        index->window = rmi;
+    }
+    select_search(index);
+    return 0;
+}
+
+// P ordenado a partir das chaves da árvore (posição ids[x] recebe keys[x])
+static void tree_to_sorted(const splitter_index_t *index, long long *P)
+{
+    for (size_t x = 0; x < (size_t)index->nblocks * B; x++)
+    {
+        if (index->ids[x] < index->np)
+        {
+            P[index->ids[x]] = index->keys[x];
+        }
+    }
+}
+
+int splitter_index_set_predict(splitter_index_t *index, splitter_predict_t predict)
+{
+    long long *P = malloc((size_t)index->np * sizeof(long long));
+    if (P == NULL)
+    {
+        return -1;
+    }
+
+    tree_to_sorted(index, P);
+    index->predict = predict;
+    int ret = build_model(index, P, index->np);
+    free(P);
+    if (ret != 0)
+    {
+        return -1;
+    }
+    return predict == SPLITTER_PREDICT_NONE || index->model != SPLITTER_PREDICT_NONE ? 0 : 1;
+}
+
+const char *splitter_index_predict_name(const splitter_index_t *index)
+{
+    static const char *names[] = {"tree", "lut", "rmi", "auto"};
+    return names[index->model];
+}
+
+static int isa_supported(splitter_isa_t isa)
+{
+    __builtin_cpu_init();
+
+    switch (isa)
+    {
+    case SPLITTER_ISA_SCALAR:
+        return 1;
+    case SPLITTER_ISA_SSE42:
+        return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+    case SPLITTER_ISA_AVX2:
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+    case SPLITTER_ISA_AVX512:
+        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("popcnt");
+    }
+    return 0;
+}
+
+int splitter_index_set_isa(splitter_index_t *index, splitter_isa_t isa)
+{
+    if (!isa_supported(isa))
+    {
+        return -1;
+    }
+
+    switch (isa)
+    {
+    case SPLITTER_ISA_SSE42:
+        index->tree_search = search_sse42;
+        index->tree_search_batch = search_batch_sse42;
+        break;
+    case SPLITTER_ISA_AVX2:
+        index->tree_search = search_avx2;
+        index->tree_search_batch = search_batch_avx2;
+        break;
+    case SPLITTER_ISA_AVX512:
+        index->tree_search = search_avx512;
+        index->tree_search_batch = search_batch_avx512;
+        break;
+    default:
+        index->tree_search = search_scalar;
+        index->tree_search_batch = search_batch_scalar;
+        break;
+    }
+    index->isa = isa;
+    select_search(index);
+    return 0;
+}
+
+const char *splitter_index_isa_name(const splitter_index_t *index)
+{
+    static const char *names[] = {"scalar", "sse4.2", "avx2", "avx512"};
+    return names[index->isa];
+}
+
+// Preenche os nós em ordem simétrica a partir do nó k
+static void build_inorder(splitter_index_t *index, const long long *P, int np, int k, int *t)
+{
+    if (k >= index->nblocks)
+    {
+        return;
+    }
+
+    for (int i = 0; i < B; i++)
+    {
+        build_inorder(index, P, np, k * (B + 1) + i + 1, t);
+
+        // Posições além de np são preenchidas com LLONG_MAX e apontam para np
+        index->keys[(size_t)k * B + i] = *t < np ? P[*t] : LLONG_MAX;
+        index->ids[(size_t)k * B + i] = *t < np ? *t : np;
+        (*t)++;
+    }
+    build_inorder(index, P, np, k * (B + 1) + B + 1, t);
+}
+
+int splitter_index_build(splitter_index_t *index, const long long *P, int np)
+{
+    int nblocks = (np + B - 1) / B;
+
+    if (nblocks > index->capacity)
+    {
+        free(index->keys);
+        free(index->ids);
+        index->keys = aligned_alloc(64, (size_t)nblocks * B * sizeof(long long));
+        index->ids = malloc((size_t)nblocks * B * sizeof(int));
+        index->capacity = index->keys != NULL && index->ids != NULL ? nblocks : 0;
+        if (index->capacity == 0)
+        {
+            return -1;
+        }
+    }
+
+    index->np = np;
+    index->nblocks = nblocks;
+
+    // Níveis da árvore: o nível d tem (B + 1)^d nós
+    index->depth = 0;
+    for (long long reach = 0, width = 1; reach < nblocks; reach += width, width *= B + 1)
+    {
+        index->depth++;
+    }
+
+    int t = 0;
+    build_inorder(index, P, np, 0, &t);
+    return build_model(index, P, np);
+}
+
+splitter_index_t *splitter_index_create(const long long *P, int np)
+{
+    splitter_index_t *index = (splitter_index_t *)calloc(1, sizeof(splitter_index_t));
+    if (index == NULL)
+    {
+        return NULL;
+    }
+
+    if (splitter_index_build(index, P, np) != 0)
+    {
+        splitter_index_destroy(index);
+        return NULL;
+    }
+
+    // Melhor implementação disponível na CPU
+    if (splitter_index_set_isa(index, SPLITTER_ISA_AVX512) != 0 &&
+        splitter_index_set_isa(index, SPLITTER_ISA_AVX2) != 0 &&
+        splitter_index_set_isa(index, SPLITTER_ISA_SSE42) != 0)
+    {
+        splitter_index_set_isa(index, SPLITTER_ISA_SCALAR);
+    }
+
+    return index;
+}
+
+void splitter_index_destroy(splitter_index_t *index)
+{
+    if (index != NULL)
+    {
+        free(index->keys);
+        free(index->ids);
+        free(index->sorted);
+        free(index->lut);
+        free(index->leaves);
+        free(index);
+    }
+}
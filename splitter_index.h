@@ -0,0 +1,198 @@
+#ifndef SPLITTER_INDEX_H
+#define SPLITTER_INDEX_H
+
+#include <limits.h> // Para LLONG_MAX
+
+// Chaves por nó: 8 long long = uma linha de cache de 64 bytes
+#define SPLITTER_NODE_KEYS 8
+
+// Chaves que descem a árvore juntas na busca em lote
+#define SPLITTER_BATCH 16
+
+/**
+ * @brief Conjuntos de instruções usados na comparação de um nó.
+ */
+typedef enum
+{
+    SPLITTER_ISA_SCALAR = 0, // Escalar, sem desvios
+    SPLITTER_ISA_SSE42,      // 4 comparações de 128 bits
+    SPLITTER_ISA_AVX2,       // 2 comparações de 256 bits
+    SPLITTER_ISA_AVX512      // 1 comparação de 512 bits
+} splitter_isa_t;
+
+/**
+ * @brief Previsão da faixa usada antes da busca (ver `splitter_index_set_predict`).
+ */
+typedef enum
+{
+    SPLITTER_PREDICT_NONE = 0, // Só a árvore
+    SPLITTER_PREDICT_LUT,      // Tabela indexada pelos bits altos da chave
+    SPLITTER_PREDICT_RMI,      // Modelo linear por trechos (RMI de dois níveis)
+    SPLITTER_PREDICT_AUTO      // O de menor janela entre LUT e RMI
+} splitter_predict_t;
+
+// Maior janela de correção aceita; acima disso o índice volta para a árvore
+#define SPLITTER_PREDICT_MAX_WINDOW 32
+
+// Chaves de P por folha do RMI
+#define SPLITTER_RMI_LEAF_KEYS 16
+
+/**
+ * @brief Folha do RMI: reta posição ~ chave e erros máximos da previsão.
+ */
+typedef struct
+{
+    double slope;     // Inclinação da reta.
+    double intercept; // Posição prevista para a chave 0.
+    int start;        // Primeira posição de P que cai na folha.
+    int end;          // Fim (exclusivo) das posições de P da folha.
+    int err_lo;       // Quanto a resposta pode ficar abaixo da previsão.
+    int err_hi;       // Quanto a resposta pode ficar acima da previsão.
+} splitter_leaf_t;
+
+typedef struct splitter_index splitter_index_t;
+
+/**
+ * @brief Índice de busca sobre o vetor de partições P (árvore k-ária estática).
+ *
+ * Cada nó guarda 8 chaves em uma linha de cache alinhada e tem 9 filhos; o
+ * filho i do nó k é o nó k * 9 + i + 1. As chaves são distribuídas em ordem
+ * simétrica, de modo que a busca desce um nó por nível com uma única
+ * comparação vetorial seguida de movemask/popcount.
+ */
+struct splitter_index
+{
+    int np;            // Número de partições (tamanho de P).
+    int nblocks;       // Número de nós da árvore.
+    int depth;         // Número de níveis da árvore.
+    int capacity;      // Número de nós alocados.
+    long long *keys;   // Chaves dos nós (nblocks x 8), alinhadas em 64 bytes.
+    int *ids;          // Posição em P de cada chave (np para as chaves de preenchimento).
+    splitter_isa_t isa; // Implementação escolhida para `search`.
+    int (*search)(const splitter_index_t *index, long long value);
+    void (*search_batch)(const splitter_index_t *index, const long long *values, int count, int *out);
+    int (*tree_search)(const splitter_index_t *index, long long value); // Busca na árvore da `isa`.
+    void (*tree_search_batch)(const splitter_index_t *index, const long long *values, int count, int *out);
+    splitter_predict_t predict; // Previsão pedida.
+    splitter_predict_t model;   // Previsão em uso (SPLITTER_PREDICT_NONE = árvore).
+    int window;                 // Maior janela de correção do modelo em uso.
+    long long *sorted;          // [previsão] Cópia de P, onde a janela é buscada.
+    int sorted_capacity;        // [previsão] Posições alocadas em `sorted`.
+    unsigned long long lut_base; // [LUT] Menor chave (com o bit de sinal invertido).
+    int lut_shift;              // [LUT] Deslocamento da chave até o balde.
+    int lut_buckets;            // [LUT] Número de baldes.
+    int lut_capacity;           // [LUT] Baldes alocados.
+    int *lut;                   // [LUT] Primeira posição de P de cada balde (lut_buckets + 1).
+    double root_slope;          // [RMI] Reta chave -> folha.
+    double root_intercept;      // [RMI]
+    int nleaves;                // [RMI] Número de folhas.
+    int leaves_capacity;        // [RMI] Folhas alocadas.
+    splitter_leaf_t *leaves;    // [RMI] Folhas.
+};
+
+/**
+ * @brief Cria o índice a partir do vetor de partições ordenado P.
+ *
+ * @param P Vetor de partições (ordenado).
+ * @param np Número de partições.
+ * @return splitter_index_t* Índice criado ou NULL em caso de falha.
+ *
+ * A implementação da busca é escolhida em tempo de execução conforme a CPU
+ * (AVX-512, AVX2, SSE4.2 ou escalar). O índice deve ser liberado com
+ * `splitter_index_destroy`.
+ */
+splitter_index_t *splitter_index_create(const long long *P, int np);
+
+/**
+ * @brief Reconstrói o índice com um novo vetor P, reaproveitando a memória.
+ *
+ * @param index Índice existente.
+ * @param P Vetor de partições (ordenado).
+ * @param np Número de partições.
+ * @return int 0 em caso de sucesso ou -1 se faltar memória.
+ */
+int splitter_index_build(splitter_index_t *index, const long long *P, int np);
+
+/**
+ * @brief Força uma implementação da busca (ex.: para comparar desempenho).
+ *
+ * @param index Índice.
+ * @param isa Implementação desejada.
+ * @return int 0 em caso de sucesso ou -1 se a CPU não suporta `isa`.
+ */
+int splitter_index_set_isa(splitter_index_t *index, splitter_isa_t isa);
+
+/**
+ * @brief Troca a busca na árvore por uma previsão da faixa seguida de uma
+ *        busca curta e exata.
+ *
+ * @param index Índice.
+ * @param predict Previsão desejada.
+ * @return int 0 se a previsão está em uso, 1 se o erro do modelo passou de
+ *             SPLITTER_PREDICT_MAX_WINDOW (o índice continua com a árvore)
+ *             ou -1 se faltar memória.
+ *
+ * - `SPLITTER_PREDICT_LUT`: os bits altos da chave (depois de subtrair a
+ *   menor chave de P) indexam uma tabela com ~2 baldes por partição; cada
+ *   balde guarda a primeira posição de P que cai nele, e a resposta fica
+ *   entre o início do balde e o do seguinte.
+ * - `SPLITTER_PREDICT_RMI`: uma reta escolhe a folha (uma a cada
+ *   SPLITTER_RMI_LEAF_KEYS partições) e a reta da folha prevê a posição; os
+ *   erros máximos de cada folha, medidos na construção, limitam a janela.
+ * - `SPLITTER_PREDICT_AUTO`: o modelo de menor janela.
+ *
+ * A janela é buscada em uma cópia de P, então o resultado é sempre o mesmo
+ * da árvore. A escolha vale para as próximas `splitter_index_build`, que
+ * refazem o modelo (e voltam para a árvore se o erro for grande demais);
+ * `index->model` e `index->window` dizem o que está em uso.
+ */
+int splitter_index_set_predict(splitter_index_t *index, splitter_predict_t predict);
+
+/**
+ * @brief Nome da previsão em uso ("tree", "lut" ou "rmi").
+ */
+const char *splitter_index_predict_name(const splitter_index_t *index);
+
+/**
+ * @brief Nome da implementação em uso ("scalar", "sse4.2", "avx2" ou "avx512").
+ */
+const char *splitter_index_isa_name(const splitter_index_t *index);
+
+/**
+ * @brief Libera o índice.
+ *
+ * @param index Índice a ser liberado (pode ser NULL).
+ */
+void splitter_index_destroy(splitter_index_t *index);
+
+/**
+ * @brief Índice da partição de `value`.
+ *
+ * @return int Mesmo resultado de `binary_search_partition(P, np, value)`:
+ *             a quantidade de elementos de P menores ou iguais a `value`.
+ */
+static inline int splitter_index_search(const splitter_index_t *index, long long value)
+{
+    return index->search(index, value);
+}
+
+/**
+ * @brief Índices das partições de `count` chaves, em grupos intercalados.
+ *
+ * @param index Índice.
+ * @param values Chaves a classificar.
+ * @param count Número de chaves.
+ * @param out Destino (count posições): out[i] = splitter_index_search(index, values[i]).
+ *
+ * As chaves descem a árvore em grupos de SPLITTER_BATCH, um nível por vez
+ * para o grupo todo, com prefetch do próximo nó de cada chave. Com uma
+ * árvore maior que a L1/L2 as faltas de cache do grupo ficam em voo ao
+ * mesmo tempo; com árvores pequenas a busca de uma chave por vez é melhor.
+ */
+static inline void splitter_index_search_batch(const splitter_index_t *index, const long long *values, int count,
+                                               int *out)
+{
+    index->search_batch(index, values, count, out);
+}
+
+#endif // SPLITTER_INDEX_H
@@ -0,0 +1,141 @@
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "thread_pool.h"
+
+typedef struct
+{
+    thread_pool_t *pool;
+    int id;
+} worker_arg_t;
+
+static void *thread_pool_worker(void *arg)
+{
+    worker_arg_t *w = (worker_arg_t *)arg;
+    thread_pool_t *pool = w->pool;
+    int id = w->id;
+    unsigned long seen = 0;
+
+    free(w);
+
+    for (;;)
+    {
+        pthread_mutex_lock(&pool->mutex);
+
+        // Estaciona até uma nova rodada (ou encerramento)
+        while (pool->generation == seen && !pool->shutdown)
+        {
+            pthread_cond_wait(&pool->cond_start, &pool->mutex);
+        }
+
+        if (pool->shutdown)
+        {
+            pthread_mutex_unlock(&pool->mutex);
+            return NULL;
+        }
+
+        seen = pool->generation;
+        thread_pool_task_t task = pool->task;
+        void *task_arg = pool->args + (size_t)id * pool->arg_size;
+        pthread_mutex_unlock(&pool->mutex);
+
+        task(task_arg);
+
+        // Último worker a terminar acorda quem chamou `thread_pool_run`
+        pthread_mutex_lock(&pool->mutex);
+        if (--pool->pending == 0)
+        {
+            pthread_cond_signal(&pool->cond_done);
+        }
+        pthread_mutex_unlock(&pool->mutex);
+    }
+}
+
+thread_pool_t *thread_pool_create(int nThreads)
+{
+    if (nThreads <= 0)
+    {
+        return NULL; // Número de threads inválido
+    }
+
+    thread_pool_t *pool = (thread_pool_t *)calloc(1, sizeof(thread_pool_t));
+    if (pool == NULL)
+    {
+        return NULL;
+    }
+
+    pool->threads = (pthread_t *)malloc(nThreads * sizeof(pthread_t));
+    if (pool->threads == NULL)
+    {
+        free(pool);
+        return NULL;
+    }
+
+    pool->nThreads = nThreads;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->cond_start, NULL);
+    pthread_cond_init(&pool->cond_done, NULL);
+
+    for (int t = 0; t < nThreads; t++)
+    {
+        worker_arg_t *w = (worker_arg_t *)malloc(sizeof(worker_arg_t));
+        if (w != NULL)
+        {
+            w->pool = pool;
+            w->id = t;
+        }
+
+        if (w == NULL || pthread_create(&pool->threads[t], NULL, thread_pool_worker, w) != 0)
+        {
+            free(w);
+
+            // Encerra os workers já criados
+            pool->nThreads = t;
+            thread_pool_destroy(pool);
+            return NULL;
+        }
+    }
+
+    return pool;
+}
+
+void thread_pool_run(thread_pool_t *pool, thread_pool_task_t task, void *args, size_t arg_size)
+{
+    pthread_mutex_lock(&pool->mutex);
+    pool->task = task;
+    pool->args = (char *)args;
+    pool->arg_size = arg_size;
+    pool->pending = pool->nThreads;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->cond_start);
+
+    while (pool->pending > 0)
+    {
+        pthread_cond_wait(&pool->cond_done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+void thread_pool_destroy(thread_pool_t *pool)
+{
+    if (pool == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->cond_start);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (int t = 0; t < pool->nThreads; t++)
+    {
+        pthread_join(pool->threads[t], NULL);
+    }
+
+    pthread_cond_destroy(&pool->cond_start);
+    pthread_cond_destroy(&pool->cond_done);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->threads);
+    free(pool);
+}
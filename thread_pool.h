@@ -0,0 +1,67 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+/**
+ * @brief Tipo da tarefa executada pelos workers do pool.
+ *
+ * Mesma assinatura usada por `pthread_create`, para que as funções de thread
+ * já existentes (ex.: `thread_count_partition`) possam ser reaproveitadas.
+ */
+typedef void *(*thread_pool_task_t)(void *arg);
+
+/**
+ * @brief Pool de threads de vida longa.
+ *
+ * Os workers são criados uma única vez e ficam estacionados em uma variável
+ * de condição entre as chamadas de `thread_pool_run`.
+ */
+typedef struct
+{
+    int nThreads;               // Número de workers.
+    pthread_t *threads;         // Identificadores dos workers.
+    pthread_mutex_t mutex;      // Protege todos os campos abaixo.
+    pthread_cond_t cond_start;  // Sinaliza uma nova rodada de trabalho.
+    pthread_cond_t cond_done;   // Sinaliza o fim da rodada atual.
+    unsigned long generation;   // Contador de rodadas (evita despertares espúrios).
+    int pending;                // Workers que ainda não terminaram a rodada atual.
+    int shutdown;               // Indica que os workers devem encerrar.
+    thread_pool_task_t task;    // Tarefa da rodada atual.
+    char *args;                 // Vetor de argumentos (um por worker).
+    size_t arg_size;            // Tamanho em bytes de cada argumento.
+} thread_pool_t;
+
+/**
+ * @brief Cria um pool com `nThreads` workers estacionados.
+ *
+ * @param nThreads Número de workers.
+ * @return thread_pool_t* Ponteiro para o pool ou NULL em caso de falha.
+ *
+ * O pool retornado deve ser liberado com `thread_pool_destroy`.
+ */
+thread_pool_t *thread_pool_create(int nThreads);
+
+/**
+ * @brief Executa `task` em todos os workers e espera o término de todos.
+ *
+ * @param pool Pool de threads.
+ * @param task Função executada por cada worker.
+ * @param args Vetor contíguo com `pool->nThreads` argumentos.
+ * @param arg_size Tamanho em bytes de cada argumento.
+ *
+ * O worker `t` recebe `(char *)args + t * arg_size`. Como todos os workers
+ * executam a rodada ao mesmo tempo, a tarefa pode usar barreiras de
+ * `pool->nThreads` participantes.
+ */
+void thread_pool_run(thread_pool_t *pool, thread_pool_task_t task, void *args, size_t arg_size);
+
+/**
+ * @brief Encerra os workers e libera o pool.
+ *
+ * @param pool Pool a ser destruído (pode ser NULL).
+ */
+void thread_pool_destroy(thread_pool_t *pool);
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,213 @@
+#define _GNU_SOURCE
+#include <sched.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "topology.h"
+
+// Constantes de mbind(2), sem depender da libnuma
+#define TOPO_MPOL_BIND 2
+#define TOPO_MPOL_MF_MOVE (1 << 1)
+#define TOPO_MAX_NODES 1024
+
+// Lê uma lista de CPUs no formato "0-3,8,10-11" (só as CPUs permitidas)
+static int parse_cpulist(const char *text, int *cpus, int max, const cpu_set_t *allowed)
+{
+    int count = 0;
+    const char *p = text;
+
+    while (*p != '\0' && *p != '\n')
+    {
+        char *end;
+        long lo = strtol(p, &end, 10), hi = lo;
+        if (end == p)
+        {
+            break;
+        }
+        if (*end == '-')
+        {
+            p = end + 1;
+            hi = strtol(p, &end, 10);
+        }
+        for (long c = lo; c <= hi && count < max; c++)
+        {
+            if (c < CPU_SETSIZE && CPU_ISSET(c, allowed))
+            {
+                cpus[count++] = (int)c;
+            }
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+    return count;
+}
+
+static int add_node(topology_t *topo, int id, int *cpus, int ncpus)
+{
+    int k = topo->nNodes;
+    int *copy = malloc(ncpus * sizeof(int));
+
+    if (copy == NULL)
+    {
+        return -1;
+    }
+    memcpy(copy, cpus, ncpus * sizeof(int));
+    topo->node_id[k] = id;
+    topo->node_ncpus[k] = ncpus;
+    topo->node_cpus[k] = copy;
+    topo->nNodes++;
+    return 0;
+}
+
+topology_t *topology_discover(void)
+{
+    topology_t *topo = calloc(1, sizeof(topology_t));
+    int *cpus = malloc(CPU_SETSIZE * sizeof(int));
+    cpu_set_t allowed;
+
+    if (topo == NULL || cpus == NULL)
+    {
+        free(topo);
+        free(cpus);
+        return NULL;
+    }
+
+    topo->node_id = malloc(TOPO_MAX_NODES * sizeof(int));
+    topo->node_ncpus = malloc(TOPO_MAX_NODES * sizeof(int));
+    topo->node_cpus = calloc(TOPO_MAX_NODES, sizeof(int *));
+    if (topo->node_id == NULL || topo->node_ncpus == NULL || topo->node_cpus == NULL)
+    {
+        free(cpus);
+        topology_destroy(topo);
+        return NULL;
+    }
+
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        CPU_ZERO(&allowed);
+        for (int c = 0; c < CPU_SETSIZE; c++)
+        {
+            CPU_SET(c, &allowed);
+        }
+    }
+
+    // Um nó por diretório nodeN com CPUs permitidas
+    for (int id = 0; id < TOPO_MAX_NODES; id++)
+    {
+        char path[96], text[4096];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", id);
+
+        FILE *f = fopen(path, "r");
+        if (f == NULL)
+        {
+            continue;
+        }
+        int ok = fgets(text, sizeof(text), f) != NULL;
+        fclose(f);
+
+        int ncpus = ok ? parse_cpulist(text, cpus, CPU_SETSIZE, &allowed) : 0;
+        if (ncpus > 0 && add_node(topo, id, cpus, ncpus) != 0)
+        {
+            free(cpus);
+            topology_destroy(topo);
+            return NULL;
+        }
+    }
+
+    // Sem informação de NUMA: um único nó com as CPUs permitidas
+    if (topo->nNodes == 0)
+    {
+        int ncpus = 0;
+        for (int c = 0; c < CPU_SETSIZE; c++)
+        {
+            if (CPU_ISSET(c, &allowed))
+            {
+                cpus[ncpus++] = c;
+            }
+        }
+        if (ncpus == 0 || add_node(topo, 0, cpus, ncpus) != 0)
+        {
+            free(cpus);
+            topology_destroy(topo);
+            return NULL;
+        }
+    }
+
+    free(cpus);
+    return topo;
+}
+
+void topology_destroy(topology_t *topo)
+{
+    if (topo == NULL)
+    {
+        return;
+    }
+
+    if (topo->node_cpus != NULL)
+    {
+        for (int k = 0; k < topo->nNodes; k++)
+        {
+            free(topo->node_cpus[k]);
+        }
+    }
+    free(topo->node_cpus);
+    free(topo->node_ncpus);
+    free(topo->node_id);
+    free(topo);
+}
+
+int topology_thread_cpu(const topology_t *topo, int t, int nThreads, int *node)
+{
+    // Blocos contíguos de threads por nó
+    int k = (int)((long long)t * topo->nNodes / nThreads);
+    int first = (int)(((long long)k * nThreads + topo->nNodes - 1) / topo->nNodes); // Primeira thread do nó k
+
+    *node = k;
+    return topo->node_cpus[k][(t - first) % topo->node_ncpus[k]];
+}
+
+int topology_pin_current_thread(int cpu)
+{
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0 ? 0 : -1;
+}
+
+int topology_bind_memory(const topology_t *topo, void *addr, size_t bytes, int node)
+{
+#if defined(__linux__) && defined(SYS_mbind)
+    long page = sysconf(_SC_PAGESIZE);
+    uintptr_t start = ((uintptr_t)addr + page - 1) & ~(uintptr_t)(page - 1);
+    uintptr_t end = ((uintptr_t)addr + bytes) & ~(uintptr_t)(page - 1);
+    unsigned long mask[TOPO_MAX_NODES / (8 * sizeof(unsigned long))] = {0};
+    int id = topo->node_id[node];
+
+    if (end <= start)
+    {
+        return 0; // Nenhuma página inteira na região
+    }
+
+    mask[id / (8 * sizeof(unsigned long))] |= 1UL << (id % (8 * sizeof(unsigned long)));
+    return syscall(SYS_mbind, (void *)start, end - start, TOPO_MPOL_BIND, mask,
+                   (unsigned long)TOPO_MAX_NODES + 1, TOPO_MPOL_MF_MOVE) == 0
+               ? 0
+               : -1;
+#else
+    (void)topo;
+    (void)addr;
+    (void)bytes;
+    (void)node;
+    return -1;
+#endif
+}
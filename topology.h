@@ -0,0 +1,67 @@
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <stddef.h>
+
+/**
+ * @brief Topologia NUMA da máquina (nós e CPUs de cada nó).
+ *
+ * Lida de /sys/devices/system/node; sem essa informação, a máquina é tratada
+ * como um único nó com as CPUs permitidas ao processo.
+ */
+typedef struct
+{
+    int nNodes;      // Número de nós com CPUs.
+    int *node_id;    // Identificador do sistema de cada nó (tamanho nNodes).
+    int *node_ncpus; // Número de CPUs de cada nó.
+    int **node_cpus; // CPUs de cada nó.
+} topology_t;
+
+/**
+ * @brief Descobre a topologia da máquina.
+ *
+ * @return topology_t* Topologia ou NULL em caso de falha de alocação.
+ *
+ * Deve ser liberada com `topology_destroy`.
+ */
+topology_t *topology_discover(void);
+
+/**
+ * @brief Libera a topologia (pode ser NULL).
+ */
+void topology_destroy(topology_t *topo);
+
+/**
+ * @brief Escolhe o nó e a CPU da thread t entre nThreads.
+ *
+ * @param topo Topologia.
+ * @param t Índice da thread.
+ * @param nThreads Número de threads.
+ * @param node Saída: índice (0 a nNodes - 1) do nó da thread.
+ * @return int CPU em que a thread deve ser fixada.
+ *
+ * As threads são distribuídas em blocos contíguos pelos nós (as primeiras
+ * no nó 0, as seguintes no nó 1, ...), na mesma ordem dos intervalos de
+ * Input, e em rodízio entre as CPUs de cada nó.
+ */
+int topology_thread_cpu(const topology_t *topo, int t, int nThreads, int *node);
+
+/**
+ * @brief Fixa a thread atual em uma CPU.
+ *
+ * @return int 0 em caso de sucesso ou -1 em caso de erro.
+ */
+int topology_pin_current_thread(int cpu);
+
+/**
+ * @brief Move as páginas inteiramente contidas em [addr, addr + bytes) para um nó.
+ *
+ * @param topo Topologia.
+ * @param addr Início da região.
+ * @param bytes Tamanho da região.
+ * @param node Índice (0 a nNodes - 1) do nó de destino.
+ * @return int 0 em caso de sucesso ou -1 se mbind não estiver disponível.
+ */
+int topology_bind_memory(const topology_t *topo, void *addr, size_t bytes, int node);
+
+#endif // TOPOLOGY_H
@@ -1,15 +1,19 @@
 #include "util.h"
+#include "mp_gen.h"
 
-long long *create_vector(int size)
+long long *create_vector(long long size)
 {
     if (size <= 0)
     {
         return NULL; // Tamanho inválido
     }
-    return (long long *)malloc(size * sizeof(long long));
+
+    // Alinhado à linha de cache (aligned_alloc exige tamanho múltiplo do alinhamento)
+    size_t bytes = ((size_t)size * sizeof(long long) + 63) & ~(size_t)63;
+    return (long long *)aligned_alloc(64, bytes);
 }
 
-int *create_pos_vector(int size)
+long long *create_pos_vector(int size)
 {
     if (size <= 0)
     {
@@ -17,7 +21,7 @@ int *create_pos_vector(int size)
     }
 
     // Aloca memória para o vetor Pos
-    int *pos = (int *)malloc(size * sizeof(int));
+    long long *pos = (long long *)malloc(size * sizeof(long long));
     if (pos == NULL)
     {
         return NULL; // Falha na alocação
@@ -40,7 +44,7 @@ void destroy_vector(long long *vec)
     }
 }
 
-void destroy_pos_vector(int *pos)
+void destroy_pos_vector(long long *pos)
 {
     if (pos != NULL)
     {
@@ -48,7 +52,7 @@ void destroy_pos_vector(int *pos)
     }
 }
 
-void print_pos_vector(const int *pos, int size, const char *label)
+void print_pos_vector(const long long *pos, int size, const char *label)
 {
     if (label != NULL)
     {
@@ -58,7 +62,7 @@ void print_pos_vector(const int *pos, int size, const char *label)
     printf("[");
     for (int i = 0; i < size; i++)
     {
-        printf("%d", pos[i]);
+        printf("%lld", pos[i]);
         if (i < size - 1)
         {
             printf(", ");
@@ -67,7 +71,7 @@ void print_pos_vector(const int *pos, int size, const char *label)
     printf("]\n");
 }
 
-void print_vector(const long long *arr, int size, const char *label)
+void print_vector(const long long *arr, long long size, const char *label)
 {
     if (label != NULL)
     {
@@ -75,7 +79,7 @@ void print_vector(const long long *arr, int size, const char *label)
     }
 
     printf("[");
-    for (int i = 0; i < size; i++)
+    for (long long i = 0; i < size; i++)
     {
         printf("%lld", arr[i]);
         if (i < size - 1)
@@ -86,8 +90,12 @@ void print_vector(const long long *arr, int size, const char *label)
     printf("]\n");
 }
 
-long long *generate_random_vector(int size, int is_partition)
+long long *generate_random_vector(long long size, int is_partition)
 {
+    // Cada chamada usa a próxima semente: Input e P diferem, mas as execuções se repetem
+    static unsigned long long calls = 0;
+    unsigned long long seed = __atomic_add_fetch(&calls, 1, __ATOMIC_RELAXED);
+
     if (size <= 0)
     {
         return NULL; // Tamanho inválido
@@ -100,18 +108,14 @@ long long *generate_random_vector(int size, int is_partition)
         return NULL; // Falha na alocação
     }
 
-    // Preencher com números aleatórios
-    for (int i = 0; i < size; i++)
-    {
-        vector[i] = geraAleatorioLL();
-    }
-
-    // Ajustar vetor de partições (se necessário)
-    if (is_partition)
+    // Preencher em paralelo com chaves uniformes de 64 bits; o vetor de
+    // partições é ordenado em paralelo e termina em LLONG_MAX
+    mp_gen_options_t opt = {MP_DIST_UNIFORM, seed, 0, 0, 0, 0};
+    int ret = is_partition ? mp_gen_splitters(vector, size, seed, 0) : mp_gen_fill(vector, size, 0, &opt, 0);
+    if (ret != 0)
     {
-        vector[size - 1] = LLONG_MAX; // Última posição como LLONG_MAX
-        // Ordenar o vetor de partições
-        qsort(vector, size, sizeof(long long), compare_long_long);
+        destroy_vector(vector);
+        return NULL;
     }
 
     return vector;
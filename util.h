@@ -9,21 +9,21 @@
  * @brief Cria um vetor de inteiros longos com o tamanho especificado.
  *
  * @param size Tamanho do vetor a ser criado.
- * @return long long* Ponteiro para o vetor criado ou NULL em caso de falha.
+ * @return long long* Ponteiro para o vetor criado (alinhado a 64 bytes) ou NULL em caso de falha.
  *
  * O vetor retornado deve ser liberado com a função `destroy_vector`.
  */
-long long *create_vector(int size);
+long long *create_vector(long long size);
 
 /**
  * @brief Cria e inicializa o vetor `Pos` com zeros.
  *
  * @param size Tamanho do vetor `Pos` (geralmente `np + 1`).
- * @return int* Ponteiro para o vetor criado ou NULL em caso de falha.
+ * @return long long* Ponteiro para o vetor criado ou NULL em caso de falha.
  *
  * O vetor retornado deve ser liberado com `free` pelo usuário.
  */
-int *create_pos_vector(int size);
+long long *create_pos_vector(int size);
 
 /**
  * @brief Libera a memória alocada para um vetor.
@@ -36,7 +36,7 @@ void destroy_vector(long long *vec);
  * @brief Libera a memória alocada para o vetor `Pos`.
  * @param pos Ponteiro para o vetor `Pos` a ser liberado.
  */
-void destroy_pos_vector(int *pos);
+void destroy_pos_vector(long long *pos);
 
 /**
  * @brief Imprime os elementos do vetor `Pos`.
@@ -44,7 +44,7 @@ void destroy_pos_vector(int *pos);
  * @param size Tamanho do vetor `Pos`.
  * @param label Rótulo opcional para identificar o vetor na saída.
  */
-void print_pos_vector(const int *pos, int size, const char *label);
+void print_pos_vector(const long long *pos, int size, const char *label);
 
 /**
  * @brief Imprime os elementos de um vetor de inteiros longos.
@@ -53,7 +53,7 @@ void print_pos_vector(const int *pos, int size, const char *label);
  * @param size Número de elementos no vetor.
  * @param label Rótulo opcional para identificar o vetor na saída.
  */
-void print_vector(const long long *arr, int size, const char *label);
+void print_vector(const long long *arr, long long size, const char *label);
 
 /**
  * @brief Gera um vetor aleatório de inteiros longos.
@@ -65,13 +65,21 @@ void print_vector(const long long *arr, int size, const char *label);
  *                          e preenche a última posição com LLONG_MAX.
  * @return long long* Ponteiro para o vetor gerado ou NULL em caso de falha.
  *
+ * As chaves são uniformes em todo o intervalo de 64 bits, geradas em
+ * paralelo por `mp_gen_fill` (partições ordenadas com `mp_gen_sort`). A
+ * k-ésima chamada do processo usa a semente k, então os vetores são os mesmos
+ * a cada execução, com qualquer número de CPUs.
+ *
  * O vetor retornado deve ser liberado pelo usuário com `destroy_vector`.
  */
-long long *generate_random_vector(int size, int is_partition);
+long long *generate_random_vector(long long size, int is_partition);
 
 /**
  * @brief Função auxiliar para gerar números aleatórios longos.
  *
+ * Usa `rand()` (sequencial, não thread-safe, cerca de 2^31 * 100 valores);
+ * para vetores grandes, prefira `mp_gen_fill`.
+ *
  * @return long long Número aleatório gerado.
  */
 long long geraAleatorioLL();